@@ -1,30 +1,65 @@
 #include "client_manager/client_manager.hpp"
 
+#include <algorithm>
+
 namespace nutc {
 namespace manager {
 
-inline bool
-ClientManager::user_exists(const std::string& uid) const
+std::optional<client_id>
+ClientManager::get_client_id(const std::string& uid) const
 {
-    return clients.find(uid) != clients.end();
+    auto client = client_ids.find(uid);
+    if (client == client_ids.end())
+        return std::nullopt;
+    return client->second;
 }
 
-inline bool
-ClientManager::user_holds_stock(const std::string& uid, const std::string& ticker) const
+std::optional<ticker_id>
+ClientManager::find_ticker_id(const std::string& ticker) const
 {
-    if (!user_exists(uid)) [[unlikely]]
-        return false;
+    auto id = ticker_ids.find(ticker);
+    if (id == ticker_ids.end())
+        return std::nullopt;
+    return id->second;
+}
+
+ticker_id
+ClientManager::get_ticker_id(const std::string& ticker)
+{
+    auto existing = ticker_ids.find(ticker);
+    if (existing != ticker_ids.end()) [[likely]]
+        return existing->second;
+
+    auto id = static_cast<ticker_id>(ticker_ids.size());
+    ticker_ids.emplace(ticker, id);
+    marks.emplace_back(0.0f);
+    if (id < holdings_stride)
+        return id;
 
-    return clients.at(uid).holdings.find(ticker) != clients.at(uid).holdings.end();
+    // Rows are full; double the stride and move every row over
+    size_t new_stride = holdings_stride * 2;
+    std::vector<float> restrided(clients.size() * new_stride, 0.0f);
+    for (size_t client = 0; client < clients.size(); client++) {
+        auto row = holdings.begin() + static_cast<ptrdiff_t>(client * holdings_stride);
+        std::copy(
+            row, row + static_cast<ptrdiff_t>(holdings_stride),
+            restrided.begin() + static_cast<ptrdiff_t>(client * new_stride)
+        );
+    }
+    holdings = std::move(restrided);
+    holdings_stride = new_stride;
+    return id;
 }
 
 float
 ClientManager::get_holdings(const std::string& uid, const std::string& ticker) const
 {
-    if (!user_holds_stock(uid, ticker))
+    auto client = get_client_id(uid);
+    auto ticker_index = find_ticker_id(ticker);
+    if (!client.has_value() || !ticker_index.has_value())
         return 0.0f;
 
-    return clients.at(uid).holdings.at(ticker);
+    return get_holdings(client.value(), ticker_index.value());
 }
 
 void
@@ -32,24 +67,70 @@ ClientManager::modify_holdings(
     const std::string& uid, const std::string& ticker, float change_in_holdings
 )
 {
-    if (!user_exists(uid))
+    auto client = get_client_id(uid);
+    if (!client.has_value())
         return;
 
-    if (!user_holds_stock(uid, ticker)) {
-        clients[uid].holdings[ticker] = change_in_holdings;
-        return;
-    }
-
-    clients[uid].holdings[ticker] += change_in_holdings;
+    modify_holdings(client.value(), get_ticker_id(ticker), change_in_holdings);
 }
 
 std::optional<messages::SIDE>
 ClientManager::validate_match(const messages::Match& match) const
+{
+    return validate_match(
+        match, get_client_id(match.buyer_uid), get_client_id(match.seller_uid),
+        find_ticker_id(match.ticker)
+    );
+}
+
+std::optional<messages::SIDE>
+ClientManager::validate_match(
+    const messages::Match& match, std::optional<client_id> buyer,
+    std::optional<client_id> seller, std::optional<ticker_id> ticker
+) const
+{
+    lock_pair(buyer, seller);
+    auto failure = check_match(match, buyer, seller, ticker);
+    unlock_pair(buyer, seller);
+    return failure;
+}
+
+std::optional<messages::SIDE>
+ClientManager::settle_match(
+    const messages::Match& match, std::optional<client_id> buyer,
+    std::optional<client_id> seller, ticker_id ticker
+)
+{
+    lock_pair(buyer, seller);
+    auto failure = check_match(match, buyer, seller, ticker);
+    if (!failure.has_value()) [[likely]] {
+        float trade_value = match.quantity * match.price;
+        if (buyer.has_value()) {
+            apply_capital(buyer.value(), -trade_value);
+            apply_holdings(buyer.value(), ticker, match.quantity);
+        }
+        if (seller.has_value()) {
+            apply_capital(seller.value(), trade_value);
+            apply_holdings(seller.value(), ticker, -match.quantity);
+        }
+    }
+    unlock_pair(buyer, seller);
+    return failure;
+}
+
+std::optional<messages::SIDE>
+ClientManager::check_match(
+    const messages::Match& match, std::optional<client_id> buyer,
+    std::optional<client_id> seller, std::optional<ticker_id> ticker
+) const
 {
     float trade_value = match.price * match.quantity;
-    bool insufficient_capital = get_capital(match.buyer_uid) - trade_value < 0;
-    bool insufficient_holdings =
-        get_holdings(match.seller_uid, match.ticker) - match.quantity < 0;
+    float buyer_capital = buyer.has_value() ? capital_of(buyer.value()) : 0.0f;
+    float seller_holdings = seller.has_value() && ticker.has_value()
+                                ? holdings_of(seller.value(), ticker.value())
+                                : 0.0f;
+    bool insufficient_capital = buyer_capital - trade_value < 0;
+    bool insufficient_holdings = seller_holdings - match.quantity < 0;
 
     if (insufficient_capital) [[unlikely]]
         return messages::SIDE::BUY;
@@ -60,6 +141,39 @@ ClientManager::validate_match(const messages::Match& match) const
     return std::nullopt;
 }
 
+void
+ClientManager::lock_pair(
+    std::optional<client_id> first, std::optional<client_id> second
+) const
+{
+    concurrency::Spinlock* low = first.has_value() ? &lock_for(first.value()) : nullptr;
+    concurrency::Spinlock* high =
+        second.has_value() ? &lock_for(second.value()) : nullptr;
+    if (low == high)
+        high = nullptr;
+    if (low != nullptr && high != nullptr && high < low)
+        std::swap(low, high);
+
+    if (low != nullptr)
+        low->lock();
+    if (high != nullptr)
+        high->lock();
+}
+
+void
+ClientManager::unlock_pair(
+    std::optional<client_id> first, std::optional<client_id> second
+) const
+{
+    concurrency::Spinlock* low = first.has_value() ? &lock_for(first.value()) : nullptr;
+    concurrency::Spinlock* high =
+        second.has_value() ? &lock_for(second.value()) : nullptr;
+    if (low != nullptr)
+        low->unlock();
+    if (high != nullptr && high != low)
+        high->unlock();
+}
+
 void
 ClientManager::initialize_from_firebase(const glz::json_t::object_t& users)
 {
@@ -70,49 +184,177 @@ ClientManager::initialize_from_firebase(const glz::json_t::object_t& users)
 void
 ClientManager::add_client(const std::string& uid, float capital, bool active)
 {
-    clients[uid] = Client{uid, active, capital, {}};
+    // Re-adding a client resets its account but keeps its id
+    auto existing = get_client_id(uid);
+    if (existing.has_value()) {
+        set_active(existing.value(), active);
+        clients[existing.value()].capital_remaining = capital;
+        portfolio_values[existing.value()] = capital;
+        auto row = holdings.begin()
+                   + static_cast<ptrdiff_t>(holdings_index(existing.value(), 0));
+        std::fill(row, row + static_cast<ptrdiff_t>(holdings_stride), 0.0f);
+        return;
+    }
+
+    auto client = static_cast<client_id>(clients.size());
+    client_ids.emplace(uid, client);
+    clients.push_back(Client{uid, false, capital});
+    roster_slots.push_back(0);
+    portfolio_values.push_back(capital);
+    holdings.resize(clients.size() * holdings_stride, 0.0f);
+    order_counters.push_back(&monitoring::MetricsRegistry::getInstance().counter(
+        "nutc_client_orders_total", "Orders each client sent to the matching engines",
+        monitoring::label("client", uid)
+    ));
+    set_active(client, active);
+}
+
+void
+ClientManager::set_active(client_id client, bool active)
+{
+    if (clients[client].active == active)
+        return;
+    clients[client].active = active;
+
+    if (active) {
+        roster_slots[client] = active_uids.size();
+        active_uids.push_back(clients[client].uid);
+        active_clients_gauge.set(static_cast<double>(active_uids.size()));
+        return;
+    }
+
+    // Swap the last active client into the freed slot
+    size_t slot = roster_slots[client];
+    if (slot != active_uids.size() - 1) {
+        active_uids[slot] = std::move(active_uids.back());
+        roster_slots[get_client_id(active_uids[slot]).value()] = slot;
+    }
+    active_uids.pop_back();
+    active_clients_gauge.set(static_cast<double>(active_uids.size()));
 }
 
 void
 ClientManager::modify_capital(const std::string& uid, float change_in_capital)
 {
-    if (!user_exists(uid))
+    auto client = get_client_id(uid);
+    if (!client.has_value())
         return;
 
-    clients[uid].capital_remaining += change_in_capital;
+    modify_capital(client.value(), change_in_capital);
 }
 
 float
 ClientManager::get_capital(const std::string& uid) const
 {
-    if (!user_exists(uid))
+    auto client = get_client_id(uid);
+    if (!client.has_value())
         return 0.0f;
 
-    return clients.at(uid).capital_remaining;
+    return get_capital(client.value());
 }
 
 void
 ClientManager::set_active(const std::string& uid)
 {
-    if (!user_exists(uid))
+    auto client = get_client_id(uid);
+    if (!client.has_value())
         return;
 
-    clients[uid].active = true;
+    set_active(client.value(), true);
 }
 
-// inefficient but who cares
+void
+ClientManager::set_inactive(const std::string& uid)
+{
+    auto client = get_client_id(uid);
+    if (!client.has_value())
+        return;
+
+    set_active(client.value(), false);
+}
+
+void
+ClientManager::set_mark(ticker_id ticker, float price)
+{
+    double change = static_cast<double>(price) - static_cast<double>(get_mark(ticker));
+    marks[ticker].store(price, std::memory_order_relaxed);
+    if (change == 0.0)
+        return;
+
+    // One stripe at a time, walking the holdings column of the clients it guards. The
+    // column is strided by holdings_stride, so this is a scalar loop; what it saves is
+    // taking each stripe's lock once rather than once per client
+    const float* column = holdings.data() + ticker;
+    double* values = portfolio_values.data();
+    size_t num_clients = clients.size();
+    size_t step = ACCOUNT_LOCK_STRIPES * holdings_stride;
+    for (size_t stripe = 0; stripe < ACCOUNT_LOCK_STRIPES && stripe < num_clients;
+         stripe++) {
+        std::lock_guard guard(account_locks[stripe]);
+        const float* position = column + stripe * holdings_stride;
+        for (size_t client = stripe; client < num_clients;
+             client += ACCOUNT_LOCK_STRIPES, position += step) {
+            values[client] += static_cast<double>(*position) * change;
+        }
+    }
+}
+
+double
+ClientManager::compute_portfolio_value(client_id client) const
+{
+    double value = capital_of(client);
+    for (ticker_id ticker = 0; ticker < marks.size(); ticker++) {
+        value += static_cast<double>(holdings_of(client, ticker))
+                 * static_cast<double>(get_mark(ticker));
+    }
+    return value;
+}
+
+void
+ClientManager::revalue_all()
+{
+    for (client_id client = 0; client < clients.size(); client++) {
+        std::lock_guard guard(lock_for(client));
+        portfolio_values[client] = compute_portfolio_value(client);
+    }
+}
+
+std::vector<Standing>
+ClientManager::get_leaderboard(size_t k) const
+{
+    // Copy each account under its lock, then rank the copies
+    std::vector<Standing> ranked;
+    ranked.reserve(active_uids.size());
+    for (client_id client = 0; client < clients.size(); client++) {
+        if (!clients[client].active)
+            continue;
+        std::lock_guard guard(lock_for(client));
+        ranked.push_back(Standing{
+            clients[client].uid, portfolio_values[client], capital_of(client)
+        });
+    }
+
+    k = std::min(k, ranked.size());
+    std::partial_sort(
+        ranked.begin(), ranked.begin() + static_cast<ptrdiff_t>(k), ranked.end(),
+        [](const Standing& lhs, const Standing& rhs) {
+            return lhs.portfolio_value > rhs.portfolio_value;
+        }
+    );
+    ranked.resize(k);
+    return ranked;
+}
+
+// Copies every matching client; use get_active_uids for anything per message
 std::vector<Client>
 ClientManager::get_clients(bool active_status) const
 {
     std::vector<Client> client_vec;
 
-    auto add_client_to_vec = [&client_vec, &active_status](const auto& client) {
+    for (const auto& client : clients) {
         if (client.active == active_status)
             client_vec.push_back(client);
-    };
-
-    for (auto& [_, client] : clients)
-        add_client_to_vec(client);
+    }
 
     return client_vec;
 }
@@ -1,14 +1,22 @@
 #pragma once
 // keep track of active users and account information
 #include "config.h"
+#include "monitoring/metrics.hpp"
+#include "utils/concurrency/spinlock.hpp"
 #include "utils/messages.hpp"
 
 #include <glaze/glaze.hpp>
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
 #include <iostream>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace nutc {
 /**
@@ -17,28 +25,173 @@ namespace nutc {
  */
 namespace manager {
 
+/**
+ * @brief Stable handle to a client; index into the ClientManager's account array
+ */
+using client_id = uint32_t;
+
+/**
+ * @brief Stable handle to a ticker; column in every client's holdings row
+ */
+using ticker_id = uint32_t;
+
 struct Client {
     std::string uid;
     bool active;
     float capital_remaining;
-    std::unordered_map<std::string, float> holdings;
 };
 
-class ClientManager {
-private:
-    std::unordered_map<std::string, Client> clients;
+/**
+ * @brief A client's place on the leaderboard
+ */
+struct Standing {
+    std::string uid;
+    double portfolio_value;
+    float capital_remaining;
+};
 
+/**
+ * @class ClientManager
+ * @brief Accounts stored densely, addressed by client_id and ticker_id
+ *
+ * Clients are never removed, so ids stay valid for the life of the manager. Holdings
+ * are one flat array with a fixed stride per client, so a client's position in a
+ * ticker is a single indexed load once the ids are known. The uid/ticker overloads
+ * resolve ids on every call; hot paths (matching) should resolve once and use ids.
+ *
+ * Every client's portfolio value (capital plus holdings at each ticker's mark) is kept
+ * up to date incrementally: fills adjust the two clients involved, and a mark move
+ * adjusts every client by their position times the change.
+ *
+ * Accounts are guarded by a fixed set of striped spinlocks, so engines for different
+ * tickers may match on different threads: settle_match checks and applies a fill
+ * under the locks of both counterparties, so capital can't go negative however fills
+ * interleave. This requires that
+ *  - every client and ticker is registered before matching goes multi-threaded
+ *    (adding either changes the layout and is not locked)
+ *  - each ticker is matched by one thread at a time
+ * The uid overloads, roster and leaderboard are for the thread that set things up or
+ * for when matching is single-threaded.
+ */
+class ClientManager {
 public:
     void add_client(
         const std::string& uid, float capital = STARTING_CAPITAL, bool active = false
     );
     void initialize_from_firebase(const glz::json_t::object_t& users);
     void set_active(const std::string& uid);
+    void set_inactive(const std::string& uid);
+
+    [[nodiscard]] std::optional<client_id> get_client_id(const std::string& uid) const;
+
+    /**
+     * @brief Counts an order against the client's exported activity
+     */
+    void
+    record_order(client_id client)
+    {
+        order_counters[client]->inc();
+    }
+
+    /**
+     * @brief Finds the id of a ticker, assigning one if it was never seen before
+     */
+    ticker_id get_ticker_id(const std::string& ticker);
+    [[nodiscard]] std::optional<ticker_id> find_ticker_id(const std::string& ticker
+    ) const;
+
+    /**
+     * @brief Number of clients ever added; every id below this is valid
+     */
+    [[nodiscard]] size_t
+    get_num_clients() const
+    {
+        return clients.size();
+    }
+
+    [[nodiscard]] const Client&
+    get_client(client_id client) const
+    {
+        return clients[client];
+    }
+
+    [[nodiscard]] float
+    get_capital(client_id client) const
+    {
+        std::lock_guard guard(lock_for(client));
+        return capital_of(client);
+    }
+
+    [[nodiscard]] float
+    get_holdings(client_id client, ticker_id ticker) const
+    {
+        std::lock_guard guard(lock_for(client));
+        return holdings_of(client, ticker);
+    }
+
+    void
+    modify_capital(client_id client, float change_in_capital)
+    {
+        std::lock_guard guard(lock_for(client));
+        apply_capital(client, change_in_capital);
+    }
+
+    void
+    modify_holdings(client_id client, ticker_id ticker, float change_in_holdings)
+    {
+        std::lock_guard guard(lock_for(client));
+        apply_holdings(client, ticker, change_in_holdings);
+    }
+
+    /**
+     * @brief Capital plus every holding valued at its ticker's mark
+     */
+    [[nodiscard]] double
+    get_portfolio_value(client_id client) const
+    {
+        std::lock_guard guard(lock_for(client));
+        return portfolio_values[client];
+    }
+
+    [[nodiscard]] float
+    get_mark(ticker_id ticker) const
+    {
+        return marks[ticker].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Moves a ticker's mark (e.g. to its last trade price) and revalues every
+     * client holding it
+     */
+    void set_mark(ticker_id ticker, float price);
+
+    /**
+     * @brief Recomputes every portfolio value from scratch, discarding the rounding
+     * error incremental updates accumulate
+     */
+    void revalue_all();
+
+    /**
+     * @brief The k active clients with the highest portfolio values, best first
+     */
+    [[nodiscard]] std::vector<Standing> get_leaderboard(size_t k) const;
 
     float get_capital(const std::string& uid) const;
     float get_holdings(const std::string& uid, const std::string& ticker) const;
     std::vector<Client> get_clients(bool active) const;
 
+    /**
+     * @brief uids (and so queue names) of every active client
+     * @details Kept up to date as clients are activated and deactivated, so reading it
+     * costs nothing. Order is unspecified; references are invalidated by any change
+     * in who is active
+     */
+    [[nodiscard]] const std::vector<std::string>&
+    get_active_uids() const
+    {
+        return active_uids;
+    }
+
     void modify_capital(const std::string& uid, float change_in_capital);
     void modify_holdings(
         const std::string& uid, const std::string& ticker, float change_in_holdings
@@ -47,9 +200,111 @@ public:
     [[nodiscard]] std::optional<messages::SIDE>
     validate_match(const messages::Match& match) const;
 
+    /**
+     * @brief validate_match with the buyer, seller and ticker already resolved
+     * @details A missing buyer or seller is one that isn't a client (e.g. SIMULATED)
+     */
+    [[nodiscard]] std::optional<messages::SIDE> validate_match(
+        const messages::Match& match, std::optional<client_id> buyer,
+        std::optional<client_id> seller, std::optional<ticker_id> ticker
+    ) const;
+
+    /**
+     * @brief Validates a match and, if it is valid, moves its capital and holdings
+     * between buyer and seller, all under both accounts' locks
+     * @return The side that can't cover the match, if any; nothing is applied then
+     */
+    std::optional<messages::SIDE> settle_match(
+        const messages::Match& match, std::optional<client_id> buyer,
+        std::optional<client_id> seller, ticker_id ticker
+    );
+
 private:
-    bool user_exists(const std::string& uid) const;
-    bool user_holds_stock(const std::string& uid, const std::string& ticker) const;
+    // Tickers a holdings row has room for before the array is restrided
+    static constexpr size_t INITIAL_TICKER_SLOTS = 8;
+
+    [[nodiscard]] size_t
+    holdings_index(client_id client, ticker_id ticker) const
+    {
+        return static_cast<size_t>(client) * holdings_stride + ticker;
+    }
+
+    // Each account maps to one of these; a power of two so the mapping is a mask
+    static constexpr size_t ACCOUNT_LOCK_STRIPES = 64;
+
+    void set_active(client_id client, bool active);
+    [[nodiscard]] double compute_portfolio_value(client_id client) const;
+
+    [[nodiscard]] concurrency::Spinlock&
+    lock_for(client_id client) const
+    {
+        return account_locks[client & (ACCOUNT_LOCK_STRIPES - 1)];
+    }
+
+    // Lock both accounts' stripes, each once, lowest first so two settlements can't
+    // deadlock
+    void lock_pair(std::optional<client_id> first, std::optional<client_id> second) const;
+    void unlock_pair(std::optional<client_id> first, std::optional<client_id> second)
+        const;
+
+    // Unlocked accessors; callers hold the account's stripe
+    [[nodiscard]] float
+    capital_of(client_id client) const
+    {
+        return clients[client].capital_remaining;
+    }
+
+    [[nodiscard]] float
+    holdings_of(client_id client, ticker_id ticker) const
+    {
+        return holdings[holdings_index(client, ticker)];
+    }
+
+    void
+    apply_capital(client_id client, float change_in_capital)
+    {
+        clients[client].capital_remaining += change_in_capital;
+        portfolio_values[client] += change_in_capital;
+    }
+
+    void
+    apply_holdings(client_id client, ticker_id ticker, float change_in_holdings)
+    {
+        holdings[holdings_index(client, ticker)] += change_in_holdings;
+        portfolio_values[client] += static_cast<double>(change_in_holdings)
+                                    * static_cast<double>(get_mark(ticker));
+    }
+
+    [[nodiscard]] std::optional<messages::SIDE> check_match(
+        const messages::Match& match, std::optional<client_id> buyer,
+        std::optional<client_id> seller, std::optional<ticker_id> ticker
+    ) const;
+
+    std::vector<Client> clients;
+    std::unordered_map<std::string, client_id> client_ids;
+    std::unordered_map<std::string, ticker_id> ticker_ids;
+
+    // clients.size() rows of holdings_stride floats
+    std::vector<float> holdings;
+    size_t holdings_stride = INITIAL_TICKER_SLOTS;
+
+    // Indexed by ticker_id; 0 until the ticker first trades. Each is written by the
+    // thread matching its ticker and read by any thread revaluing a client. A deque,
+    // since atomics can't be moved
+    std::deque<std::atomic<float>> marks;
+    // Indexed by client_id. Double so a long run of small updates doesn't drift far
+    std::vector<double> portfolio_values;
+
+    mutable std::array<concurrency::Spinlock, ACCOUNT_LOCK_STRIPES> account_locks;
+
+    // Active roster; roster_slots[id] is the client's index in it while active
+    std::vector<std::string> active_uids;
+    std::vector<size_t> roster_slots;
+
+    // Indexed by client_id; owned by the MetricsRegistry
+    std::vector<monitoring::Counter*> order_counters;
+    monitoring::Gauge& active_clients_gauge = monitoring::MetricsRegistry::getInstance(
+    ).gauge("nutc_active_clients", "Clients currently trading");
 };
 
 } // namespace manager
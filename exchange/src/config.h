@@ -2,14 +2,111 @@
 #define STARTING_CAPITAL 100000
 #define DEBUG_NUM_USERS 2
 
-#define CLIENT_WAIT_SECS 10
+// trading starts once every client is ready or this long after spawning, whichever is
+// first; clients that are ready later join with a book snapshot
+#define CLIENT_READY_TIMEOUT_SECS 30
+
+// client spawning
+#define SPAWN_THREADS    8 // clients exec'd concurrently without --zygote
+#define ZYGOTE_REPORT_FD 3 // zygote reports pids here; must match the wrapper's config.h
+// clients sharing one wrapper process (and AMQP connection) without --zygote; each
+// process is isolated as a whole, under its first client's uid
+#define CLIENTS_PER_HOST 1
+// start wrappers with --conflate: slow algos get only the latest orderbook update for
+// each price level instead of working through a backlog
+#define CONFLATE_CLIENT_UPDATES false
+// start wrappers with --native: algos uploaded as shared objects are loaded and run as
+// native code, in the wrapper's process and without Python's checks
+#define ALLOW_NATIVE_STRATEGIES false
+
+// client isolation: a cgroup v2 group per client, or nice + rlimit where cgroups
+// can't be delegated
+#define CLIENT_CPU_QUOTA          0.5 // cores
+#define CLIENT_MEMORY_LIMIT_MB    1024
+#define CLIENT_NICE               10
+#define EXCHANGE_RESERVED_CORES   4   // one per pipeline stage, clients kept off
+#define CLIENT_USAGE_REPORT_SIZE  10  // heaviest clients listed in each usage report
+#define CLIENT_USAGE_INTERVAL_SECS 30
+
+// client supervision: exited clients are reaped and deactivated, then restarted with
+// exponential backoff; 0 restarts disables restarting
+#define CLIENT_MAX_RESTARTS           3
+#define CLIENT_RESTART_BACKOFF_MS     1000  // doubles with each restart of a client
+#define CLIENT_RESTART_BACKOFF_MAX_MS 30000
+#define SUPERVISOR_POLL_MS            100   // waitpid polling without pidfd support
+
+// shared memory order ingress (co-located clients)
+#define SHM_ORDER_RING_PREFIX  "/nutc_orders_"
+#define SHM_ORDER_RING_SLOTS   1024 // must be a power of two
+#define SHM_ORDER_SLOT_PAYLOAD 244  // slot is 256 bytes including its header
+
+// how long a single ingress poll may block before the caller regains control
+#define INGRESS_POLL_TIMEOUT_US 1000
+
+// shared memory market data broadcast (co-located clients)
+#define SHM_MARKET_DATA_RING         "/nutc_market_data"
+#define SHM_MARKET_DATA_SLOTS        65536 // must be a power of two
+#define SHM_MARKET_DATA_UID_SIZE     48    // uid a message is withheld from
+#define SHM_MARKET_DATA_SLOT_PAYLOAD 192   // slot is 256 bytes including its header
+
+// staged pipeline (--pipeline)
+#define PIPELINE_RING_SLOTS          4096 // per stage, must be a power of two
+#define PIPELINE_STATS_INTERVAL_SECS 10
+
+// exchange-side order rate limits (token buckets), in orders per second
+// the client limit sits above what the wrapper's own limiter lets through
+#define CLIENT_ORDER_RATE  1.0
+#define CLIENT_ORDER_BURST 40.0
+#define TICKER_ORDER_RATE  200.0
+#define TICKER_ORDER_BURST 400.0
+// each SnapshotRequest copies every book, so clients get few of them
+#define SNAPSHOT_REQUEST_RATE  0.2
+#define SNAPSHOT_REQUEST_BURST 2.0
+
+// shared memory state region for external monitors
+#define SHM_STATE_REGION           "/nutc_state"
+#define SHM_STATE_MAX_CLIENTS      1024 // clients past this are left out
+#define SHM_STATE_MAX_TICKERS      16
+#define SHM_STATE_UID_SIZE         48
+#define SHM_STATE_TICKER_SIZE      16
+#define STATE_PUBLISH_INTERVAL_MS  100
+
+// Prometheus metrics, served on 127.0.0.1; 0 disables the endpoint
+#define METRICS_PORT 9464
+
+// trace spans (cmake -DNUTC24_ENABLE_TRACING=ON), per thread
+#define TRACE_RING_EVENTS 65536
+
+// order lifecycle latency histograms
+#define LATENCY_LOG_INTERVAL_SECS  10
+
+// leaderboard snapshots (portfolio values at last trade prices)
+#define LEADERBOARD_SIZE           10
+#define LEADERBOARD_INTERVAL_SECS  5
 
 // logging
 #define LOG_BACKTRACE_SIZE 10
 
+// per-order log lines (log_order) are written for 1 in N orders; 0 compiles them out.
+// Every order is still recorded in the event journal (JSON_LOG_FILE)
+#ifndef ORDER_LOG_SAMPLE_RATE
+#  ifdef NDEBUG
+#    define ORDER_LOG_SAMPLE_RATE 0
+#  else
+#    define ORDER_LOG_SAMPLE_RATE 1
+#  endif
+#endif
+
 #define LOG_DIR            "logs"
 #define LOG_FILE           (LOG_DIR "/app.log")
 #define JSON_LOG_FILE      (LOG_DIR "/structured.log")
+#define LEADERBOARD_FILE   (LOG_DIR "/leaderboard.log")
+#define TRACE_FILE         (LOG_DIR "/trace.json")
+
+// each thread buffers its event journal lines, writing them out once it holds this
+// many bytes or this long after its last write
+#define EVENT_LOG_FLUSH_BYTES 65536
+#define EVENT_LOG_FLUSH_MS    100
 
 #define LOG_FILE_SIZE      (1024 * 1024 / 2) // 512 KB
 #define LOG_BACKUP_COUNT   5
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+namespace nutc {
+/**
+ * @brief Where the time goes between an order arriving and its results going out
+ */
+namespace latency {
+
+/**
+ * @class LatencyHistogram
+ * @brief HDR-style histogram of nanosecond durations with ~3% relative precision
+ *
+ * Values below 64ns get a bucket each; above that every power of two is split into 32
+ * equal buckets, so the bucket count grows with the log of the range rather than the
+ * range. Values past ~18 minutes land in the last bucket.
+ *
+ * Only one thread may record; any thread may read.
+ */
+class LatencyHistogram {
+public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 6;
+    static constexpr uint32_t MAX_VALUE_BITS = 40;
+    static constexpr uint32_t SUB_BUCKETS = 1U << SUB_BUCKET_BITS;
+    static constexpr uint32_t HALF = SUB_BUCKETS / 2;
+    static constexpr uint32_t NUM_BUCKETS =
+        SUB_BUCKETS + (MAX_VALUE_BITS - SUB_BUCKET_BITS) * HALF;
+
+    void
+    record(uint64_t value_ns)
+    {
+        increment(counts[bucket_index(value_ns)]);
+        increment(total);
+        if (value_ns > max_value.load(std::memory_order_relaxed))
+            max_value.store(value_ns, std::memory_order_relaxed);
+        sum.store(
+            sum.load(std::memory_order_relaxed) + value_ns, std::memory_order_relaxed
+        );
+    }
+
+    /**
+     * @brief Not safe while recording
+     */
+    void
+    reset()
+    {
+        for (auto& counter : counts)
+            counter.store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+        sum.store(0, std::memory_order_relaxed);
+        max_value.store(0, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t
+    count() const
+    {
+        return total.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t
+    max() const
+    {
+        return max_value.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t
+    mean() const
+    {
+        uint64_t recorded = count();
+        return recorded == 0 ? 0 : sum.load(std::memory_order_relaxed) / recorded;
+    }
+
+    /**
+     * @brief Upper bound of the bucket holding the given quantile
+     * @param quantile In [0, 1], e.g. 0.99
+     */
+    [[nodiscard]] uint64_t
+    value_at_quantile(double quantile) const
+    {
+        uint64_t recorded = count();
+        if (recorded == 0)
+            return 0;
+
+        auto target = static_cast<uint64_t>(quantile * static_cast<double>(recorded));
+        if (target == 0)
+            target = 1;
+        uint64_t seen = 0;
+        for (uint32_t index = 0; index < NUM_BUCKETS; index++) {
+            seen += counts[index].load(std::memory_order_relaxed);
+            if (seen >= target)
+                return std::min(bucket_upper_bound(index), max());
+        }
+        return max();
+    }
+
+    static constexpr uint32_t
+    bucket_index(uint64_t value)
+    {
+        if (value < SUB_BUCKETS)
+            return static_cast<uint32_t>(value);
+        if (value >= (uint64_t{1} << MAX_VALUE_BITS))
+            return NUM_BUCKETS - 1;
+
+        auto shift = static_cast<uint32_t>(std::bit_width(value)) - SUB_BUCKET_BITS;
+        auto top = static_cast<uint32_t>(value >> shift); // in [HALF, SUB_BUCKETS)
+        return SUB_BUCKETS + (shift - 1) * HALF + (top - HALF);
+    }
+
+    static constexpr uint64_t
+    bucket_upper_bound(uint32_t index)
+    {
+        if (index < SUB_BUCKETS)
+            return index;
+
+        uint32_t shift = (index - SUB_BUCKETS) / HALF + 1;
+        uint64_t top = (index - SUB_BUCKETS) % HALF + HALF;
+        return ((top + 1) << shift) - 1;
+    }
+
+private:
+    // Single writer, so plain load/store is enough
+    static void
+    increment(std::atomic<uint64_t>& counter)
+    {
+        counter.store(
+            counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed
+        );
+    }
+
+    std::array<std::atomic<uint64_t>, NUM_BUCKETS> counts{};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max_value{0};
+};
+
+} // namespace latency
+} // namespace nutc
@@ -0,0 +1,110 @@
+#include "order_latency.hpp"
+
+#include "config.h"
+#include "logging.hpp"
+
+namespace nutc {
+namespace latency {
+
+namespace {
+constexpr const char*
+stage_name(size_t stage)
+{
+    constexpr std::array<const char*, NUM_LATENCY_STAGES> names{
+        "decode", "match", "publish", "total"
+    };
+    return names[stage];
+}
+} // namespace
+
+void
+OrderLatency::configure(const std::vector<std::string>& tickers)
+{
+    for (const auto& ticker : tickers)
+        per_ticker.try_emplace(ticker, std::make_unique<Histograms>());
+}
+
+void
+OrderLatency::reset()
+{
+    per_ticker.clear();
+    for (auto& histogram : overall)
+        histogram.reset();
+}
+
+void
+OrderLatency::record(Histograms& histograms, const OrderTimestamps& timestamps)
+{
+    auto interval = [](uint64_t from, uint64_t to) { return to > from ? to - from : 0; };
+    histograms[static_cast<size_t>(LatencyStage::DECODE)].record(
+        interval(timestamps.received_ns, timestamps.decoded_ns)
+    );
+    histograms[static_cast<size_t>(LatencyStage::MATCH)].record(
+        interval(timestamps.decoded_ns, timestamps.matched_ns)
+    );
+    histograms[static_cast<size_t>(LatencyStage::PUBLISH)].record(
+        interval(timestamps.matched_ns, timestamps.published_ns)
+    );
+    histograms[static_cast<size_t>(LatencyStage::TOTAL)].record(
+        interval(timestamps.received_ns, timestamps.published_ns)
+    );
+}
+
+void
+OrderLatency::record(const OrderTimestamps& timestamps, std::string_view ticker)
+{
+    record(overall, timestamps);
+    auto histograms = per_ticker.find(ticker);
+    if (histograms != per_ticker.end())
+        record(*histograms->second, timestamps);
+}
+
+const LatencyHistogram*
+OrderLatency::get_histogram(LatencyStage stage, std::string_view ticker) const
+{
+    auto histograms = per_ticker.find(ticker);
+    if (histograms == per_ticker.end())
+        return nullptr;
+    return &(*histograms->second)[static_cast<size_t>(stage)];
+}
+
+void
+OrderLatency::log_histograms(std::string_view scope, const Histograms& histograms)
+{
+    for (size_t stage = 0; stage < NUM_LATENCY_STAGES; stage++) {
+        const LatencyHistogram& histogram = histograms[stage];
+        if (histogram.count() == 0)
+            continue;
+
+        log_i(
+            latency,
+            "{} {}: {} orders, mean {}ns, p50 {}ns, p90 {}ns, p99 {}ns, p99.9 {}ns, max "
+            "{}ns",
+            scope, stage_name(stage), histogram.count(), histogram.mean(),
+            histogram.value_at_quantile(0.5), histogram.value_at_quantile(0.9),
+            histogram.value_at_quantile(0.99), histogram.value_at_quantile(0.999),
+            histogram.max()
+        );
+    }
+}
+
+void
+OrderLatency::log_stats() const
+{
+    log_histograms("all", overall);
+    for (const auto& [ticker, histograms] : per_ticker)
+        log_histograms(ticker, *histograms);
+}
+
+void
+OrderLatency::maybe_log_stats(std::chrono::steady_clock::time_point now)
+{
+    if (now < next_log) [[likely]]
+        return;
+    if (next_log != std::chrono::steady_clock::time_point{})
+        log_stats();
+    next_log = now + std::chrono::seconds(LATENCY_LOG_INTERVAL_SECS);
+}
+
+} // namespace latency
+} // namespace nutc
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "latency/latency_histogram.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace nutc {
+namespace latency {
+
+inline uint64_t
+now_ns()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch()
+    )
+                                     .count());
+}
+
+/**
+ * @brief When an order reached each point on its way through the exchange
+ */
+struct OrderTimestamps {
+    // Returned by the ingress transport
+    uint64_t received_ns = 0;
+    // Parsed into a MarketOrder
+    uint64_t decoded_ns = 0;
+    // Matched against its book (includes any queueing before the matching thread)
+    uint64_t matched_ns = 0;
+    // Every resulting message handed to the transports
+    uint64_t published_ns = 0;
+};
+
+enum class LatencyStage { DECODE, MATCH, PUBLISH, TOTAL };
+inline constexpr size_t NUM_LATENCY_STAGES = 4;
+
+/**
+ * @class OrderLatency
+ * @brief Histograms of each step of the order lifecycle, overall and per ticker
+ *
+ * Orders are recorded once they are fully published, by whichever thread publishes
+ * (the consumer thread, or the pipeline's publish stage), which is the only writer.
+ */
+class OrderLatency {
+public:
+    using Histograms = std::array<LatencyHistogram, NUM_LATENCY_STAGES>;
+
+    OrderLatency(const OrderLatency&) = delete;
+    OrderLatency& operator=(const OrderLatency&) = delete;
+    OrderLatency(OrderLatency&&) = delete;
+    OrderLatency& operator=(OrderLatency&&) = delete;
+
+    static OrderLatency&
+    getInstance()
+    {
+        static OrderLatency instance;
+        return instance;
+    }
+
+    /**
+     * @brief Adds per-ticker histograms; must be called before orders are recorded
+     */
+    void configure(const std::vector<std::string>& tickers);
+
+    /**
+     * @brief Drops all histograms
+     */
+    void reset();
+
+    void record(const OrderTimestamps& timestamps, std::string_view ticker);
+
+    [[nodiscard]] const LatencyHistogram&
+    get_histogram(LatencyStage stage) const
+    {
+        return overall[static_cast<size_t>(stage)];
+    }
+
+    /**
+     * @return nullptr if the ticker was not configured
+     */
+    [[nodiscard]] const LatencyHistogram*
+    get_histogram(LatencyStage stage, std::string_view ticker) const;
+
+    /**
+     * @brief Logs percentiles of every stage, overall and per ticker
+     */
+    void log_stats() const;
+
+    /**
+     * @brief log_stats, at most once per LATENCY_LOG_INTERVAL_SECS
+     * @details For the single-threaded consumer loop, which has no other timer
+     */
+    void maybe_log_stats(
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()
+    );
+
+private:
+    OrderLatency() = default;
+
+    struct StringHash {
+        using is_transparent = void;
+
+        size_t
+        operator()(std::string_view str) const
+        {
+            return std::hash<std::string_view>{}(str);
+        }
+    };
+
+    static void record(Histograms& histograms, const OrderTimestamps& timestamps);
+    static void log_histograms(std::string_view scope, const Histograms& histograms);
+
+    Histograms overall;
+    std::unordered_map<std::string, std::unique_ptr<Histograms>, StringHash, std::equal_to<>>
+        per_ticker;
+    std::chrono::steady_clock::time_point next_log{};
+};
+
+} // namespace latency
+} // namespace nutc
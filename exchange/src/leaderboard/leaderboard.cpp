@@ -0,0 +1,40 @@
+#include "leaderboard.hpp"
+
+#include "logging.hpp"
+
+namespace nutc {
+namespace leaderboard {
+
+SnapshotWriter::SnapshotWriter(
+    const std::string& path, std::chrono::seconds interval, size_t size
+) :
+    output(path, std::ios::app),
+    interval(interval), size(size), next_write(std::chrono::steady_clock::now() + interval)
+{
+    if (!output.is_open())
+        log_e(leaderboard, "Failed to open {}, leaderboard will not be written", path);
+}
+
+void
+SnapshotWriter::write(manager::ClientManager& clients)
+{
+    if (!output.is_open())
+        return;
+
+    clients.revalue_all();
+    LeaderboardSnapshot snapshot{
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()
+        )
+            .count(),
+        clients.get_leaderboard(size)
+    };
+
+    std::string buffer;
+    glz::write<glz::opts{}>(snapshot, buffer);
+    output << buffer << '\n';
+    output.flush();
+}
+
+} // namespace leaderboard
+} // namespace nutc
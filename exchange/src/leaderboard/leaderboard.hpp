@@ -0,0 +1,83 @@
+#pragma once
+
+#include "client_manager/client_manager.hpp"
+
+#include <glaze/glaze.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace nutc {
+/**
+ * @brief Live competition standings, written out as the exchange runs
+ */
+namespace leaderboard {
+
+struct LeaderboardSnapshot {
+    long long timestamp_ns;
+    std::vector<manager::Standing> standings;
+};
+
+/**
+ * @class SnapshotWriter
+ * @brief Appends the top standings to a file at a fixed interval, one JSON object per
+ * line
+ *
+ * Must be driven from the thread that modifies the ClientManager, so every snapshot
+ * is consistent with a single point in the order stream.
+ */
+class SnapshotWriter {
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    SnapshotWriter(const std::string& path, std::chrono::seconds interval, size_t size);
+
+    /**
+     * @brief Writes a snapshot if the interval has elapsed since the last one
+     */
+    void
+    maybe_write(
+        manager::ClientManager& clients,
+        time_point now = std::chrono::steady_clock::now()
+    )
+    {
+        if (now < next_write) [[likely]]
+            return;
+        write(clients);
+        next_write = now + interval;
+    }
+
+    /**
+     * @brief Revalues every client from scratch and writes a snapshot
+     */
+    void write(manager::ClientManager& clients);
+
+private:
+    std::ofstream output;
+    std::chrono::seconds interval;
+    size_t size;
+    time_point next_write;
+};
+
+} // namespace leaderboard
+} // namespace nutc
+
+/// \cond
+template <>
+struct glz::meta<nutc::manager::Standing> {
+    using T = nutc::manager::Standing;
+    static constexpr auto value = object(
+        "uid", &T::uid, "portfolio_value", &T::portfolio_value, "capital_remaining",
+        &T::capital_remaining
+    );
+};
+
+/// \cond
+template <>
+struct glz::meta<nutc::leaderboard::LeaderboardSnapshot> {
+    using T = nutc::leaderboard::LeaderboardSnapshot;
+    static constexpr auto value =
+        object("timestamp_ns", &T::timestamp_ns, "standings", &T::standings);
+};
@@ -79,9 +79,17 @@ CREATE_LOG_CATEGORY(matching);
 CREATE_LOG_CATEGORY(kafka);
 CREATE_LOG_CATEGORY(firebase_fetching);
 CREATE_LOG_CATEGORY(client_spawning);
+CREATE_LOG_CATEGORY(supervision);
 CREATE_LOG_CATEGORY(rabbitmq);
 CREATE_LOG_CATEGORY(dev_mode);
 CREATE_LOG_CATEGORY(events);
+CREATE_LOG_CATEGORY(shared_memory);
+CREATE_LOG_CATEGORY(transport);
+CREATE_LOG_CATEGORY(pipeline);
+CREATE_LOG_CATEGORY(rate_limiting);
+CREATE_LOG_CATEGORY(leaderboard);
+CREATE_LOG_CATEGORY(monitoring);
+CREATE_LOG_CATEGORY(latency);
 
 #undef CREATE_LOG_CATEGORY
 // NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
@@ -116,4 +124,23 @@ CREATE_LOG_CATEGORY(events);
 
 #define log_c(category, ...)                                                           \
     LOG_CRITICAL(nutc::logging::get_##category##_logger(), __VA_ARGS__)
+
+// Info lines about a single order, sampled by its index so an order's lines are kept or
+// dropped together (see ORDER_LOG_SAMPLE_RATE)
+#if ORDER_LOG_SAMPLE_RATE == 0
+// Still type-checked, so the arguments count as used, but never emitted
+#  define log_order(category, order_index, ...)                                       \
+      do {                                                                             \
+          if constexpr (false)                                                         \
+              log_i(category, __VA_ARGS__);                                            \
+      } while (0)
+#elif ORDER_LOG_SAMPLE_RATE == 1
+#  define log_order(category, order_index, ...) log_i(category, __VA_ARGS__)
+#else
+#  define log_order(category, order_index, ...)                                       \
+      do {                                                                             \
+          if ((order_index) % ORDER_LOG_SAMPLE_RATE == 0)                              \
+              log_i(category, __VA_ARGS__);                                            \
+      } while (0)
+#endif
 // NOLINTEND
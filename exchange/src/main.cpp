@@ -1,26 +1,42 @@
 #include "client_manager/client_manager.hpp"
 #include "config.h"
+#include "latency/order_latency.hpp"
 #include "lib.hpp"
 #include "logging.hpp"
 #include "matching/engine/engine.hpp"
+#include "monitoring/metrics_server.hpp"
 #include "networking/firebase/firebase.hpp"
 #include "networking/rabbitmq/rabbitmq.hpp"
+#include "networking/shm/market_data_broadcast/ShmMarketDataBroadcast.hpp"
+#include "networking/shm/order_ingress/ShmOrderIngress.hpp"
+#include "networking/transport/TransportManager.hpp"
+#include "pipeline/pipeline.hpp"
+#include "process_spawning/isolation.hpp"
 #include "process_spawning/spawning.hpp"
+#include "process_spawning/supervisor.hpp"
+#include "rate_limiting/order_throttle.hpp"
+#include "tracing/trace.hpp"
 #include "utils/dev_mode/dev_mode.hpp"
+#include "utils/logger/logger.hpp"
 
 #include <argparse/argparse.hpp>
 
+#include <chrono>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <rabbitmq-c/amqp.h>
+#include <signal.h>
 
 namespace rmq = nutc::rabbitmq;
 
 nutc::manager::ClientManager users;
 nutc::engine_manager::Manager engine_manager;
 
-static std::tuple<bool>
+static std::tuple<bool, bool, bool, bool>
 process_arguments(int argc, const char** argv)
 {
     argparse::ArgumentParser program(
@@ -34,6 +50,27 @@ process_arguments(int argc, const char** argv)
         .implicit_value(true)
         .nargs(0);
 
+    program.add_argument("-S", "--shm")
+        .help("Exchange orders and market data with local clients over shared memory")
+        .action([](const auto& /* unused */) {})
+        .default_value(false)
+        .implicit_value(true)
+        .nargs(0);
+
+    program.add_argument("-P", "--pipeline")
+        .help("Run decode, risk checks, matching and publishing on separate threads")
+        .action([](const auto& /* unused */) {})
+        .default_value(false)
+        .implicit_value(true)
+        .nargs(0);
+
+    program.add_argument("-Z", "--zygote")
+        .help("Fork every client from one wrapper that has already loaded Python")
+        .action([](const auto& /* unused */) {})
+        .default_value(false)
+        .implicit_value(true)
+        .nargs(0);
+
     program.add_argument("-V", "--version")
         .help("prints version information and exits")
         .action([&](const auto& /* unused */) {
@@ -52,24 +89,54 @@ process_arguments(int argc, const char** argv)
         exit(1); // NOLINT(concurrency-*)
     }
 
-    return std::make_tuple(program.get<bool>("--dev"));
+    return std::make_tuple(
+        program.get<bool>("--dev"), program.get<bool>("--shm"),
+        program.get<bool>("--pipeline"), program.get<bool>("--zygote")
+    );
 }
 
+// Runs on its own thread rather than in a signal handler, since logging, writing the
+// trace and removing the client cgroups aren't async-signal-safe
 void
-handle_sigint(int sig)
+handle_sigint()
 {
+    sigset_t sigint;
+    sigemptyset(&sigint);
+    sigaddset(&sigint, SIGINT);
+    int sig = 0;
+    while (sigwait(&sigint, &sig) != 0) {}
+
     log_i(rabbitmq, "Caught SIGINT, closing connection");
+    nutc::rate_limiting::OrderThrottle::getInstance().log_stats();
+    nutc::latency::OrderLatency::getInstance().log_stats();
+    // No restarts once clients start being killed
+    nutc::client::Supervisor::getInstance().stop();
+    auto& isolation = nutc::client::ClientIsolation::getInstance();
+    isolation.log_usage();
+    isolation.release();
+    if constexpr (nutc::tracing::ENABLED)
+        nutc::tracing::Tracer::getInstance().write_chrome_json(TRACE_FILE);
+    nutc::events::Logger::get_logger().flush_all();
     sleep(1);
-    exit(sig);
+    exit(sig); // NOLINT(concurrency-*)
 }
 
 int
 main(int argc, const char** argv)
 {
-    auto [dev_mode] = process_arguments(argc, argv);
+    // Blocked before any thread starts so every thread inherits it, and SIGINT is only
+    // ever taken by handle_sigint
+    sigset_t sigint;
+    sigemptyset(&sigint);
+    sigaddset(&sigint, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &sigint, nullptr);
 
-    // Set up logging
-    nutc::logging::init(quill::LogLevel::TraceL3);
+    auto [dev_mode, use_shm, use_pipeline, use_zygote] = process_arguments(argc, argv);
+
+    // Set up logging; per-order lines are gated separately (ORDER_LOG_SAMPLE_RATE)
+    nutc::logging::init(
+        dev_mode ? quill::LogLevel::TraceL3 : nutc::logging::DEFAULT_LOG_LEVEL
+    );
 
     if (dev_mode) {
         log_t1(main, "Initializing NUTC24 in development mode...");
@@ -77,7 +144,13 @@ main(int argc, const char** argv)
     }
 
     // Initialize signal handler
-    signal(SIGINT, handle_sigint);
+    std::thread(handle_sigint).detach();
+    TRACE_THREAD_NAME("main");
+
+    // Scrapes are served from their own thread for the life of the process
+    nutc::monitoring::MetricsServer metrics_server;
+    if (METRICS_PORT != 0 && !metrics_server.start(METRICS_PORT))
+        log_w(monitoring, "Continuing without a metrics endpoint");
 
     auto& rmq_conn = rmq::RabbitMQConnectionManager::getInstance();
 
@@ -87,15 +160,58 @@ main(int argc, const char** argv)
         return 1;
     }
 
-    int num_clients = nutc::client::initialize(users, dev_mode);
+    // Route client traffic: the broker always, shared memory for local clients
+    auto& transports = nutc::transport::TransportManager::getInstance();
+    auto rmq_transport = std::make_shared<rmq::RabbitMQTransport>();
+    transports.addIngress(rmq_transport);
+    transports.setEgress(rmq_transport);
 
-    engine_manager.add_engine("A");
-    engine_manager.add_engine("B");
-    engine_manager.add_engine("C");
+    std::shared_ptr<nutc::shm::ShmOrderIngress> shm_ingress;
+    if (use_shm) {
+        shm_ingress = std::make_shared<nutc::shm::ShmOrderIngress>();
+        transports.addIngress(shm_ingress);
+
+        auto market_data = nutc::shm::ShmMarketDataBroadcast::create(shm_ingress);
+        if (market_data.has_value()) {
+            transports.setBroadcast(std::make_shared<nutc::shm::ShmMarketDataBroadcast>(
+                std::move(market_data.value())
+            ));
+        }
+    }
+
+    // Clients are limited as they're spawned, and kept off the cores the matching
+    // threads pin themselves to
+    auto& isolation = nutc::client::ClientIsolation::getInstance();
+    isolation.configure(
+        {CLIENT_CPU_QUOTA, static_cast<uint64_t>(CLIENT_MEMORY_LIMIT_MB) * 1024 * 1024},
+        EXCHANGE_RESERVED_CORES
+    );
+
+    // Exited clients are reaped and dropped from the fanout; restarts are exec'd, since
+    // the zygote is gone by then
+    nutc::client::Supervisor::getInstance().start(
+        {CLIENT_MAX_RESTARTS, std::chrono::milliseconds(CLIENT_RESTART_BACKOFF_MS),
+         std::chrono::milliseconds(CLIENT_RESTART_BACKOFF_MAX_MS)},
+        [dev_mode](const nutc::client::ClientLaunch& launch) {
+            return nutc::client::launch_client(launch, dev_mode);
+        }
+    );
+
+    int num_clients = nutc::client::initialize(
+        users, dev_mode, shm_ingress.get(),
+        use_zygote ? nutc::client::SpawnMode::ZYGOTE : nutc::client::SpawnMode::EXEC
+    );
+
+    engine_manager.add_engine("A", users);
+    engine_manager.add_engine("B", users);
+    engine_manager.add_engine("C", users);
 
     // Run exchange
-    rmq::RabbitMQClientManager::waitForClients(users, num_clients);
-    rmq::RabbitMQClientManager::sendStartTime(users, CLIENT_WAIT_SECS);
+    // Trading starts as soon as everyone is ready; stragglers join late
+    rmq::RabbitMQClientManager::waitForClients(
+        users, num_clients, std::chrono::seconds(CLIENT_READY_TIMEOUT_SECS)
+    );
+    rmq::RabbitMQClientManager::sendStartTime(users, 0);
     rmq::RabbitMQOrderHandler::addLiquidityToTicker(
         users, engine_manager, "A", 1000, 100
     );
@@ -105,7 +221,47 @@ main(int argc, const char** argv)
     rmq::RabbitMQOrderHandler::addLiquidityToTicker(
         users, engine_manager, "C", 3000, 300
     );
-    rmq::RabbitMQConsumer::handleIncomingMessages(users, engine_manager);
+
+    // Stragglers included, anyone else is rejected at ingress
+    std::vector<std::string> client_uids;
+    for (bool active : {true, false}) {
+        for (const auto& client : users.get_clients(active))
+            client_uids.push_back(client.uid);
+    }
+    nutc::rate_limiting::OrderThrottle::getInstance().configure(
+        {CLIENT_ORDER_RATE, CLIENT_ORDER_BURST}, {TICKER_ORDER_RATE, TICKER_ORDER_BURST},
+        client_uids, engine_manager.get_tickers()
+    );
+    nutc::latency::OrderLatency::getInstance().configure(engine_manager.get_tickers());
+
+    if (!use_pipeline) {
+        std::thread([&isolation] {
+            while (true) {
+                std::this_thread::sleep_for(
+                    std::chrono::seconds(CLIENT_USAGE_INTERVAL_SECS)
+                );
+                isolation.log_usage();
+            }
+        }).detach();
+        isolation.pin_hot_thread(0);
+        rmq::RabbitMQConsumer::handleIncomingMessages(users, engine_manager);
+        return 0;
+    }
+
+    // Consuming and publishing now happen on different threads
+    if (!rmq_conn.openPublishConnection()) {
+        log_e(rabbitmq, "Failed to open publish connection");
+        return 1;
+    }
+    nutc::pipeline::Pipeline pipeline(users, engine_manager);
+    pipeline.start();
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::seconds(PIPELINE_STATS_INTERVAL_SECS));
+        pipeline.log_stats();
+        nutc::rate_limiting::OrderThrottle::getInstance().log_stats();
+        nutc::latency::OrderLatency::getInstance().log_stats();
+        isolation.log_usage();
+    }
 
     return 0;
 }
@@ -1,5 +1,7 @@
 #include "engine.hpp"
 
+#include "logging.hpp"
+
 #include <algorithm>
 #include <iostream>
 #include <vector>
@@ -7,9 +9,56 @@
 namespace nutc {
 namespace matching {
 
+namespace {
+struct EngineMetrics {
+    monitoring::Counter& orders;
+    monitoring::Counter& rejected_capital;
+    monitoring::Counter& rejected_holdings;
+    monitoring::Counter& matches;
+    monitoring::Counter& failed_settlements;
+};
+
+EngineMetrics&
+engine_metrics()
+{
+    auto& registry = monitoring::MetricsRegistry::getInstance();
+    static EngineMetrics metrics{
+        registry.counter("nutc_orders_total", "Orders received by the matching engines"),
+        registry.counter(
+            "nutc_orders_rejected_total", "Orders rejected by the matching engines",
+            R"(reason="capital")"
+        ),
+        registry.counter(
+            "nutc_orders_rejected_total", "Orders rejected by the matching engines",
+            R"(reason="holdings")"
+        ),
+        registry.counter("nutc_matches_total", "Fills settled between two clients"),
+        registry.counter(
+            "nutc_failed_settlements_total",
+            "Crossed orders dropped because one side could no longer cover the fill"
+        ),
+    };
+    return metrics;
+}
+} // namespace
+
+void
+Engine::bind_metrics(const std::string& ticker)
+{
+    auto& registry = monitoring::MetricsRegistry::getInstance();
+    std::string labels = monitoring::label("ticker", ticker);
+    resting_bids = &registry.gauge(
+        "nutc_resting_orders", "Orders resting in a book", labels + R"(,side="bid")"
+    );
+    resting_asks = &registry.gauge(
+        "nutc_resting_orders", "Orders resting in a book", labels + R"(,side="ask")"
+    );
+}
+
 void
 Engine::add_order_without_matching(MarketOrder order)
 {
+    update_level(order.side, order.price, order.quantity);
     if (order.side == SIDE::BUY) {
         bids.push(order);
     }
@@ -18,16 +67,69 @@ Engine::add_order_without_matching(MarketOrder order)
     }
 }
 
-constexpr ObUpdate
-create_ob_update(const MarketOrder& order, float quantity)
+std::vector<ObUpdate>
+Engine::get_levels(SIDE side, const std::string& ticker) const
 {
-    return ObUpdate{order.ticker, order.side, order.price, quantity};
+    // Read from the level totals; copying the queues would touch every resting order
+    std::vector<ObUpdate> levels;
+    auto add_level = [&](const std::pair<const float, float>& level) {
+        levels.push_back({ticker, side, level.first, level.second, level.second});
+    };
+    if (side == SIDE::BUY) {
+        levels.reserve(bid_levels.size());
+        std::for_each(bid_levels.rbegin(), bid_levels.rend(), add_level);
+    }
+    else {
+        levels.reserve(ask_levels.size());
+        std::for_each(ask_levels.begin(), ask_levels.end(), add_level);
+    }
+    return levels;
 }
 
-void
-add_ob_update(std::vector<ObUpdate>& vec, const MarketOrder& order, float quantity)
+float
+Engine::get_level_quantity(SIDE side, float price) const
 {
-    vec.push_back(create_ob_update(order, quantity));
+    const std::map<float, float>& levels = side == SIDE::BUY ? bid_levels : ask_levels;
+    auto level = levels.find(price);
+    return level == levels.end() ? 0 : level->second;
+}
+
+size_t
+Engine::get_level_count(SIDE side) const
+{
+    return side == SIDE::BUY ? bid_levels.size() : ask_levels.size();
+}
+
+std::optional<std::pair<float, float>>
+Engine::get_best_level(SIDE side) const
+{
+    if (side == SIDE::BUY) {
+        if (bid_levels.empty())
+            return std::nullopt;
+        return *bid_levels.rbegin();
+    }
+    if (ask_levels.empty())
+        return std::nullopt;
+    return *ask_levels.begin();
+}
+
+float
+Engine::update_level(SIDE side, float price, float quantity)
+{
+    std::map<float, float>& levels = side == SIDE::BUY ? bid_levels : ask_levels;
+    auto level = levels.try_emplace(price, 0.0f).first;
+    level->second += quantity;
+    if (level->second > 0 && !messages::is_close_to_zero(level->second))
+        return level->second;
+    levels.erase(level);
+    return 0;
+}
+
+ObUpdate
+Engine::create_ob_update(const MarketOrder& order, float quantity, float level_change)
+{
+    float level_quantity = update_level(order.side, order.price, level_change);
+    return ObUpdate{order.ticker, order.side, order.price, quantity, level_quantity};
 }
 
 std::priority_queue<MarketOrder>&
@@ -38,18 +140,23 @@ Engine::get_orders(SIDE side)
 
 bool
 Engine::insufficient_capital(
-    const MarketOrder& order, const manager::ClientManager& manager
+    const MarketOrder& order, const manager::ClientManager& manager,
+    std::optional<manager::client_id> client
 )
 {
-    float capital = manager.get_capital(order.client_uid);
+    float capital = client.has_value() ? manager.get_capital(client.value()) : 0.0f;
     float order_value = order.price * order.quantity;
     return order.side == SIDE::BUY && order_value > capital;
 }
 
 bool
-insufficient_holdings(const MarketOrder& order, const manager::ClientManager& manager)
+insufficient_holdings(
+    const MarketOrder& order, const manager::ClientManager& manager,
+    std::optional<manager::client_id> client, manager::ticker_id ticker
+)
 {
-    float holdings = manager.get_holdings(order.client_uid, order.ticker);
+    float holdings = client.has_value() ? manager.get_holdings(client.value(), ticker)
+                                        : 0.0f;
     return order.side == SIDE::SELL && order.quantity > holdings;
 }
 
@@ -57,18 +164,43 @@ MatchResult
 Engine::match_order(MarketOrder& order, manager::ClientManager& manager)
 {
     MatchResult result;
+    EngineMetrics& metrics = engine_metrics();
+    metrics.orders.inc();
+    if (resting_bids == nullptr) [[unlikely]]
+        bind_metrics(order.ticker);
+
+    // The journal, not the application log, is the record of every order
+    std::string buf;
+    glz::write<glz::opts{}>(order, buf);
+    events::Logger::get_logger().log_event(events::MESSAGE_TYPE::MARKET_ORDER, buf);
+
+    // Resolve ids once; everything after this is indexed
+    std::optional<manager::client_id> client = manager.get_client_id(order.client_uid);
+    std::optional<manager::ticker_id> ticker_index = manager.find_ticker_id(order.ticker);
+    if (!ticker_index.has_value()) [[unlikely]] {
+        log_w(matching, "Rejecting order for unregistered ticker {}", order.ticker);
+        return result;
+    }
+    manager::ticker_id ticker = ticker_index.value();
+    if (client.has_value())
+        manager.record_order(client.value());
 
-    if (insufficient_capital(order, manager)) {
+    if (insufficient_capital(order, manager, client)) {
+        metrics.rejected_capital.inc();
         return result;
     }
 
-    if (insufficient_holdings(order, manager)) {
+    if (insufficient_holdings(order, manager, client, ticker)) {
+        metrics.rejected_holdings.inc();
         return result;
     }
 
     get_orders(order.side).push(order);
 
-    MatchResult res = attempt_matches(manager, order);
+    MatchResult res = attempt_matches(manager, order, ticker);
+    metrics.matches.inc(res.matches.size());
+    resting_bids->set(static_cast<double>(bids.size()));
+    resting_asks->set(static_cast<double>(asks.size()));
 
     return res;
 }
@@ -109,12 +241,14 @@ Engine::get_aggressive_side(const MarketOrder& order1, const MarketOrder& order2
 
 MatchResult
 Engine::attempt_matches(
-    manager::ClientManager& manager, const MarketOrder& aggressive_order
+    manager::ClientManager& manager, const MarketOrder& aggressive_order,
+    manager::ticker_id ticker
 )
 {
     MatchResult result;
     float aggressive_quantity = aggressive_order.quantity;
     float aggressive_index = aggressive_order.order_index;
+    bool aggressive_dropped = false;
 
     while (bids.size() > 0 && asks.size() > 0 && bids.top().can_match(asks.top())) {
         MarketOrder sell_order = asks.top();
@@ -132,9 +266,21 @@ Engine::attempt_matches(
         Match toMatch = Match{sell_order.ticker, buyer_uid,      seller_uid,
                               aggressive_side,   price_to_match, quantity_to_match};
 
-        std::optional<SIDE> match_failure = manager.validate_match(toMatch);
+        std::optional<manager::client_id> buyer = manager.get_client_id(buyer_uid);
+        std::optional<manager::client_id> seller = manager.get_client_id(seller_uid);
+        // Checked and applied atomically, so fills settling on other threads can't
+        // spend the same capital or holdings
+        std::optional<SIDE> match_failure =
+            manager.settle_match(toMatch, buyer, seller, ticker);
         if (match_failure.has_value()) {
+            engine_metrics().failed_settlements.inc();
             SIDE side = match_failure.value();
+            const MarketOrder& dropped = side == SIDE::BUY ? buy_order : sell_order;
+            // The aggressive order is only counted in its level once it rests
+            if (is_same_value(dropped.order_index, aggressive_index))
+                aggressive_dropped = true;
+            else
+                update_level(dropped.side, dropped.price, -dropped.quantity);
             if (side == SIDE::BUY)
                 bids.pop();
             else
@@ -160,38 +306,49 @@ Engine::attempt_matches(
         bool sell_aggressive = is_same_value(sell_order.order_index, aggressive_index);
         bool buy_aggressive = is_same_value(buy_order.order_index, aggressive_index);
 
+        // A passive order is removed whole, then put back with what's left
+        float buy_before = buy_order.quantity + quantity_to_match;
+        float sell_before = sell_order.quantity + quantity_to_match;
         if (buy_aggressive)
             aggressive_quantity -= quantity_to_match;
         else
-            add_ob_update(result.ob_updates, buy_order, 0);
+            result.ob_updates.push_back(create_ob_update(buy_order, 0, -buy_before));
 
         if (sell_aggressive)
             aggressive_quantity -= quantity_to_match;
         else
-            add_ob_update(result.ob_updates, sell_order, 0);
+            result.ob_updates.push_back(create_ob_update(sell_order, 0, -sell_before));
 
         if (!is_close_to_zero(buy_order.quantity)) {
-            if (!buy_aggressive)
-                add_ob_update(result.ob_updates, buy_order, buy_order.quantity);
+            if (!buy_aggressive) {
+                result.ob_updates.push_back(
+                    create_ob_update(buy_order, buy_order.quantity, buy_order.quantity)
+                );
+            }
             bids.push(buy_order);
         }
 
         if (!is_close_to_zero(sell_order.quantity)) {
-            if (!sell_aggressive)
-                add_ob_update(result.ob_updates, sell_order, sell_order.quantity);
+            if (!sell_aggressive) {
+                result.ob_updates.push_back(create_ob_update(
+                    sell_order, sell_order.quantity, sell_order.quantity
+                ));
+            }
             asks.push(sell_order);
         }
-
-        manager.modify_capital(buyer_uid, -quantity_to_match * price_to_match);
-        manager.modify_capital(seller_uid, quantity_to_match * price_to_match);
-        manager.modify_holdings(seller_uid, buy_order.ticker, -quantity_to_match);
-        manager.modify_holdings(buyer_uid, buy_order.ticker, quantity_to_match);
     }
 
     if (aggressive_quantity > 0) {
-        add_ob_update(result.ob_updates, aggressive_order, aggressive_quantity);
+        result.ob_updates.push_back(create_ob_update(
+            aggressive_order, aggressive_quantity,
+            aggressive_dropped ? 0 : aggressive_quantity
+        ));
     }
 
+    // Mark to the last trade once per order rather than once per fill
+    if (!result.matches.empty())
+        manager.set_mark(ticker, last_sell_price);
+
     return result;
 }
 
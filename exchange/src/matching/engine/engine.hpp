@@ -2,13 +2,16 @@
 
 #include "client_manager/client_manager.hpp"
 #include "logging.hpp"
+#include "monitoring/metrics.hpp"
 #include "utils/messages.hpp"
 #include "utils/logger/logger.hpp"
 
 #include <chrono>
 
+#include <map>
 #include <optional>
 #include <queue>
+#include <utility>
 #include <vector>
 
 using MarketOrder = nutc::messages::MarketOrder;
@@ -45,8 +48,45 @@ public:
 
     void add_order_without_matching(MarketOrder aggressive_order);
 
+    /**
+     * @brief The total resting at each price on one side of the book
+     * @param ticker The ticker the engine trades, set on the returned updates
+     * @return One ObUpdate per price level, ordered from best to worst
+     */
+    std::vector<ObUpdate> get_levels(SIDE side, const std::string& ticker) const;
+
+    /**
+     * @brief Total quantity resting at a price, 0 if none
+     */
+    float get_level_quantity(SIDE side, float price) const;
+
+    /**
+     * @brief Number of price levels on one side of the book
+     */
+    size_t get_level_count(SIDE side) const;
+
+    /**
+     * @brief Best price on one side and the total resting at it, nullopt if empty
+     */
+    std::optional<std::pair<float, float>> get_best_level(SIDE side) const;
+
 private:
     float last_sell_price;
+
+    // Total resting quantity at each price, kept alongside the queues
+    std::map<float, float> bid_levels;
+    std::map<float, float> ask_levels;
+
+    // Adds quantity (negative to remove) to a price level; returns the new total
+    float update_level(SIDE side, float price, float quantity);
+    ObUpdate
+    create_ob_update(const MarketOrder& order, float quantity, float level_change);
+
+    // Resting order gauges for this book; bound to the ticker of the first order
+    monitoring::Gauge* resting_bids = nullptr;
+    monitoring::Gauge* resting_asks = nullptr;
+    void bind_metrics(const std::string& ticker);
+
     static std::string get_client_uid(
         SIDE side, const MarketOrder& aggressive, const MarketOrder& passive
     );
@@ -54,11 +94,14 @@ private:
 
     std::priority_queue<MarketOrder>& get_orders(SIDE side);
 
-    MatchResult
-    attempt_matches(manager::ClientManager& manager, const MarketOrder& aggressive);
+    MatchResult attempt_matches(
+        manager::ClientManager& manager, const MarketOrder& aggressive,
+        manager::ticker_id ticker
+    );
     SIDE get_aggressive_side(const MarketOrder& order1, const MarketOrder& order2);
     bool insufficient_capital(
-        const MarketOrder& order, const manager::ClientManager& manager
+        const MarketOrder& order, const manager::ClientManager& manager,
+        std::optional<manager::client_id> client
     );
 };
 } // namespace matching
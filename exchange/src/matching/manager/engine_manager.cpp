@@ -24,12 +24,23 @@ Manager::add_initial_liquidity(const std::string& ticker, float quantity, float
 }
 
 void
-Manager::add_engine(const std::string& ticker)
+Manager::add_engine(const std::string& ticker, manager::ClientManager& clients)
 {
+    clients.get_ticker_id(ticker);
     if (engines.find(ticker) == engines.end()) {
         engines.emplace(ticker, matching::Engine());
     }
 }
 
+std::vector<std::string>
+Manager::get_tickers() const
+{
+    std::vector<std::string> tickers;
+    tickers.reserve(engines.size());
+    for (const auto& [ticker, engine] : engines)
+        tickers.push_back(ticker);
+    return tickers;
+}
+
 } // namespace engine_manager
 } // namespace nutc
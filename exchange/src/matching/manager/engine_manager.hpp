@@ -3,6 +3,7 @@
 
 #include <optional>
 #include <string>
+#include <vector>
 
 using Engine = nutc::matching::Engine;
 using EngineRef = std::reference_wrapper<nutc::matching::Engine>;
@@ -30,15 +31,20 @@ public:
     /**
      * @brief Adds an engine with the given ticker
      * @param ticker The ticker of the engine to add
-     * @return A reference to the engine with the given ticker
+     * @param clients Assigns the ticker its id, so matching never has to
      */
-    void add_engine(const std::string& ticker);
+    void add_engine(const std::string& ticker, manager::ClientManager& clients);
 
     /** @brief Adds initial liquidity by creating fake sell orders for a given ticker at
      * a given quantity/price
      */
     void add_initial_liquidity(const std::string& ticker, float quantity, float price);
 
+    /**
+     * @brief Returns the tickers of all engines, in sorted order
+     */
+    std::vector<std::string> get_tickers() const;
+
 private:
     std::map<std::string, matching::Engine> engines;
 };
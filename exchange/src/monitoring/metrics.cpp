@@ -0,0 +1,183 @@
+#include "metrics.hpp"
+
+#include "logging.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <type_traits>
+
+namespace nutc {
+namespace monitoring {
+
+namespace {
+constexpr std::array<const char*, 3> TYPE_NAMES{"counter", "gauge", "histogram"};
+
+// Prometheus puts the labels in braces, with le added for histogram buckets
+std::string
+series_name(std::string_view name, std::string_view labels, std::string_view extra = "")
+{
+    if (labels.empty() && extra.empty())
+        return std::string(name);
+    if (labels.empty() || extra.empty())
+        return fmt::format("{}{{{}{}}}", name, labels, extra);
+    return fmt::format("{}{{{},{}}}", name, labels, extra);
+}
+} // namespace
+
+std::string
+label(std::string_view key, std::string_view value)
+{
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char character : value) {
+        if (character == '\\' || character == '"')
+            escaped.push_back('\\');
+        if (character == '\n') {
+            escaped += "\\n";
+            continue;
+        }
+        escaped.push_back(character);
+    }
+    return fmt::format("{}=\"{}\"", key, escaped);
+}
+
+Histogram::Histogram(std::vector<double> bounds) :
+    bounds(std::move(bounds)),
+    counts(std::make_unique<std::atomic<uint64_t>[]>(this->bounds.size() + 1))
+{}
+
+void
+Histogram::observe(double value)
+{
+    auto bucket = std::lower_bound(bounds.begin(), bounds.end(), value);
+    counts[static_cast<size_t>(std::distance(bounds.begin(), bucket))].fetch_add(
+        1, std::memory_order_relaxed
+    );
+    total.fetch_add(1, std::memory_order_relaxed);
+    value_sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+template <typename T, typename... Args>
+T&
+MetricsRegistry::get_or_create(
+    std::string_view name, std::string_view help, std::string_view labels,
+    Args&&... args
+)
+{
+    constexpr size_t type = std::is_same_v<T, Counter> ? 0
+                            : std::is_same_v<T, Gauge> ? 1
+                                                       : 2;
+    std::lock_guard guard(mutex);
+
+    auto family = families.find(name);
+    if (family == families.end())
+        family = families.emplace(std::string(name), Family{std::string(help), type, {}})
+                     .first;
+
+    if (family->second.type != type) [[unlikely]] {
+        log_e(
+            monitoring, "Metric {} is a {}, not a {}; updates will not be exported", name,
+            TYPE_NAMES[family->second.type], TYPE_NAMES[type]
+        );
+        if constexpr (type == 0)
+            return orphan_counter;
+        else if constexpr (type == 1)
+            return orphan_gauge;
+        else
+            return orphan_histogram;
+    }
+
+    auto series = family->second.series.find(labels);
+    if (series == family->second.series.end()) {
+        series = family->second.series
+                     .emplace(
+                         std::string(labels),
+                         std::make_unique<T>(std::forward<Args>(args)...)
+                     )
+                     .first;
+    }
+    return *std::get<std::unique_ptr<T>>(series->second);
+}
+
+Counter&
+MetricsRegistry::counter(
+    std::string_view name, std::string_view help, std::string_view labels
+)
+{
+    return get_or_create<Counter>(name, help, labels);
+}
+
+Gauge&
+MetricsRegistry::gauge(
+    std::string_view name, std::string_view help, std::string_view labels
+)
+{
+    return get_or_create<Gauge>(name, help, labels);
+}
+
+Histogram&
+MetricsRegistry::histogram(
+    std::string_view name, std::string_view help, const std::vector<double>& bounds,
+    std::string_view labels
+)
+{
+    return get_or_create<Histogram>(name, help, labels, bounds);
+}
+
+std::string
+MetricsRegistry::render() const
+{
+    std::string out;
+    auto inserter = std::back_inserter(out);
+    std::lock_guard guard(mutex);
+
+    for (const auto& [name, family] : families) {
+        fmt::format_to(inserter, "# HELP {} {}\n", name, family.help);
+        fmt::format_to(inserter, "# TYPE {} {}\n", name, TYPE_NAMES[family.type]);
+
+        for (const auto& [labels, metric] : family.series) {
+            if (const auto* counter = std::get_if<std::unique_ptr<Counter>>(&metric)) {
+                fmt::format_to(
+                    inserter, "{} {}\n", series_name(name, labels), (*counter)->value()
+                );
+            }
+            else if (const auto* gauge = std::get_if<std::unique_ptr<Gauge>>(&metric)) {
+                fmt::format_to(
+                    inserter, "{} {}\n", series_name(name, labels), (*gauge)->value()
+                );
+            }
+            else {
+                const Histogram& histogram = *std::get<std::unique_ptr<Histogram>>(metric);
+                const auto& bounds = histogram.get_bounds();
+                std::string bucket_name = name + "_bucket";
+
+                uint64_t cumulative = 0;
+                for (size_t bucket = 0; bucket <= bounds.size(); bucket++) {
+                    cumulative += histogram.bucket_count(bucket);
+                    std::string bound = bucket < bounds.size()
+                                            ? fmt::format("le=\"{}\"", bounds[bucket])
+                                            : std::string("le=\"+Inf\"");
+                    fmt::format_to(
+                        inserter, "{} {}\n", series_name(bucket_name, labels, bound),
+                        cumulative
+                    );
+                }
+                fmt::format_to(
+                    inserter, "{} {}\n", series_name(name + "_sum", labels),
+                    histogram.sum()
+                );
+                // The +Inf bucket, so the two agree even while observations land
+                fmt::format_to(
+                    inserter, "{} {}\n", series_name(name + "_count", labels), cumulative
+                );
+            }
+        }
+    }
+    return out;
+}
+
+} // namespace monitoring
+} // namespace nutc
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace nutc {
+namespace monitoring {
+
+/**
+ * @brief Monotonic count; safe to increment from any thread
+ */
+class Counter {
+public:
+    void
+    inc(uint64_t amount = 1)
+    {
+        count.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t
+    value() const
+    {
+        return count.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> count{0};
+};
+
+/**
+ * @brief Value that can go up and down; safe to update from any thread
+ */
+class Gauge {
+public:
+    void
+    set(double value)
+    {
+        current.store(value, std::memory_order_relaxed);
+    }
+
+    void
+    add(double amount)
+    {
+        current.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] double
+    value() const
+    {
+        return current.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<double> current{0};
+};
+
+/**
+ * @brief Counts of observations at or below each of a fixed set of bounds
+ */
+class Histogram {
+public:
+    /**
+     * @param bounds Upper bounds of each bucket, ascending; +Inf is implied
+     */
+    explicit Histogram(std::vector<double> bounds);
+
+    void observe(double value);
+
+    [[nodiscard]] const std::vector<double>&
+    get_bounds() const
+    {
+        return bounds;
+    }
+
+    /**
+     * @brief Observations in the given bucket alone (not cumulative); the last
+     * bucket is +Inf
+     */
+    [[nodiscard]] uint64_t
+    bucket_count(size_t bucket) const
+    {
+        return counts[bucket].load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t
+    count() const
+    {
+        return total.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] double
+    sum() const
+    {
+        return value_sum.load(std::memory_order_relaxed);
+    }
+
+private:
+    const std::vector<double> bounds;
+    std::unique_ptr<std::atomic<uint64_t>[]> counts;
+    std::atomic<uint64_t> total{0};
+    std::atomic<double> value_sum{0};
+};
+
+/**
+ * @brief Formats one label pair, escaping the value, e.g. ticker="A"
+ */
+std::string label(std::string_view key, std::string_view value);
+
+/**
+ * @class MetricsRegistry
+ * @brief Every counter, gauge and histogram the exchange exports, rendered in the
+ * Prometheus text format
+ *
+ * Registering takes a lock and returns a reference that stays valid for the life of
+ * the process, so instrumented code looks a metric up once and updates it lock-free
+ * from then on. Registering the same name and labels again returns the same metric.
+ */
+class MetricsRegistry {
+public:
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+    MetricsRegistry(MetricsRegistry&&) = delete;
+    MetricsRegistry& operator=(MetricsRegistry&&) = delete;
+
+    static MetricsRegistry&
+    getInstance()
+    {
+        static MetricsRegistry instance;
+        return instance;
+    }
+
+    /**
+     * @param labels Already formatted label pairs, e.g. ticker="A",side="bid"
+     */
+    Counter&
+    counter(std::string_view name, std::string_view help, std::string_view labels = "");
+    Gauge&
+    gauge(std::string_view name, std::string_view help, std::string_view labels = "");
+    Histogram& histogram(
+        std::string_view name, std::string_view help, const std::vector<double>& bounds,
+        std::string_view labels = ""
+    );
+
+    /**
+     * @brief Text exposition of every registered metric, families sorted by name
+     */
+    [[nodiscard]] std::string render() const;
+
+private:
+    MetricsRegistry() = default;
+
+    using Metric = std::variant<
+        std::unique_ptr<Counter>, std::unique_ptr<Gauge>, std::unique_ptr<Histogram>>;
+
+    struct Family {
+        std::string help;
+        // Index of the metric type in Metric
+        size_t type;
+        // Keyed by labels
+        std::map<std::string, Metric, std::less<>> series;
+    };
+
+    template <typename T, typename... Args>
+    T& get_or_create(
+        std::string_view name, std::string_view help, std::string_view labels,
+        Args&&... args
+    );
+
+    mutable std::mutex mutex;
+    std::map<std::string, Family, std::less<>> families;
+
+    // Handed out when a name is registered again as a different type, so callers
+    // always get something to update
+    Counter orphan_counter;
+    Gauge orphan_gauge;
+    Histogram orphan_histogram{{}};
+};
+
+} // namespace monitoring
+} // namespace nutc
@@ -0,0 +1,137 @@
+#include "metrics_server.hpp"
+
+#include "logging.hpp"
+#include "tracing/trace.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace nutc {
+namespace monitoring {
+
+namespace {
+// How often the server thread checks whether it should stop
+constexpr int ACCEPT_POLL_TIMEOUT_MS = 100;
+// How long a client gets to send its request before it is answered anyway
+constexpr int REQUEST_TIMEOUT_MS = 100;
+} // namespace
+
+MetricsServer::~MetricsServer()
+{
+    stop();
+}
+
+bool
+MetricsServer::start(uint16_t port)
+{
+    if (running.load())
+        return true;
+
+    listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        log_e(monitoring, "Failed to create metrics socket: {}", std::strerror(errno));
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address), length) != 0
+        || listen(listen_fd, SOMAXCONN) != 0
+        || getsockname(listen_fd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+        log_e(
+            monitoring, "Failed to serve metrics on port {}: {}", port,
+            std::strerror(errno)
+        );
+        close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+
+    bound_port = ntohs(address.sin_port);
+    running.store(true);
+    thread = std::thread(&MetricsServer::run, this);
+    log_i(monitoring, "Serving metrics on http://127.0.0.1:{}/metrics", bound_port);
+    return true;
+}
+
+void
+MetricsServer::stop()
+{
+    running.store(false);
+    if (thread.joinable())
+        thread.join();
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        listen_fd = -1;
+    }
+}
+
+void
+MetricsServer::run()
+{
+    pollfd listener{listen_fd, POLLIN, 0};
+    while (running.load(std::memory_order_relaxed)) {
+        if (poll(&listener, 1, ACCEPT_POLL_TIMEOUT_MS) <= 0)
+            continue;
+
+        int client_fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client_fd < 0)
+            continue;
+        serve(client_fd);
+        close(client_fd);
+    }
+}
+
+void
+MetricsServer::serve(int client_fd) const
+{
+    // The request itself doesn't matter, but read it so the client isn't reset
+    pollfd client{client_fd, POLLIN, 0};
+    std::array<char, 1024> request{};
+    ssize_t request_size = 0;
+    if (poll(&client, 1, REQUEST_TIMEOUT_MS) > 0)
+        request_size = recv(client_fd, request.data(), request.size(), 0);
+    std::string_view request_line(
+        request.data(), static_cast<size_t>(std::max(request_size, ssize_t{0}))
+    );
+
+    bool wants_trace = request_line.starts_with("GET /trace");
+    std::string body = wants_trace ? tracing::Tracer::getInstance().to_chrome_json()
+                                   : registry.render();
+    std::string response = fmt::format(
+        "HTTP/1.0 200 OK\r\nContent-Type: {}\r\n"
+        "Content-Length: {}\r\nConnection: close\r\n\r\n{}",
+        wants_trace ? "application/json" : "text/plain; version=0.0.4", body.size(), body
+    );
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t written =
+            send(client_fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (written <= 0)
+            return;
+        sent += static_cast<size_t>(written);
+    }
+}
+
+} // namespace monitoring
+} // namespace nutc
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "monitoring/metrics.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace nutc {
+namespace monitoring {
+
+/**
+ * @class MetricsServer
+ * @brief Serves MetricsRegistry::render over HTTP on a loopback port, from its own
+ * thread
+ *
+ * Every request gets the current metrics, so it can be scraped by Prometheus or read
+ * with curl, except GET /trace, which returns the recorded trace spans as Chrome trace
+ * JSON (empty unless built with tracing). One connection is handled at a time; scrapes
+ * are rare enough that this never matters.
+ */
+class MetricsServer {
+public:
+    explicit MetricsServer(
+        const MetricsRegistry& registry = MetricsRegistry::getInstance()
+    ) :
+        registry(registry)
+    {}
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+    MetricsServer(MetricsServer&&) = delete;
+    MetricsServer& operator=(MetricsServer&&) = delete;
+
+    ~MetricsServer();
+
+    /**
+     * @brief Binds 127.0.0.1 on the given port and starts serving
+     * @param port 0 picks any free port (see get_port)
+     * @return False if the port could not be bound
+     */
+    bool start(uint16_t port);
+
+    /**
+     * @brief Stops serving and joins the server thread
+     */
+    void stop();
+
+    [[nodiscard]] uint16_t
+    get_port() const
+    {
+        return bound_port;
+    }
+
+private:
+    void run();
+    void serve(int client_fd) const;
+
+    const MetricsRegistry& registry;
+    int listen_fd = -1;
+    uint16_t bound_port = 0;
+    std::atomic<bool> running{false};
+    std::thread thread;
+};
+
+} // namespace monitoring
+} // namespace nutc
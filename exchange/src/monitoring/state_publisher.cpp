@@ -0,0 +1,106 @@
+#include "state_publisher.hpp"
+
+#include "logging.hpp"
+#include "rate_limiting/order_throttle.hpp"
+
+#include <new>
+
+namespace nutc {
+namespace monitoring {
+
+StatePublisher::StatePublisher(
+    shared_memory::SharedMemoryRegion region, StateRegion* state,
+    std::chrono::milliseconds interval
+) :
+    region(std::move(region)),
+    state(state), interval(interval), next_publish(std::chrono::steady_clock::now())
+{}
+
+std::optional<StatePublisher>
+StatePublisher::create(const std::string& name, std::chrono::milliseconds interval)
+{
+    auto region = shared_memory::SharedMemoryRegion::create(name, sizeof(StateRegion));
+    if (!region.has_value()) {
+        log_e(monitoring, "Failed to create state region {}", name);
+        return std::nullopt;
+    }
+
+    auto* state = new (region->data()) StateRegion;
+    state->initialize();
+    log_i(monitoring, "Publishing exchange state to shared memory region {}", name);
+    return StatePublisher{std::move(region.value()), state, interval};
+}
+
+void
+StatePublisher::publish(
+    const manager::ClientManager& clients, engine_manager::Manager& engine_manager
+)
+{
+    std::vector<std::string> tickers = engine_manager.get_tickers();
+    auto num_tickers = static_cast<uint32_t>(
+        std::min<size_t>(tickers.size(), StateRegion::MAX_TICKERS)
+    );
+    auto num_clients = static_cast<uint32_t>(
+        std::min<size_t>(clients.get_num_clients(), StateRegion::MAX_CLIENTS)
+    );
+
+    // Gathered before the write so readers are locked out as briefly as possible
+    std::vector<std::optional<manager::ticker_id>> ticker_ids;
+    std::vector<TickerState> books(num_tickers);
+    for (uint32_t index = 0; index < num_tickers; index++) {
+        const auto& ticker = tickers[index];
+        ticker_ids.push_back(clients.find_ticker_id(ticker));
+
+        TickerState& book = books[index];
+        write_name(book.ticker, ticker);
+        const matching::Engine& engine = engine_manager.get_engine(ticker).value().get();
+        // The level totals, rather than the order heaps, are cheap to read here
+        auto best_bid = engine.get_best_level(messages::SIDE::BUY);
+        auto best_ask = engine.get_best_level(messages::SIDE::SELL);
+        book.bid_levels =
+            static_cast<uint32_t>(engine.get_level_count(messages::SIDE::BUY));
+        book.ask_levels =
+            static_cast<uint32_t>(engine.get_level_count(messages::SIDE::SELL));
+        book.best_bid = best_bid.has_value() ? best_bid->first : 0;
+        book.best_bid_quantity = best_bid.has_value() ? best_bid->second : 0;
+        book.best_ask = best_ask.has_value() ? best_ask->first : 0;
+        book.best_ask_quantity = best_ask.has_value() ? best_ask->second : 0;
+        book.last_trade = ticker_ids.back().has_value()
+                              ? clients.get_mark(ticker_ids.back().value())
+                              : 0;
+    }
+
+    state->begin_write();
+    state->updated_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()
+        )
+            .count()
+    );
+    state->num_clients = num_clients;
+    state->num_tickers = num_tickers;
+    state->counters.publishes++;
+    state->counters.active_clients = clients.get_active_uids().size();
+    state->counters.throttled_orders =
+        rate_limiting::OrderThrottle::getInstance().get_throttled_total();
+    std::copy(books.begin(), books.end(), state->tickers);
+
+    for (manager::client_id client = 0; client < num_clients; client++) {
+        const manager::Client& account = clients.get_client(client);
+        ClientState& out = state->clients[client];
+        write_name(out.uid, account.uid);
+        out.active = account.active ? 1 : 0;
+        out.capital_remaining = clients.get_capital(client);
+        out.portfolio_value = clients.get_portfolio_value(client);
+        for (uint32_t ticker = 0; ticker < num_tickers; ticker++) {
+            state->holdings[client][ticker] =
+                ticker_ids[ticker].has_value()
+                    ? clients.get_holdings(client, ticker_ids[ticker].value())
+                    : 0;
+        }
+    }
+    state->end_write();
+}
+
+} // namespace monitoring
+} // namespace nutc
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "client_manager/client_manager.hpp"
+#include "matching/manager/engine_manager.hpp"
+#include "monitoring/state_region.hpp"
+#include "utils/shared_memory/shared_memory.hpp"
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace nutc {
+namespace monitoring {
+
+/**
+ * @class StatePublisher
+ * @brief Copies accounts, top of book and counters into the StateRegion at a fixed
+ * interval
+ *
+ * Must be driven from the thread that modifies the ClientManager and engines. The copy
+ * happens at most once per interval and never waits on readers.
+ */
+class StatePublisher {
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    /**
+     * @brief Creates the state region
+     * @return nullopt if the region could not be created
+     */
+    static std::optional<StatePublisher> create(
+        const std::string& name = SHM_STATE_REGION,
+        std::chrono::milliseconds interval =
+            std::chrono::milliseconds(STATE_PUBLISH_INTERVAL_MS)
+    );
+
+    /**
+     * @brief Publishes if the interval has elapsed since the last publish
+     */
+    void
+    maybe_publish(
+        const manager::ClientManager& clients, engine_manager::Manager& engine_manager,
+        time_point now = std::chrono::steady_clock::now()
+    )
+    {
+        if (now < next_publish) [[likely]]
+            return;
+        publish(clients, engine_manager);
+        next_publish = now + interval;
+    }
+
+    void
+    publish(const manager::ClientManager& clients, engine_manager::Manager& engine_manager);
+
+private:
+    StatePublisher(
+        shared_memory::SharedMemoryRegion region, StateRegion* state,
+        std::chrono::milliseconds interval
+    );
+
+    shared_memory::SharedMemoryRegion region;
+    StateRegion* state;
+    std::chrono::milliseconds interval;
+    time_point next_publish;
+};
+
+} // namespace monitoring
+} // namespace nutc
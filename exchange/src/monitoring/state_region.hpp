@@ -0,0 +1,163 @@
+#pragma once
+
+#include "config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace nutc {
+/**
+ * @brief Live, read-only views of exchange state for processes outside the exchange
+ */
+namespace monitoring {
+
+struct ClientState {
+    char uid[SHM_STATE_UID_SIZE]; // not null terminated when full
+    uint32_t active;
+    float capital_remaining;
+    double portfolio_value;
+};
+
+struct TickerState {
+    char ticker[SHM_STATE_TICKER_SIZE];
+    // Price and total quantity of the best level; 0 when that side is empty
+    float best_bid;
+    float best_bid_quantity;
+    float best_ask;
+    float best_ask_quantity;
+    float last_trade;
+    uint32_t bid_levels;
+    uint32_t ask_levels;
+};
+
+struct StateCounters {
+    // Times this region has been rewritten
+    uint64_t publishes;
+    uint64_t active_clients;
+    uint64_t throttled_orders;
+};
+
+/**
+ * @brief Periodic snapshot of accounts, top of book and counters in shared memory
+ *
+ * The exchange is the only writer; any number of monitors may map the region read-only
+ * (see SharedMemoryRegion::open) and copy out what they need through try_read. The whole
+ * body is guarded by one seqlock: sequence is odd while the exchange is rewriting it.
+ * Readers must check magic and version before trusting the layout.
+ */
+struct StateRegion {
+    static constexpr uint64_t MAGIC = 0x544154534354554e; // "NUTCSTAT"
+    static constexpr uint32_t LAYOUT_VERSION = 1;
+    static constexpr uint32_t MAX_CLIENTS = SHM_STATE_MAX_CLIENTS;
+    static constexpr uint32_t MAX_TICKERS = SHM_STATE_MAX_TICKERS;
+
+    static_assert(
+        std::atomic<uint64_t>::is_always_lock_free,
+        "cross-process atomics must be lock free"
+    );
+
+    std::atomic<uint64_t> magic;
+    uint32_t version;
+    uint32_t max_clients;
+    uint32_t max_tickers;
+
+    alignas(64) std::atomic<uint64_t> sequence;
+
+    // Everything below is only consistent inside try_read
+    uint64_t updated_ns; // system clock
+    uint32_t num_clients;
+    uint32_t num_tickers;
+    StateCounters counters;
+    TickerState tickers[MAX_TICKERS];
+    ClientState clients[MAX_CLIENTS];
+    // holdings[client][ticker], indexed like clients and tickers
+    float holdings[MAX_CLIENTS][MAX_TICKERS];
+
+    /**
+     * @brief Prepares a freshly created (zero-filled) region for use
+     */
+    void
+    initialize()
+    {
+        version = LAYOUT_VERSION;
+        max_clients = MAX_CLIENTS;
+        max_tickers = MAX_TICKERS;
+        sequence.store(0, std::memory_order_relaxed);
+        magic.store(MAGIC, std::memory_order_release);
+    }
+
+    [[nodiscard]] bool
+    is_initialized() const
+    {
+        return magic.load(std::memory_order_acquire) == MAGIC && version == LAYOUT_VERSION
+               && max_clients == MAX_CLIENTS && max_tickers == MAX_TICKERS;
+    }
+
+    /**
+     * @brief Writer only: everything written between begin_write and end_write becomes
+     * visible to readers at once
+     */
+    void
+    begin_write()
+    {
+        sequence.store(
+            sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed
+        );
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void
+    end_write()
+    {
+        sequence.store(
+            sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release
+        );
+    }
+
+    /**
+     * @brief Runs copy on the region and reports whether what it copied is consistent
+     * @param copy Must only copy; it may observe a torn state, which is then discarded
+     * @return False if the exchange wrote concurrently; retry
+     */
+    template <typename Copy>
+    bool
+    try_read(Copy&& copy) const
+    {
+        uint64_t before = sequence.load(std::memory_order_acquire);
+        if (before % 2 != 0)
+            return false;
+
+        copy(*this);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return sequence.load(std::memory_order_relaxed) == before;
+    }
+};
+
+/**
+ * @brief Copies a name into a fixed-size field, truncating if it doesn't fit
+ */
+template <size_t Size>
+inline void
+write_name(char (&field)[Size], std::string_view name)
+{
+    size_t length = std::min(name.size(), Size);
+    std::memcpy(field, name.data(), length);
+    std::memset(field + length, 0, Size - length);
+}
+
+/**
+ * @brief Reads a name written by write_name
+ */
+template <size_t Size>
+inline std::string_view
+read_name(const char (&field)[Size])
+{
+    return {field, strnlen(field, Size)};
+}
+
+} // namespace monitoring
+} // namespace nutc
@@ -1,19 +1,46 @@
 #include "RabbitMQClientManager.hpp"
 
 #include "client_manager/client_manager.hpp"
+#include "config.h"
 #include "logging.hpp"
 #include "networking/rabbitmq/consumer/RabbitMQConsumer.hpp"
 #include "networking/rabbitmq/publisher/RabbitMQPublisher.hpp"
+#include "process_spawning/supervisor.hpp"
+
+#include <chrono>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 namespace nutc {
 namespace rabbitmq {
 
-void
+namespace {
+std::string
+start_time_message(int wait_seconds)
+{
+    using time_point = std::chrono::high_resolution_clock::time_point;
+    time_point time =
+        std::chrono::high_resolution_clock::now() + std::chrono::seconds(wait_seconds);
+    long long time_ns = std::chrono::time_point_cast<std::chrono::nanoseconds>(time)
+                            .time_since_epoch()
+                            .count();
+    return glz::write_json(messages::StartTime{time_ns});
+}
+} // namespace
+
+int
 RabbitMQClientManager::waitForClients(
-    manager::ClientManager& clients, const int num_clients
+    manager::ClientManager& clients, const int num_clients,
+    std::chrono::milliseconds timeout
 )
 {
+    int num_reported = 0;
     int num_running = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + timeout;
+    std::vector<int64_t> ready_ms;
+    std::unordered_set<std::string> reported;
 
     auto processMessage = [&](const auto& message) {
         using T = std::decay_t<decltype(message)>;
@@ -21,7 +48,6 @@ RabbitMQClientManager::waitForClients(
             log_e(
                 rabbitmq, "Failed to consume message with error {}.", message.message
             );
-            return false;
         }
         else if constexpr (std::is_same_v<T, messages::MarketOrder>) {
             log_i(
@@ -29,30 +55,73 @@ RabbitMQClientManager::waitForClients(
                 "Received market order before initialization complete. Ignoring..."
             );
         }
+        else if constexpr (std::is_same_v<T, messages::SnapshotRequest>) {
+            log_i(
+                rabbitmq,
+                "Received snapshot request before initialization complete. Ignoring..."
+            );
+        }
         else if constexpr (std::is_same_v<T, messages::InitMessage>) {
             log_i(
                 rabbitmq, "Received init message from client {} with status {}",
                 message.client_uid, message.ready ? "ready" : "not ready"
             );
+            num_reported++;
+            reported.insert(message.client_uid);
             if (message.ready) {
                 clients.set_active(message.client_uid);
                 num_running++;
+                ready_ms.push_back(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - start
+                    )
+                        .count()
+                );
             }
         }
-        return true; // indicate that function should continue
     };
 
-    for (int i = 0; i < num_clients; i++) {
-        auto data = RabbitMQConsumer::consumeMessage();
-        if (!std::visit(processMessage, data)) {
-            return;
+    // Clients that died before reporting (and won't be restarted) never will. Exits of
+    // clients that already reported are already counted in num_reported
+    auto num_gone = [&reported] {
+        std::unordered_set<std::string> gone;
+        for (const auto& exit : client::Supervisor::getInstance().get_exit_records()) {
+            if (!exit.restarting && !reported.contains(exit.uid))
+                gone.insert(exit.uid);
         }
+        return static_cast<int>(gone.size());
+    };
+
+    while (num_reported < num_clients) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            log_w(
+                rabbitmq,
+                "Only {} of {} clients reported within {}ms, the rest join when ready",
+                num_reported, num_clients, timeout.count()
+            );
+            break;
+        }
+        auto data = RabbitMQConsumer::consumeMessage(
+            std::chrono::microseconds(INGRESS_POLL_TIMEOUT_US)
+        );
+        if (data.has_value())
+            std::visit(processMessage, data.value());
+        else if (num_reported + num_gone() >= num_clients)
+            break;
     }
 
     log_i(
-        rabbitmq, "All {} clients ready. Starting exchange with {} ready clients",
-        num_clients, num_running
+        rabbitmq, "{} of {} clients reported. Starting exchange with {} ready clients",
+        num_reported, num_clients, num_running
     );
+    // Messages arrive in order, so ready_ms is already sorted
+    if (!ready_ms.empty()) {
+        log_i(
+            rabbitmq, "Clients ready after: first {}ms, median {}ms, last {}ms",
+            ready_ms.front(), ready_ms[ready_ms.size() / 2], ready_ms.back()
+        );
+    }
+    return num_running;
 }
 
 void
@@ -60,23 +129,15 @@ RabbitMQClientManager::sendStartTime(
     const manager::ClientManager& manager, int wait_seconds
 )
 {
-    std::vector<manager::Client> active_clients = manager.get_clients(true);
-    using time_point = std::chrono::high_resolution_clock::time_point;
-    time_point time =
-        std::chrono::high_resolution_clock::now() + std::chrono::seconds(wait_seconds);
-    long long time_ns = std::chrono::time_point_cast<std::chrono::nanoseconds>(time)
-                            .time_since_epoch()
-                            .count();
-
-    messages::StartTime message{time_ns};
-    std::string buf = glz::write_json(message);
-    auto send_to_client = [buf](const manager::Client& client) {
-        RabbitMQPublisher::publishMessage(client.uid, buf);
-    };
+    std::string buf = start_time_message(wait_seconds);
+    for (const auto& uid : manager.get_active_uids())
+        RabbitMQPublisher::publishMessage(uid, buf);
+}
 
-    for (const auto& client : active_clients) {
-        send_to_client(client);
-    }
+void
+RabbitMQClientManager::sendStartTime(const std::string& uid, int wait_seconds)
+{
+    RabbitMQPublisher::publishMessage(uid, start_time_message(wait_seconds));
 }
 
 } // namespace rabbitmq
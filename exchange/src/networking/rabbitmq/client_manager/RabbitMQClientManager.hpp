@@ -2,6 +2,9 @@
 
 #include "client_manager/client_manager.hpp"
 
+#include <chrono>
+#include <string>
+
 namespace nutc {
 namespace rabbitmq {
 //TODO: refactor to client_manager?
@@ -9,14 +12,24 @@ namespace rabbitmq {
 class RabbitMQClientManager {
 public:
     /**
-     * @brief On startup, waits for all clients to send an initialization message
+     * @brief On startup, waits for clients to send an initialization message
+     *
+     * Returns once every spawned client has reported (ready or not) or exited for
+     * good, or when the timeout expires. Clients that report later join with a book
+     * snapshot (see RabbitMQConsumer::handleIncomingMessage).
      *
-     * This ensures that all clients are connected to the exchange and have successfully
-     * started (vs a RMQ or firebase error)
+     * @return The number of clients that are ready to trade
      */
-    static void waitForClients(manager::ClientManager& manager, int num_clients);
+    static int waitForClients(
+        manager::ClientManager& manager, int num_clients, std::chrono::milliseconds timeout
+    );
 
     static void sendStartTime(const manager::ClientManager& manager, int wait_seconds);
+
+    /**
+     * @brief Sends a start time to a single client, e.g. one that was restarted
+     */
+    static void sendStartTime(const std::string& uid, int wait_seconds);
 };
 } // namespace rabbitmq
 } // namespace nutc
@@ -18,7 +18,18 @@ RabbitMQConnectionManager::connectToRabbitMQ(
     const std::string& password
 )
 {
-    amqp_socket_t* socket = amqp_tcp_socket_new(connection_state);
+    // Kept so a publish connection can be opened to the same broker later
+    parameters = {hostname, port, username, password};
+    return login(connection_state, hostname, port, username, password);
+}
+
+bool
+RabbitMQConnectionManager::login(
+    amqp_connection_state_t state, const std::string& hostname, int port,
+    const std::string& username, const std::string& password
+)
+{
+    amqp_socket_t* socket = amqp_tcp_socket_new(state);
 
     if (!socket) {
         log_e(rabbitmq, "{}", "Failed to create TCP socket.");
@@ -29,7 +40,7 @@ RabbitMQConnectionManager::connectToRabbitMQ(
     }
 
     amqp_rpc_reply_t reply = amqp_login(
-        connection_state, "/", 0, 131072, 0, AMQP_SASL_METHOD_PLAIN, username.c_str(),
+        state, "/", 0, 131072, 0, AMQP_SASL_METHOD_PLAIN, username.c_str(),
         password.c_str()
     );
     if (reply.reply_type != AMQP_RESPONSE_NORMAL) {
@@ -40,23 +51,60 @@ RabbitMQConnectionManager::connectToRabbitMQ(
     return true;
 }
 
+bool
+RabbitMQConnectionManager::openPublishConnection()
+{
+    amqp_connection_state_t state = amqp_new_connection();
+    if (!login(
+            state, parameters.hostname, parameters.port, parameters.username,
+            parameters.password
+        )) {
+        amqp_destroy_connection(state);
+        return false;
+    }
+
+    amqp_channel_open(state, 1);
+    amqp_rpc_reply_t res = amqp_get_rpc_reply(state);
+    if (res.reply_type != AMQP_RESPONSE_NORMAL) {
+        log_e(rabbitmq, "Failed to open publish channel.");
+        amqp_destroy_connection(state);
+        return false;
+    }
+
+    publish_connection_state = state;
+    return true;
+}
+
+amqp_connection_state_t
+RabbitMQConnectionManager::get_publish_connection_state()
+{
+    return publish_connection_state != nullptr ? publish_connection_state
+                                               : connection_state;
+}
+
 void
 RabbitMQConnectionManager::closeConnection(const manager::ClientManager& client_manager)
 {
     // Handle client shutdown
-    auto shutdownClient = [&](const auto& client) {
-        log_i(rabbitmq, "Shutting down client {}", client.uid);
-        messages::ShutdownMessage shutdown{client.uid};
+    auto shutdownClient = [&](const std::string& uid) {
+        log_i(rabbitmq, "Shutting down client {}", uid);
+        messages::ShutdownMessage shutdown{uid};
         auto messageStr = glz::write_json(shutdown);
-        RabbitMQPublisher::publishMessage(client.uid, messageStr);
+        RabbitMQPublisher::publishMessage(uid, messageStr);
     };
 
     // Iterate over clients and shut them down
-    for (const auto& client : client_manager.get_clients(true)) {
-        shutdownClient(client);
+    for (const auto& uid : client_manager.get_active_uids()) {
+        shutdownClient(uid);
     }
 
     // Close channel and connection, then destroy connection
+    if (publish_connection_state != nullptr) {
+        amqp_channel_close(publish_connection_state, 1, AMQP_REPLY_SUCCESS);
+        amqp_connection_close(publish_connection_state, AMQP_REPLY_SUCCESS);
+        amqp_destroy_connection(publish_connection_state);
+        publish_connection_state = nullptr;
+    }
     amqp_channel_close(connection_state, 1, AMQP_REPLY_SUCCESS);
     amqp_connection_close(connection_state, AMQP_REPLY_SUCCESS);
     amqp_destroy_connection(connection_state);
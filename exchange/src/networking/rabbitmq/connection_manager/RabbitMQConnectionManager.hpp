@@ -35,10 +35,39 @@ public:
     bool connectedToRMQ();
     amqp_connection_state_t get_connection_state();
 
+    /**
+     * @brief Opens a second connection used only for publishing
+     *
+     * amqp connections are not thread safe, so when consuming and publishing happen on
+     * different threads each needs its own connection. It connects to the broker,
+     * with the credentials, that the consuming connection was opened with.
+     */
+    bool openPublishConnection();
+
+    /**
+     * @brief Connection to publish on; the consuming connection unless a separate
+     * publish connection was opened
+     */
+    amqp_connection_state_t get_publish_connection_state();
+
 private:
+    struct ConnectionParameters {
+        std::string hostname;
+        int port;
+        std::string username;
+        std::string password;
+    };
+
+    ConnectionParameters parameters;
     amqp_connection_state_t connection_state;
+    amqp_connection_state_t publish_connection_state = nullptr;
     bool connected;
 
+    static bool login(
+        amqp_connection_state_t state, const std::string& hostname, int port,
+        const std::string& username, const std::string& password
+    );
+
     bool initializeConnection();
 
     RabbitMQConnectionManager()
@@ -1,77 +1,184 @@
 #include "RabbitMQConsumer.hpp"
 
-#include "networking/rabbitmq/connection_manager/RabbitMQConnectionManager.hpp"
+#include "config.h"
+#include "latency/order_latency.hpp"
+#include "leaderboard/leaderboard.hpp"
+#include "monitoring/metrics.hpp"
+#include "monitoring/state_publisher.hpp"
+#include "networking/rabbitmq/client_manager/RabbitMQClientManager.hpp"
 #include "networking/rabbitmq/order_handler/RabbitMQOrderHandler.hpp"
+#include "networking/rabbitmq/publisher/RabbitMQPublisher.hpp"
+#include "networking/transport/TransportManager.hpp"
+#include "process_spawning/supervisor.hpp"
+#include "rate_limiting/order_throttle.hpp"
+#include "tracing/trace.hpp"
+#include "utils/logger/logger.hpp"
 
 namespace nutc {
 namespace rabbitmq {
 
+RabbitMQConsumer::Metrics&
+RabbitMQConsumer::getMetrics()
+{
+    auto& registry = monitoring::MetricsRegistry::getInstance();
+    static Metrics metrics{
+        registry.counter("nutc_messages_received_total", "Messages taken from ingress"),
+        registry.counter(
+            "nutc_orders_throttled_total", "Orders rejected by the ingress rate limits"
+        ),
+        registry.counter(
+            "nutc_decode_errors_total", "Incoming messages that failed to parse"
+        ),
+        registry.histogram(
+            "nutc_message_handle_seconds",
+            "Time from receiving a message to publishing its results",
+            {1e-6, 5e-6, 1e-5, 5e-5, 1e-4, 5e-4, 1e-3, 5e-3, 1e-2, 5e-2}
+        ),
+    };
+    return metrics;
+}
+
 void
 RabbitMQConsumer::handleIncomingMessages(
     manager::ClientManager& clients, engine_manager::Manager& engine_manager
 )
 {
     bool keepRunning = true;
+    leaderboard::SnapshotWriter leaderboard(
+        LEADERBOARD_FILE, std::chrono::seconds(LEADERBOARD_INTERVAL_SECS), LEADERBOARD_SIZE
+    );
+    auto state = monitoring::StatePublisher::create();
+    auto& supervisor = client::Supervisor::getInstance();
 
     while (keepRunning) {
-        auto incoming_message = consumeMessage();
-
-        // Use std::visit to deal with the variant
-        std::visit(
-            [&](auto&& arg) {
-                using T = std::decay_t<decltype(arg)>;
-                if constexpr (std::is_same_v<T, messages::InitMessage>) {
-                    log_e(rabbitmq, "Not expecting initialization message");
-                    exit(1);
-                }
-                else if constexpr (std::is_same_v<T, messages::RMQError>) {
-                    log_e(rabbitmq, "Received RMQError: {}", arg.message);
-                }
-                else if constexpr (std::is_same_v<T, messages::MarketOrder>) {
-                    RabbitMQOrderHandler::handleIncomingMarketOrder(
-                        engine_manager, clients, arg
-                    );
-                }
-            },
-            incoming_message
+        bool handled = handleIncomingMessage(
+            clients, engine_manager, std::chrono::microseconds(INGRESS_POLL_TIMEOUT_US)
         );
+        // Idle, so the journal is written out rather than waiting for more events
+        if (!handled)
+            events::Logger::get_logger().flush();
+        leaderboard.maybe_write(clients);
+        if (state.has_value())
+            state->maybe_publish(clients, engine_manager);
+        latency::OrderLatency::getInstance().maybe_log_stats();
+        if (supervisor.has_exited()) [[unlikely]] {
+            for (const auto& uid : supervisor.take_exited())
+                clients.set_inactive(uid);
+        }
     }
 }
 
-std::optional<std::string>
-RabbitMQConsumer::consumeMessageAsString()
+bool
+RabbitMQConsumer::handleIncomingMessage(
+    manager::ClientManager& clients, engine_manager::Manager& engine_manager,
+    std::chrono::microseconds timeout
+)
 {
-    const auto& connection_state =
-        RabbitMQConnectionManager::getInstance().get_connection_state();
-
-    amqp_envelope_t envelope;
-    amqp_maybe_release_buffers(connection_state);
-    amqp_rpc_reply_t res = amqp_consume_message(connection_state, &envelope, NULL, 0);
+    std::optional<std::string> buf = consumeMessageAsString(timeout);
+    if (!buf.has_value())
+        return false;
+    latency::OrderTimestamps timestamps{.received_ns = latency::now_ns()};
+    Metrics& metrics = getMetrics();
+    metrics.received.inc();
 
-    if (res.reply_type != AMQP_RESPONSE_NORMAL) {
-        log_e(rabbitmq, "Failed to consume message.");
-        return std::nullopt;
+    auto rejection = rate_limiting::OrderThrottle::getInstance().check(buf.value());
+    if (rejection.has_value()) [[unlikely]] {
+        metrics.throttled.inc();
+        RabbitMQPublisher::publishOrderRejected(rejection->client_uid, rejection->message);
+        return true;
     }
 
-    std::string message(
-        reinterpret_cast<char*>(envelope.message.body.bytes), envelope.message.body.len
+    auto incoming_message = [&buf] {
+        TRACE_SPAN(decode_span, "decode");
+        return decodeMessage(buf.value());
+    }();
+    timestamps.decoded_ns = latency::now_ns();
+
+    // Use std::visit to deal with the variant
+    std::visit(
+        [&](auto&& arg) {
+            using T = std::decay_t<decltype(arg)>;
+            if constexpr (std::is_same_v<T, messages::InitMessage>) {
+                // Stragglers and restarted clients; they start from the current
+                // books, so the snapshot goes out before the start time. Repeats
+                // from a client already trading would be unthrottled snapshots
+                auto client = clients.get_client_id(arg.client_uid);
+                if (!arg.ready || !client.has_value()
+                    || clients.get_client(client.value()).active)
+                    return;
+                log_i(rabbitmq, "Client {} joined late", arg.client_uid);
+                clients.set_active(arg.client_uid);
+                RabbitMQOrderHandler::handleSnapshotRequest(
+                    engine_manager, messages::SnapshotRequest{arg.client_uid}
+                );
+                RabbitMQClientManager::sendStartTime(arg.client_uid, 0);
+            }
+            else if constexpr (std::is_same_v<T, messages::RMQError>) {
+                metrics.decode_errors.inc();
+                log_e(rabbitmq, "Received RMQError: {}", arg.message);
+            }
+            else if constexpr (std::is_same_v<T, messages::MarketOrder>) {
+                RabbitMQOrderHandler::handleIncomingMarketOrder(
+                    engine_manager, clients, arg, timestamps
+                );
+            }
+            else if constexpr (std::is_same_v<T, messages::SnapshotRequest>) {
+                RabbitMQOrderHandler::handleSnapshotRequest(engine_manager, arg);
+            }
+        },
+        incoming_message
+    );
+    metrics.handle_seconds.observe(
+        static_cast<double>(latency::now_ns() - timestamps.received_ns) / 1e9
     );
-    amqp_destroy_envelope(&envelope);
-    return message;
+    return true;
+}
+
+std::optional<std::string>
+RabbitMQConsumer::consumeMessageAsString(std::chrono::microseconds timeout)
+{
+    return transport::TransportManager::getInstance().receive(timeout);
 }
 
-std::variant<messages::InitMessage, messages::MarketOrder, messages::RMQError>
+std::variant<
+    messages::InitMessage, messages::MarketOrder, messages::SnapshotRequest,
+    messages::RMQError>
 RabbitMQConsumer::consumeMessage()
 {
-    std::optional<std::string> buf = consumeMessageAsString();
-    if (!buf.has_value()) {
-        return messages::RMQError{"Failed to consume message."};
+    // Only timeouts are retried; a failed receive comes back as an empty message
+    std::optional<std::string> buf;
+    while (!buf.has_value()) {
+        buf = consumeMessageAsString(std::chrono::microseconds(INGRESS_POLL_TIMEOUT_US));
     }
+    return decodeMessage(buf.value());
+}
+
+std::optional<std::variant<
+    messages::InitMessage, messages::MarketOrder, messages::SnapshotRequest,
+    messages::RMQError>>
+RabbitMQConsumer::consumeMessage(std::chrono::microseconds timeout)
+{
+    std::optional<std::string> buf = consumeMessageAsString(timeout);
+    if (!buf.has_value())
+        return std::nullopt;
+    return decodeMessage(buf.value());
+}
 
-    std::variant<messages::InitMessage, messages::MarketOrder, messages::RMQError> data;
-    auto err = glz::read_json(data, buf.value());
+std::variant<
+    messages::InitMessage, messages::MarketOrder, messages::SnapshotRequest,
+    messages::RMQError>
+RabbitMQConsumer::decodeMessage(const std::string& buf)
+{
+    std::variant<
+        messages::InitMessage, messages::MarketOrder, messages::SnapshotRequest,
+        messages::RMQError>
+        data;
+    if (buf.empty()) {
+        return messages::RMQError{"Failed to consume message."};
+    }
+    auto err = glz::read_json(data, buf);
     if (err) {
-        return messages::RMQError{glz::format_error(err, buf.value())};
+        return messages::RMQError{glz::format_error(err, buf)};
     }
     return data;
 }
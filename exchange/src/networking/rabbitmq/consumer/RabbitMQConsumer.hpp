@@ -3,22 +3,63 @@
 #include "client_manager/client_manager.hpp"
 #include "matching/manager/engine_manager.hpp"
 #include "logging.hpp"
+#include "monitoring/metrics.hpp"
 #include "utils/messages.hpp"
 
+#include <chrono>
 #include <optional>
 #include <string>
 
-#include <rabbitmq-c/amqp.h>
-
 namespace nutc {
 namespace rabbitmq {
 
+/**
+ * @brief Decodes and dispatches incoming client messages
+ *
+ * Messages are pulled from every registered ingress transport (RabbitMQ, shared
+ * memory), not only from the broker.
+ */
 class RabbitMQConsumer {
 public:
+    /**
+     * @brief Ingress counters, kept by whichever loop handles incoming messages
+     */
+    struct Metrics {
+        monitoring::Counter& received;
+        monitoring::Counter& throttled;
+        monitoring::Counter& decode_errors;
+        monitoring::Histogram& handle_seconds;
+    };
+
+    static Metrics& getMetrics();
+
+    /**
+     * @brief Blocks until a message arrives on any ingress and decodes it
+     * @return The message, or an RMQError if receiving or decoding failed
+     */
     static std::variant<
-        messages::InitMessage, messages::MarketOrder, messages::RMQError>
+        messages::InitMessage, messages::MarketOrder, messages::SnapshotRequest,
+        messages::RMQError>
     consumeMessage();
 
+    /**
+     * @brief consumeMessage, giving up after timeout
+     * @return nullopt if no message arrived in time
+     */
+    static std::optional<std::variant<
+        messages::InitMessage, messages::MarketOrder, messages::SnapshotRequest,
+        messages::RMQError>>
+    consumeMessage(std::chrono::microseconds timeout);
+
+    /**
+     * @brief Parses a serialized client message
+     * @return The message, or an RMQError describing why it could not be parsed
+     */
+    static std::variant<
+        messages::InitMessage, messages::MarketOrder, messages::SnapshotRequest,
+        messages::RMQError>
+    decodeMessage(const std::string& buf);
+
     /**
      * @brief Main event loop, handles incoming messages from exchange
      *
@@ -29,8 +70,23 @@ public:
         manager::ClientManager& clients, engine_manager::Manager& engine_manager
     );
 
+    /**
+     * @brief Receives and handles at most one incoming message
+     *
+     * One iteration of handleIncomingMessages, for callers that drive the exchange
+     * themselves (tests and benchmarks using the loopback transport)
+     *
+     * @return False if no message arrived within timeout
+     */
+    static bool handleIncomingMessage(
+        manager::ClientManager& clients, engine_manager::Manager& engine_manager,
+        std::chrono::microseconds timeout
+    );
+
 private:
-    static std::optional<std::string> consumeMessageAsString();
+    static std::optional<std::string>
+    consumeMessageAsString(std::chrono::microseconds timeout);
+
 };
 
 } // namespace rabbitmq
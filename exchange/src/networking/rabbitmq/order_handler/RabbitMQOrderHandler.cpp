@@ -1,6 +1,8 @@
 #include "RabbitMQOrderHandler.hpp"
 
 #include "networking/rabbitmq/publisher/RabbitMQPublisher.hpp"
+#include "networking/transport/TransportManager.hpp"
+#include "tracing/trace.hpp"
 
 namespace nutc {
 namespace rabbitmq {
@@ -8,23 +10,19 @@ namespace rabbitmq {
 void
 RabbitMQOrderHandler::handleIncomingMarketOrder(
     engine_manager::Manager& engine_manager, manager::ClientManager& clients,
-    MarketOrder& order
+    MarketOrder& order, latency::OrderTimestamps timestamps
 )
 {
-    std::string buffer;
-    glz::write<glz::opts{}>(order, buffer);
-    std::string replace1 = R"("side":0)";
-    std::string replace2 = R"("side":1)";
-    size_t pos1 = buffer.find(replace1);
-    size_t pos2 = buffer.find(replace2);
-    if (pos1 != std::string::npos) {
-        buffer.replace(pos1, replace1.length(), R"("side":"buy")");
-    }
-    if (pos2 != std::string::npos) {
-        buffer.replace(pos2, replace2.length(), R"("side":"ask")");
+    {
+        TRACE_SPAN(log_span, "log");
+        TRACE_ARG(log_span, order.order_index);
+        log_order(
+            rabbitmq, order.order_index,
+            "Received market order {}: {} {} {} {} at {}", order.order_index,
+            order.client_uid, order.side == messages::SIDE::BUY ? "buy" : "ask",
+            order.quantity, order.ticker, order.price
+        );
     }
-
-    log_i(rabbitmq, "Received market order: {}", buffer);
     std::optional<std::reference_wrapper<Engine>> engine =
         engine_manager.get_engine(order.ticker);
     if (!engine.has_value()) {
@@ -34,20 +32,27 @@ RabbitMQOrderHandler::handleIncomingMarketOrder(
         );
         return;
     }
-    auto [matches, ob_updates] = engine.value().get().match_order(order, clients);
+    auto [matches, ob_updates] = [&] {
+        TRACE_SPAN(match_span, "match");
+        TRACE_ARG(match_span, order.order_index);
+        return engine.value().get().match_order(order, clients);
+    }();
+    timestamps.matched_ns = latency::now_ns();
+
+    TRACE_SPAN(publish_span, "publish");
+    TRACE_ARG(publish_span, order.order_index);
     for (const auto& match : matches) {
-        std::string buyer_uid = match.buyer_uid;
-        std::string seller_uid = match.seller_uid;
         RabbitMQPublisher::broadcastAccountUpdate(clients, match);
-        log_i(
-            matching, "Matched order with price {} and quantity {}", match.price,
-            match.quantity
+        log_order(
+            matching, order.order_index, "Matched order with price {} and quantity {}",
+            match.price, match.quantity
         );
     }
     for (const auto& update : ob_updates) {
-        log_i(
-            rabbitmq, "New ObUpdate with ticker {} price {} quantity {} side {}",
-            update.security, update.price, update.quantity,
+        log_order(
+            rabbitmq, order.order_index,
+            "New ObUpdate with ticker {} price {} quantity {} side {}", update.security,
+            update.price, update.quantity,
             update.side == messages::SIDE::BUY ? "BUY" : "ASK"
         );
     }
@@ -57,6 +62,45 @@ RabbitMQOrderHandler::handleIncomingMarketOrder(
     if (ob_updates.size() > 0) {
         RabbitMQPublisher::broadcastObUpdates(clients, ob_updates, order.client_uid);
     }
+
+    if (timestamps.received_ns != 0) {
+        timestamps.published_ns = latency::now_ns();
+        latency::OrderLatency::getInstance().record(timestamps, order.ticker);
+    }
+}
+
+messages::BookSnapshot
+RabbitMQOrderHandler::buildSnapshot(engine_manager::Manager& engine_manager)
+{
+    messages::BookSnapshot snapshot{0, {}};
+    for (const auto& ticker : engine_manager.get_tickers()) {
+        const Engine& engine = engine_manager.get_engine(ticker).value().get();
+        for (SIDE side : {messages::SIDE::BUY, messages::SIDE::SELL}) {
+            auto levels = engine.get_levels(side, ticker);
+            snapshot.levels.insert(snapshot.levels.end(), levels.begin(), levels.end());
+        }
+    }
+    return snapshot;
+}
+
+void
+RabbitMQOrderHandler::handleSnapshotRequest(
+    engine_manager::Manager& engine_manager, const messages::SnapshotRequest& request
+)
+{
+    messages::BookSnapshot snapshot = buildSnapshot(engine_manager);
+
+    // Matching is single threaded, so nothing is broadcast while the books are copied
+    snapshot.sequence =
+        transport::TransportManager::getInstance().nextBroadcastSequence();
+    log_i(
+        rabbitmq, "Sending book snapshot at sequence {} to {}", snapshot.sequence,
+        request.requester_uid
+    );
+
+    std::string buffer;
+    glz::write<glz::opts{}>(snapshot, buffer);
+    RabbitMQPublisher::publishMessage(request.requester_uid, buffer);
 }
 
 void
@@ -66,7 +110,12 @@ RabbitMQOrderHandler::addLiquidityToTicker(
 )
 {
     engine_manager.add_initial_liquidity(ticker, quantity, price);
-    messages::ObUpdate update{ticker, messages::SIDE::SELL, price, quantity};
+    float level_quantity = 0;
+    if (auto engine = engine_manager.get_engine(ticker); engine.has_value())
+        level_quantity = engine->get().get_level_quantity(messages::SIDE::SELL, price);
+    messages::ObUpdate update{
+        ticker, messages::SIDE::SELL, price, quantity, level_quantity
+    };
     std::vector<messages::ObUpdate> vec{};
     vec.push_back(update);
   RabbitMQPublisher::broadcastObUpdates(clients, vec, "");
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "client_manager/client_manager.hpp"
+#include "latency/order_latency.hpp"
 #include "matching/manager/engine_manager.hpp"
 #include "utils/messages.hpp"
 
@@ -14,9 +15,27 @@ public:
         manager::ClientManager& clients, engine_manager::Manager& engine_manager,
         const std::string& ticker, float quantity, float price
     );
+
+    /**
+     * @brief Matches the order and publishes the results
+     * @param timestamps Receive and decode times; completed here and recorded in the
+     * OrderLatency histograms if set
+     */
     static void handleIncomingMarketOrder(
         engine_manager::Manager& engine_manager, manager::ClientManager& clients,
-        messages::MarketOrder& order
+        messages::MarketOrder& order, latency::OrderTimestamps timestamps = {}
+    );
+
+    /**
+     * @brief Aggregates every book into a snapshot; sequence is left for the caller
+     */
+    static messages::BookSnapshot buildSnapshot(engine_manager::Manager& engine_manager);
+
+    /**
+     * @brief Sends the requesting client a BookSnapshot covering every ticker
+     */
+    static void handleSnapshotRequest(
+        engine_manager::Manager& engine_manager, const messages::SnapshotRequest& request
     );
 };
 
@@ -1,38 +1,80 @@
 #include "RabbitMQPublisher.hpp"
-#include "networking/rabbitmq/connection_manager/RabbitMQConnectionManager.hpp"
 
 #include "logging.hpp"
+#include "monitoring/metrics.hpp"
+#include "networking/transport/TransportManager.hpp"
+
+#include <algorithm>
 
 namespace nutc {
 namespace rabbitmq {
 
+namespace {
+struct PublisherMetrics {
+    monitoring::Counter& published;
+    monitoring::Counter& failures;
+    monitoring::Counter& broadcasts;
+    monitoring::Counter& ring_broadcasts;
+};
+
+PublisherMetrics&
+publisher_metrics()
+{
+    auto& registry = monitoring::MetricsRegistry::getInstance();
+    static PublisherMetrics metrics{
+        registry.counter(
+            "nutc_messages_published_total", "Messages sent to a single client"
+        ),
+        registry.counter(
+            "nutc_publish_failures_total", "Messages the egress transport failed to send"
+        ),
+        registry.counter(
+            "nutc_market_data_total", "Matches and orderbook updates broadcast"
+        ),
+        registry.counter(
+            "nutc_market_data_ring_total",
+            "Market data messages written to the shared memory broadcast ring"
+        ),
+    };
+    return metrics;
+}
+} // namespace
+
 bool
 RabbitMQPublisher::publishMessage(
     const std::string& queueName, const std::string& message
 )
 {
-    auto checkReply = [&](amqp_rpc_reply_t reply, const char* errorMsg) -> bool {
-        if (reply.reply_type != AMQP_RESPONSE_NORMAL) {
-            log_e(rabbitmq, "{}", errorMsg);
-            return false;
-        }
-        return true;
-    };
-
-  const auto& conn = RabbitMQConnectionManager::getInstance().get_connection_state();
-
-    
+    PublisherMetrics& metrics = publisher_metrics();
+    metrics.published.inc();
+    bool sent = transport::TransportManager::getInstance().send(queueName, message);
+    if (!sent) [[unlikely]]
+        metrics.failures.inc();
+    return sent;
+}
 
-    if (!checkReply(amqp_get_rpc_reply(conn), "Failed to declare queue.")) {
-        return false;
+bool
+RabbitMQPublisher::broadcastMarketData(
+    const std::vector<std::string>& recipients, const std::string& message,
+    const std::string& ignore_uid
+)
+{
+    auto& transports = transport::TransportManager::getInstance();
+
+    // Co-located clients read the shared ring; everyone else gets their own copy
+    bool broadcasted = transports.broadcast(message, ignore_uid);
+    PublisherMetrics& metrics = publisher_metrics();
+    metrics.broadcasts.inc();
+    if (broadcasted)
+        metrics.ring_broadcasts.inc();
+    for (const auto& uid : recipients) {
+        if (uid == ignore_uid)
+            continue;
+        if (broadcasted && transports.hasBroadcastSubscriber(uid))
+            continue;
+        publishMessage(uid, message);
     }
-
-    amqp_basic_publish(
-        conn, 1, amqp_cstring_bytes(""), amqp_cstring_bytes(queueName.c_str()), 0, 0,
-        nullptr, amqp_cstring_bytes(message.c_str())
-    );
-
-    return checkReply(amqp_get_rpc_reply(conn), "Failed to publish message.");
+    return broadcasted;
 }
 
 void
@@ -40,16 +82,20 @@ RabbitMQPublisher::broadcastMatches(
     const manager::ClientManager& clients, const std::vector<messages::Match>& matches
 )
 {
-    auto broadcastToClient = [&](const auto& client) {
-        for (const auto& match : matches) {
-            std::string buffer;
-            glz::write<glz::opts{}>(match, buffer);
-            publishMessage(client.uid, buffer);
-        }
-    };
+    broadcastMatches(clients.get_active_uids(), matches);
+}
 
-    const auto activeClients = clients.get_clients(true);
-    std::for_each(activeClients.begin(), activeClients.end(), broadcastToClient);
+void
+RabbitMQPublisher::broadcastMatches(
+    const std::vector<std::string>& recipients,
+    const std::vector<messages::Match>& matches
+)
+{
+    std::string buffer;
+    for (const auto& match : matches) {
+        glz::write<glz::opts{}>(match, buffer);
+        broadcastMarketData(recipients, buffer, "");
+    }
 }
 
 void
@@ -58,31 +104,40 @@ RabbitMQPublisher::broadcastObUpdates(
     const std::vector<messages::ObUpdate>& updates, const std::string& ignore_uid
 )
 {
-    auto broadcastToClient = [&](const auto& client) {
-        if (client.uid == ignore_uid) {
-            return;
-        }
-        for (const auto& update : updates) {
-            // if (update.quantity <= 1e-6f) {
-            // continue;
-            // }
-            std::string buffer;
-            glz::write<glz::opts{}>(update, buffer);
-            publishMessage(client.uid, buffer);
-        }
-    };
-
-    const auto activeClients = clients.get_clients(true);
-    std::for_each(activeClients.begin(), activeClients.end(), broadcastToClient);
+    broadcastObUpdates(clients.get_active_uids(), updates, ignore_uid);
 }
 
 void
-RabbitMQPublisher::broadcastAccountUpdate(
+RabbitMQPublisher::broadcastObUpdates(
+    const std::vector<std::string>& recipients,
+    const std::vector<messages::ObUpdate>& updates, const std::string& ignore_uid
+)
+{
+    std::string buffer;
+    bool broadcasted = true;
+    for (const auto& update : updates) {
+        glz::write<glz::opts{}>(update, buffer);
+        broadcasted = broadcastMarketData(recipients, buffer, ignore_uid) && broadcasted;
+    }
+
+    // The placer's algo doesn't hear of its own changes, but its mirrored book must.
+    // Ring readers see the withheld updates; anyone else is sent the level totals
+    if (ignore_uid.empty() || updates.empty())
+        return;
+    auto& transports = transport::TransportManager::getInstance();
+    if (broadcasted && transports.hasBroadcastSubscriber(ignore_uid))
+        return;
+    if (std::find(recipients.begin(), recipients.end(), ignore_uid) == recipients.end())
+        return;
+    glz::write<glz::opts{}>(messages::LevelTotals{updates}, buffer);
+    publishMessage(ignore_uid, buffer);
+}
+
+std::array<std::pair<std::string, messages::AccountUpdate>, 2>
+RabbitMQPublisher::makeAccountUpdates(
     const manager::ClientManager& clients, const messages::Match& match
 )
 {
-    std::string buyer_uid = match.buyer_uid;
-    std::string seller_uid = match.seller_uid;
     messages::AccountUpdate buyer_update = {
         clients.get_capital(match.buyer_uid), match.ticker, messages::SIDE::BUY,
         match.price, match.quantity
@@ -91,13 +146,38 @@ RabbitMQPublisher::broadcastAccountUpdate(
         clients.get_capital(match.seller_uid), match.ticker, messages::SIDE::SELL,
         match.price, match.quantity
     };
+    return {
+        {{match.buyer_uid, buyer_update}, {match.seller_uid, seller_update}}
+    };
+}
 
-    std::string buyer_buffer;
-    std::string seller_buffer;
-    glz::write<glz::opts{}>(buyer_update, buyer_buffer);
-    glz::write<glz::opts{}>(seller_update, seller_buffer);
-    publishMessage(buyer_uid, buyer_buffer);
-    publishMessage(seller_uid, seller_buffer);
+void
+RabbitMQPublisher::publishAccountUpdate(
+    const std::string& uid, const messages::AccountUpdate& update
+)
+{
+    std::string buffer;
+    glz::write<glz::opts{}>(update, buffer);
+    publishMessage(uid, buffer);
+}
+
+void
+RabbitMQPublisher::publishOrderRejected(
+    const std::string& uid, const messages::OrderRejected& rejected
+)
+{
+    std::string buffer;
+    glz::write<glz::opts{}>(rejected, buffer);
+    publishMessage(uid, buffer);
+}
+
+void
+RabbitMQPublisher::broadcastAccountUpdate(
+    const manager::ClientManager& clients, const messages::Match& match
+)
+{
+    for (const auto& [uid, update] : makeAccountUpdates(clients, match))
+        publishAccountUpdate(uid, update);
 }
 
 } // namespace rabbitmq
@@ -3,7 +3,10 @@
 #include "client_manager/client_manager.hpp"
 #include "utils/messages.hpp"
 
+#include <array>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace nutc {
 namespace rabbitmq {
@@ -17,7 +20,8 @@ public:
         const std::vector<messages::Match>& matches
     );
 
-    // ignore uid because we shouldn't send ob update to user who placed order
+    // ignore uid because we shouldn't send ob update to user who placed order; it is
+    // sent the resulting level totals instead, to keep its mirrored book current
     static void broadcastObUpdates(
         const manager::ClientManager& clients,
         const std::vector<messages::ObUpdate>& updates, const std::string& ignore_uid
@@ -25,6 +29,42 @@ public:
     static void broadcastAccountUpdate(
         const manager::ClientManager& clients, const messages::Match& match
     );
+
+    // Overloads for threads that must not touch the ClientManager; recipients is the
+    // list of active client uids
+    static void broadcastMatches(
+        const std::vector<std::string>& recipients,
+        const std::vector<messages::Match>& matches
+    );
+    static void broadcastObUpdates(
+        const std::vector<std::string>& recipients,
+        const std::vector<messages::ObUpdate>& updates, const std::string& ignore_uid
+    );
+
+    /**
+     * @brief Builds the buyer's and seller's account updates for a match
+     * @details Reads capital, so must run on the thread that modifies clients
+     */
+    static std::array<std::pair<std::string, messages::AccountUpdate>, 2>
+    makeAccountUpdates(const manager::ClientManager& clients, const messages::Match& match);
+    static void publishAccountUpdate(
+        const std::string& uid, const messages::AccountUpdate& update
+    );
+
+    /**
+     * @brief Tells a client one of its orders was dropped before matching
+     */
+    static void
+    publishOrderRejected(const std::string& uid, const messages::OrderRejected& rejected);
+
+private:
+    // Serialized once, written to the broadcast ring once, then fanned out over the
+    // broker only to clients that don't read the ring; returns whether it was written
+    // to the ring
+    static bool broadcastMarketData(
+        const std::vector<std::string>& recipients, const std::string& message,
+        const std::string& ignore_uid
+    );
 };
 
 } // namespace rabbitmq
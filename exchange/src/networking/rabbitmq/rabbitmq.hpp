@@ -6,3 +6,4 @@
 #include "order_handler/RabbitMQOrderHandler.hpp"
 #include "publisher/RabbitMQPublisher.hpp"
 #include "queue_manager/RabbitMQQueueManager.hpp"
+#include "transport/RabbitMQTransport.hpp"
@@ -0,0 +1,72 @@
+#include "RabbitMQTransport.hpp"
+
+#include "logging.hpp"
+#include "networking/rabbitmq/connection_manager/RabbitMQConnectionManager.hpp"
+
+#include <sys/time.h>
+
+#include <rabbitmq-c/amqp.h>
+
+namespace nutc {
+namespace rabbitmq {
+
+std::optional<std::string>
+RabbitMQTransport::receive(std::chrono::microseconds timeout)
+{
+    const auto& connection_state =
+        RabbitMQConnectionManager::getInstance().get_connection_state();
+
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    struct timeval tv {};
+    tv.tv_sec = static_cast<time_t>(seconds.count());
+    tv.tv_usec = static_cast<suseconds_t>((timeout - seconds).count());
+
+    amqp_envelope_t envelope;
+    amqp_maybe_release_buffers(connection_state);
+    amqp_rpc_reply_t res = amqp_consume_message(connection_state, &envelope, &tv, 0);
+
+    if (res.reply_type == AMQP_RESPONSE_LIBRARY_EXCEPTION
+        && res.library_error == AMQP_STATUS_TIMEOUT) {
+        return std::nullopt;
+    }
+
+    if (res.reply_type != AMQP_RESPONSE_NORMAL) {
+        log_e(rabbitmq, "Failed to consume message.");
+        return "";
+    }
+
+    std::string message(
+        reinterpret_cast<char*>(envelope.message.body.bytes), envelope.message.body.len
+    );
+    amqp_destroy_envelope(&envelope);
+    return message;
+}
+
+bool
+RabbitMQTransport::send(const std::string& uid, const std::string& message)
+{
+    auto checkReply = [&](amqp_rpc_reply_t reply, const char* errorMsg) -> bool {
+        if (reply.reply_type != AMQP_RESPONSE_NORMAL) {
+            log_e(rabbitmq, "{}", errorMsg);
+            return false;
+        }
+        return true;
+    };
+
+    const auto& conn =
+        RabbitMQConnectionManager::getInstance().get_publish_connection_state();
+
+    if (!checkReply(amqp_get_rpc_reply(conn), "Failed to declare queue.")) {
+        return false;
+    }
+
+    amqp_basic_publish(
+        conn, 1, amqp_cstring_bytes(""), amqp_cstring_bytes(uid.c_str()), 0, 0, nullptr,
+        amqp_cstring_bytes(message.c_str())
+    );
+
+    return checkReply(amqp_get_rpc_reply(conn), "Failed to publish message.");
+}
+
+} // namespace rabbitmq
+} // namespace nutc
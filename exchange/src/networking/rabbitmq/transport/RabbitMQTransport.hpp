@@ -0,0 +1,28 @@
+#pragma once
+
+#include "networking/transport/Transport.hpp"
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace nutc {
+namespace rabbitmq {
+
+/**
+ * @class RabbitMQTransport
+ * @brief Ingress and egress over the broker connection held by
+ * RabbitMQConnectionManager
+ *
+ * Incoming messages are consumed from the market_order queue; outgoing messages are
+ * published to the queue named after the receiving client's uid.
+ */
+class RabbitMQTransport : public transport::IngressTransport,
+                          public transport::EgressTransport {
+public:
+    std::optional<std::string> receive(std::chrono::microseconds timeout) override;
+    bool send(const std::string& uid, const std::string& message) override;
+};
+
+} // namespace rabbitmq
+} // namespace nutc
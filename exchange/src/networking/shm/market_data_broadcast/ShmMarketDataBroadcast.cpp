@@ -0,0 +1,64 @@
+#include "ShmMarketDataBroadcast.hpp"
+
+#include "config.h"
+#include "logging.hpp"
+
+#include <new>
+
+namespace nutc {
+namespace shm {
+
+ShmMarketDataBroadcast::ShmMarketDataBroadcast(
+    shared_memory::SharedMemoryRegion region, MarketDataRing* ring,
+    std::shared_ptr<const ShmOrderIngress> ingress
+) :
+    region(std::move(region)),
+    ring(ring), ingress(std::move(ingress))
+{}
+
+std::optional<ShmMarketDataBroadcast>
+ShmMarketDataBroadcast::create(std::shared_ptr<const ShmOrderIngress> ingress)
+{
+    auto region = shared_memory::SharedMemoryRegion::create(
+        SHM_MARKET_DATA_RING, sizeof(MarketDataRing)
+    );
+    if (!region.has_value()) {
+        log_e(transport, "Failed to create market data ring");
+        return std::nullopt;
+    }
+
+    auto* ring = new (region->data()) MarketDataRing;
+    ring->initialize();
+    log_i(transport, "Created shared memory market data ring {}", SHM_MARKET_DATA_RING);
+    return ShmMarketDataBroadcast{std::move(region.value()), ring, std::move(ingress)};
+}
+
+bool
+ShmMarketDataBroadcast::broadcast(
+    const std::string& message, const std::string& exclude_uid
+)
+{
+    if (!ring->publish(message, exclude_uid)) [[unlikely]] {
+        log_w(
+            transport, "Market data message of {} bytes does not fit in a ring slot",
+            message.size()
+        );
+        return false;
+    }
+    return true;
+}
+
+bool
+ShmMarketDataBroadcast::hasSubscriber(const std::string& uid) const
+{
+    return ingress->isAttached(uid);
+}
+
+uint64_t
+ShmMarketDataBroadcast::nextSequence() const
+{
+    return ring->write_index.load(std::memory_order_relaxed);
+}
+
+} // namespace shm
+} // namespace nutc
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "networking/shm/market_data_ring/MarketDataRing.hpp"
+#include "networking/shm/order_ingress/ShmOrderIngress.hpp"
+#include "networking/transport/Transport.hpp"
+#include "utils/shared_memory/shared_memory.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace nutc {
+namespace shm {
+
+/**
+ * @class ShmMarketDataBroadcast
+ * @brief Writes orderbook updates and matches once into a shared memory ring that every
+ * co-located wrapper reads
+ *
+ * Every client that talks to the exchange through its shared memory order ring also
+ * reads market data from this ring, so the publisher skips the per-client broker
+ * fanout for them.
+ */
+class ShmMarketDataBroadcast : public transport::BroadcastTransport {
+public:
+    /**
+     * @brief Creates the market data ring
+     * @param ingress Decides which clients are co-located subscribers
+     * @return nullopt if the region could not be created
+     */
+    static std::optional<ShmMarketDataBroadcast>
+    create(std::shared_ptr<const ShmOrderIngress> ingress);
+
+    bool broadcast(const std::string& message, const std::string& exclude_uid) override;
+
+    [[nodiscard]] bool hasSubscriber(const std::string& uid) const override;
+
+    [[nodiscard]] uint64_t nextSequence() const override;
+
+private:
+    ShmMarketDataBroadcast(
+        shared_memory::SharedMemoryRegion region, MarketDataRing* ring,
+        std::shared_ptr<const ShmOrderIngress> ingress
+    );
+
+    shared_memory::SharedMemoryRegion region;
+    MarketDataRing* ring;
+    std::shared_ptr<const ShmOrderIngress> ingress;
+};
+
+} // namespace shm
+} // namespace nutc
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace nutc {
+namespace shm {
+
+/**
+ * @brief A single fixed-size slot of the MarketDataRing
+ *
+ * sequence is a seqlock: it is odd while message n = sequence / 2 is being written into
+ * the slot and becomes 2 * (n + 1) once the write is complete. A reader expecting
+ * message n checks the value is exactly 2 * (n + 1) both before and after copying.
+ */
+struct alignas(64) MarketDataSlot {
+    std::atomic<uint64_t> sequence;
+    uint32_t length;
+    uint32_t exclude_length;
+    char exclude_uid[SHM_MARKET_DATA_UID_SIZE];
+    char payload[SHM_MARKET_DATA_SLOT_PAYLOAD];
+};
+
+enum class ReadStatus { OK, EMPTY, OVERRUN };
+
+/**
+ * @brief Single-producer, multi-consumer broadcast ring of serialized market data
+ *
+ * The exchange writes every orderbook update and match exactly once; each co-located
+ * wrapper keeps its own cursor and reads every message. The writer never waits for
+ * readers, so a reader that falls more than CAPACITY messages behind sees
+ * ReadStatus::OVERRUN and must resynchronize from a book snapshot. The layout must stay
+ * byte-compatible with wrapper/src/shm/market_data_ring.hpp.
+ */
+struct MarketDataRing {
+    static constexpr uint64_t MAGIC = 0x544b524d4354554e; // "NUTCMRKT"
+    static constexpr uint32_t LAYOUT_VERSION = 1;
+    static constexpr uint64_t CAPACITY = SHM_MARKET_DATA_SLOTS;
+
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+    static_assert(sizeof(MarketDataSlot) == 256, "slot layout changed");
+    static_assert(
+        std::atomic<uint64_t>::is_always_lock_free,
+        "cross-process atomics must be lock free"
+    );
+
+    std::atomic<uint64_t> magic;
+    uint32_t version;
+    uint32_t capacity;
+
+    // Sequence number of the next message to be written
+    alignas(64) std::atomic<uint64_t> write_index;
+    alignas(64) MarketDataSlot slots[CAPACITY];
+
+    /**
+     * @brief Prepares a freshly created (zero-filled) region for use
+     */
+    void
+    initialize()
+    {
+        version = LAYOUT_VERSION;
+        capacity = static_cast<uint32_t>(CAPACITY);
+        write_index.store(0, std::memory_order_relaxed);
+        for (uint64_t i = 0; i < CAPACITY; i++)
+            slots[i].sequence.store(0, std::memory_order_relaxed);
+        magic.store(MAGIC, std::memory_order_release);
+    }
+
+    [[nodiscard]] bool
+    is_initialized() const
+    {
+        return magic.load(std::memory_order_acquire) == MAGIC && version == LAYOUT_VERSION
+               && capacity == CAPACITY;
+    }
+
+    /**
+     * @brief Appends a message; must only be called by the single writer
+     * @param exclude_uid Client that should skip this message, or empty for none
+     * @return False if the message or uid does not fit in a slot
+     */
+    bool
+    publish(std::string_view message, std::string_view exclude_uid)
+    {
+        if (message.size() > SHM_MARKET_DATA_SLOT_PAYLOAD
+            || exclude_uid.size() > SHM_MARKET_DATA_UID_SIZE) [[unlikely]]
+            return false;
+
+        uint64_t index = write_index.load(std::memory_order_relaxed);
+        MarketDataSlot& slot = slots[index & (CAPACITY - 1)];
+
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.length = static_cast<uint32_t>(message.size());
+        slot.exclude_length = static_cast<uint32_t>(exclude_uid.size());
+        std::memcpy(slot.exclude_uid, exclude_uid.data(), exclude_uid.size());
+        std::memcpy(slot.payload, message.data(), message.size());
+
+        slot.sequence.store(2 * (index + 1), std::memory_order_release);
+        write_index.store(index + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Copies message number index out of the ring; safe from any reader
+     *
+     * @param message Receives the payload on ReadStatus::OK
+     * @param reader_uid Messages withheld from this uid are returned as empty strings
+     * so the reader still advances its cursor past them
+     */
+    ReadStatus
+    read(uint64_t index, std::string& message, std::string_view reader_uid) const
+    {
+        if (index >= write_index.load(std::memory_order_acquire))
+            return ReadStatus::EMPTY;
+
+        const MarketDataSlot& slot = slots[index & (CAPACITY - 1)];
+        uint64_t expected = 2 * (index + 1);
+        if (slot.sequence.load(std::memory_order_acquire) != expected)
+            return ReadStatus::OVERRUN;
+
+        uint32_t length = std::min<uint32_t>(slot.length, SHM_MARKET_DATA_SLOT_PAYLOAD);
+        uint32_t exclude_length =
+            std::min<uint32_t>(slot.exclude_length, SHM_MARKET_DATA_UID_SIZE);
+        bool excluded = !reader_uid.empty()
+                        && std::string_view(slot.exclude_uid, exclude_length) == reader_uid;
+        message.assign(slot.payload, excluded ? 0 : length);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != expected)
+            return ReadStatus::OVERRUN;
+        return ReadStatus::OK;
+    }
+};
+
+} // namespace shm
+} // namespace nutc
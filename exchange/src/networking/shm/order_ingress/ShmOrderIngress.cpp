@@ -0,0 +1,84 @@
+#include "ShmOrderIngress.hpp"
+
+#include "config.h"
+#include "logging.hpp"
+
+#include <new>
+
+namespace nutc {
+namespace shm {
+
+std::string
+ShmOrderIngress::regionName(const std::string& uid)
+{
+    return std::string(SHM_ORDER_RING_PREFIX) + uid;
+}
+
+bool
+ShmOrderIngress::addClient(const std::string& uid)
+{
+    auto region =
+        shared_memory::SharedMemoryRegion::create(regionName(uid), sizeof(OrderRing));
+    if (!region.has_value()) {
+        log_e(transport, "Failed to create order ring for client {}", uid);
+        return false;
+    }
+
+    auto* ring = new (region->data()) OrderRing;
+    ring->initialize();
+    rings.push_back(ClientRing{uid, std::move(region.value()), ring});
+    log_i(transport, "Created shared memory order ring {}", regionName(uid));
+    return true;
+}
+
+bool
+ShmOrderIngress::isAttached(const std::string& uid) const
+{
+    std::lock_guard<std::mutex> lock(attached_mutex);
+    return attached_uids.contains(uid);
+}
+
+std::optional<std::string>
+ShmOrderIngress::pollOnce()
+{
+    // Start at a different ring each call so a busy client can't starve the rest
+    for (size_t i = 0; i < rings.size(); i++) {
+        ClientRing& client_ring = rings[next_ring];
+        next_ring = (next_ring + 1) % rings.size();
+
+        std::optional<std::string> message = client_ring.ring->try_pop();
+        if (!message.has_value())
+            continue;
+        if (message->empty()) [[unlikely]] {
+            log_w(transport, "Dropping malformed message from {}", client_ring.uid);
+            continue;
+        }
+
+        if (!client_ring.attached) [[unlikely]] {
+            client_ring.attached = true;
+            std::lock_guard<std::mutex> lock(attached_mutex);
+            attached_uids.insert(client_ring.uid);
+        }
+        return message;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string>
+ShmOrderIngress::receive(std::chrono::microseconds timeout)
+{
+    if (rings.empty()) [[unlikely]]
+        return std::nullopt;
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    do {
+        std::optional<std::string> message = pollOnce();
+        if (message.has_value())
+            return message;
+    } while (std::chrono::steady_clock::now() < deadline);
+
+    return std::nullopt;
+}
+
+} // namespace shm
+} // namespace nutc
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "networking/shm/order_ring/OrderRing.hpp"
+#include "networking/transport/Transport.hpp"
+#include "utils/shared_memory/shared_memory.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace nutc {
+namespace shm {
+
+/**
+ * @class ShmOrderIngress
+ * @brief Polls the per-client shared memory order rings of co-located wrappers
+ *
+ * The exchange creates one region per locally spawned client before forking it; the
+ * wrapper maps the region by name and pushes its init message and orders into it
+ * instead of publishing them to the broker.
+ */
+class ShmOrderIngress : public transport::IngressTransport {
+public:
+    /**
+     * @brief Creates the shared memory order ring for a client
+     * @return False if the region could not be created
+     */
+    bool addClient(const std::string& uid);
+
+    /**
+     * @brief Whether the given client has sent anything through its ring
+     *
+     * A wrapper only uses its order ring once it has also attached the market data
+     * ring, so this is what decides who is a market data subscriber.
+     */
+    [[nodiscard]] bool isAttached(const std::string& uid) const;
+
+    std::optional<std::string> receive(std::chrono::microseconds timeout) override;
+
+    /**
+     * @brief Name of the shared memory object holding the given client's ring
+     */
+    static std::string regionName(const std::string& uid);
+
+private:
+    struct ClientRing {
+        std::string uid;
+        shared_memory::SharedMemoryRegion region;
+        OrderRing* ring;
+        bool attached = false;
+    };
+
+    std::optional<std::string> pollOnce();
+
+    std::vector<ClientRing> rings;
+    // Written by the receiving thread, read by whichever thread publishes market data
+    mutable std::mutex attached_mutex;
+    std::unordered_set<std::string> attached_uids;
+    size_t next_ring = 0;
+};
+
+} // namespace shm
+} // namespace nutc
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "config.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace nutc {
+/**
+ * @brief Shared memory transports for clients running on the same host as the exchange
+ */
+namespace shm {
+
+/**
+ * @brief A single fixed-size slot of an OrderRing
+ *
+ * sequence follows Vyukov's bounded queue: a slot at position p is free for a producer
+ * when sequence == p and holds a message for the consumer when sequence == p + 1.
+ */
+struct alignas(64) OrderRingSlot {
+    std::atomic<uint64_t> sequence;
+    uint32_t length;
+    char payload[SHM_ORDER_SLOT_PAYLOAD];
+};
+
+/**
+ * @brief Multi-producer, single-consumer ring of serialized client messages
+ *
+ * One ring lives in each client's shared memory region. Any thread of the wrapper may
+ * push; only the exchange pops. The layout must stay byte-compatible with the copy in
+ * the wrapper (wrapper/src/shm/order_ring.hpp), which is checked through MAGIC and
+ * LAYOUT_VERSION when attaching.
+ */
+struct OrderRing {
+    static constexpr uint64_t MAGIC = 0x5244524f4354554e; // "NUTCORDR"
+    static constexpr uint32_t LAYOUT_VERSION = 1;
+    static constexpr uint64_t CAPACITY = SHM_ORDER_RING_SLOTS;
+
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+    static_assert(
+        std::atomic<uint64_t>::is_always_lock_free,
+        "cross-process atomics must be lock free"
+    );
+
+    std::atomic<uint64_t> magic;
+    uint32_t version;
+    uint32_t capacity;
+
+    alignas(64) std::atomic<uint64_t> enqueue_pos;
+    alignas(64) std::atomic<uint64_t> dequeue_pos;
+    alignas(64) OrderRingSlot slots[CAPACITY];
+
+    /**
+     * @brief Prepares a freshly created (zero-filled) region for use
+     */
+    void
+    initialize()
+    {
+        version = LAYOUT_VERSION;
+        capacity = static_cast<uint32_t>(CAPACITY);
+        enqueue_pos.store(0, std::memory_order_relaxed);
+        dequeue_pos.store(0, std::memory_order_relaxed);
+        for (uint64_t i = 0; i < CAPACITY; i++)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        magic.store(MAGIC, std::memory_order_release);
+    }
+
+    [[nodiscard]] bool
+    is_initialized() const
+    {
+        return magic.load(std::memory_order_acquire) == MAGIC && version == LAYOUT_VERSION
+               && capacity == CAPACITY;
+    }
+
+    /**
+     * @brief Pushes a message; safe to call from several producers at once
+     * @return False if the ring is full or the message does not fit in a slot
+     */
+    bool
+    try_push(std::string_view message)
+    {
+        if (message.size() > SHM_ORDER_SLOT_PAYLOAD) [[unlikely]]
+            return false;
+
+        uint64_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        OrderRingSlot* slot;
+        while (true) {
+            slot = &slots[pos & (CAPACITY - 1)];
+            uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed
+                    ))
+                    break;
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->length = static_cast<uint32_t>(message.size());
+        std::memcpy(slot->payload, message.data(), message.size());
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Pops the oldest message; must only be called by the single consumer
+     *
+     * The ring is writable by the client, so a slot claiming to hold more than
+     * SHM_ORDER_SLOT_PAYLOAD bytes is released without being read
+     *
+     * @return The message, an empty string if its slot was invalid, or nullopt if the
+     * ring is empty
+     */
+    std::optional<std::string>
+    try_pop()
+    {
+        uint64_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        OrderRingSlot& slot = slots[pos & (CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+            return std::nullopt;
+
+        uint32_t length = slot.length;
+        std::string message;
+        if (length <= SHM_ORDER_SLOT_PAYLOAD) [[likely]]
+            message.assign(slot.payload, length);
+        slot.sequence.store(pos + CAPACITY, std::memory_order_release);
+        dequeue_pos.store(pos + 1, std::memory_order_relaxed);
+        return message;
+    }
+};
+
+} // namespace shm
+} // namespace nutc
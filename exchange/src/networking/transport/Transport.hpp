@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace nutc {
+/**
+ * @brief Abstracts how messages get between clients and the exchange
+ *
+ * The rest of the exchange only deals in serialized messages addressed by client uid.
+ * RabbitMQ is one implementation; co-located clients can use shared memory instead.
+ */
+namespace transport {
+
+/**
+ * @brief A source of serialized client -> exchange messages (orders, init messages)
+ */
+class IngressTransport {
+public:
+    virtual ~IngressTransport() = default;
+
+    /**
+     * @brief Returns the next message, waiting at most timeout for one to arrive
+     * @param timeout Zero means poll once without blocking
+     * @return The serialized message, nullopt if none arrived in time, or an empty
+     * string if the transport failed
+     */
+    virtual std::optional<std::string> receive(std::chrono::microseconds timeout) = 0;
+};
+
+/**
+ * @brief A sink for serialized exchange -> client messages
+ */
+class EgressTransport {
+public:
+    virtual ~EgressTransport() = default;
+
+    /**
+     * @brief Sends a message to the client with the given uid
+     * @return True if the message was handed off successfully
+     */
+    virtual bool send(const std::string& uid, const std::string& message) = 0;
+};
+
+/**
+ * @brief A one-to-many sink that writes each market data message once for all of its
+ * subscribers
+ */
+class BroadcastTransport {
+public:
+    virtual ~BroadcastTransport() = default;
+
+    /**
+     * @brief Publishes a message to every subscriber except exclude_uid
+     * @return False if the message could not be broadcast and must be sent per client
+     */
+    virtual bool broadcast(const std::string& message, const std::string& exclude_uid) = 0;
+
+    /**
+     * @brief Whether the given client receives market data through this transport
+     */
+    [[nodiscard]] virtual bool hasSubscriber(const std::string& uid) const = 0;
+
+    /**
+     * @brief Sequence number the next broadcast message will be given
+     */
+    [[nodiscard]] virtual uint64_t nextSequence() const = 0;
+};
+
+} // namespace transport
+} // namespace nutc
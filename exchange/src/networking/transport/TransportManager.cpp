@@ -0,0 +1,92 @@
+#include "TransportManager.hpp"
+
+#include "logging.hpp"
+
+namespace nutc {
+namespace transport {
+
+void
+TransportManager::addIngress(std::shared_ptr<IngressTransport> ingress)
+{
+    ingresses.push_back(std::move(ingress));
+}
+
+void
+TransportManager::setEgress(std::shared_ptr<EgressTransport> new_egress)
+{
+    egress = std::move(new_egress);
+}
+
+void
+TransportManager::setBroadcast(std::shared_ptr<BroadcastTransport> broadcast)
+{
+    broadcaster = std::move(broadcast);
+}
+
+void
+TransportManager::reset()
+{
+    ingresses.clear();
+    egress.reset();
+    broadcaster.reset();
+    next_ingress = 0;
+}
+
+std::optional<std::string>
+TransportManager::receive(std::chrono::microseconds timeout)
+{
+    if (ingresses.empty()) [[unlikely]]
+        return std::nullopt;
+
+    // With a single source there is nothing to multiplex, so let it block
+    if (ingresses.size() == 1)
+        return ingresses.front()->receive(timeout);
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    do {
+        for (size_t i = 0; i < ingresses.size(); i++) {
+            auto& ingress = ingresses[next_ingress];
+            next_ingress = (next_ingress + 1) % ingresses.size();
+
+            std::optional<std::string> message =
+                ingress->receive(std::chrono::microseconds(0));
+            if (message.has_value())
+                return message;
+        }
+    } while (std::chrono::steady_clock::now() < deadline);
+
+    return std::nullopt;
+}
+
+bool
+TransportManager::send(const std::string& uid, const std::string& message)
+{
+    if (!egress) [[unlikely]] {
+        log_e(transport, "No egress transport registered, dropping message to {}", uid);
+        return false;
+    }
+    return egress->send(uid, message);
+}
+
+bool
+TransportManager::broadcast(const std::string& message, const std::string& exclude_uid)
+{
+    if (!broadcaster)
+        return false;
+    return broadcaster->broadcast(message, exclude_uid);
+}
+
+bool
+TransportManager::hasBroadcastSubscriber(const std::string& uid) const
+{
+    return broadcaster && broadcaster->hasSubscriber(uid);
+}
+
+uint64_t
+TransportManager::nextBroadcastSequence() const
+{
+    return broadcaster ? broadcaster->nextSequence() : 0;
+}
+
+} // namespace transport
+} // namespace nutc
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "networking/transport/Transport.hpp"
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace nutc {
+namespace transport {
+
+/**
+ * @class TransportManager
+ * @brief Owns the active transports and multiplexes ingress across them
+ *
+ * All incoming messages are pulled through receive(), which polls every registered
+ * ingress in turn so no single source can starve another. All outgoing messages are
+ * pushed through send(), which hands them to the registered egress. Market data for
+ * co-located clients can additionally go through a single broadcast transport.
+ */
+class TransportManager {
+public:
+    TransportManager(const TransportManager&) = delete;
+    TransportManager& operator=(const TransportManager&) = delete;
+    TransportManager(TransportManager&&) = delete;
+    TransportManager& operator=(TransportManager&&) = delete;
+
+    static TransportManager&
+    getInstance()
+    {
+        static TransportManager instance;
+        return instance;
+    }
+
+    void addIngress(std::shared_ptr<IngressTransport> ingress);
+    void setEgress(std::shared_ptr<EgressTransport> egress);
+    void setBroadcast(std::shared_ptr<BroadcastTransport> broadcast);
+
+    /**
+     * @brief Removes all registered transports
+     */
+    void reset();
+
+    /**
+     * @brief Receives the next message from any registered ingress
+     * @param timeout Maximum time to wait for a message
+     */
+    std::optional<std::string> receive(std::chrono::microseconds timeout);
+
+    /**
+     * @brief Sends a message to the given client through the registered egress
+     */
+    bool send(const std::string& uid, const std::string& message);
+
+    /**
+     * @brief Writes a market data message once for every broadcast subscriber
+     * @return False if there is no broadcast transport or it rejected the message, in
+     * which case subscribers must be sent the message individually
+     */
+    bool broadcast(const std::string& message, const std::string& exclude_uid);
+
+    /**
+     * @brief Whether the given client already receives broadcast market data
+     */
+    [[nodiscard]] bool hasBroadcastSubscriber(const std::string& uid) const;
+
+    /**
+     * @brief Sequence number of the next broadcast message, used to tell snapshot
+     * recipients where to resume reading
+     */
+    [[nodiscard]] uint64_t nextBroadcastSequence() const;
+
+private:
+    TransportManager() = default;
+
+    std::vector<std::shared_ptr<IngressTransport>> ingresses;
+    std::shared_ptr<EgressTransport> egress;
+    std::shared_ptr<BroadcastTransport> broadcaster;
+    size_t next_ingress = 0;
+};
+
+} // namespace transport
+} // namespace nutc
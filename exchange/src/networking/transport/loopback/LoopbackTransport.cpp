@@ -0,0 +1,55 @@
+#include "LoopbackTransport.hpp"
+
+namespace nutc {
+namespace transport {
+
+void
+LoopbackTransport::submit(std::string message)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        inbound.push_back(std::move(message));
+    }
+    submitted.notify_one();
+}
+
+std::optional<std::string>
+LoopbackTransport::receive(std::chrono::microseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!submitted.wait_for(lock, timeout, [this] { return !inbound.empty(); }))
+        return std::nullopt;
+
+    std::string message = std::move(inbound.front());
+    inbound.pop_front();
+    return message;
+}
+
+bool
+LoopbackTransport::send(const std::string& uid, const std::string& message)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    outboxes[uid].push_back(message);
+    return true;
+}
+
+std::vector<std::string>
+LoopbackTransport::drain(const std::string& uid)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> messages;
+    auto it = outboxes.find(uid);
+    if (it != outboxes.end())
+        messages.swap(it->second);
+    return messages;
+}
+
+size_t
+LoopbackTransport::pending() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return inbound.size();
+}
+
+} // namespace transport
+} // namespace nutc
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "networking/transport/Transport.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nutc {
+namespace transport {
+
+/**
+ * @class LoopbackTransport
+ * @brief In-process transport for tests and benchmarks that run without a broker
+ *
+ * Simulated clients submit serialized messages with submit(); the exchange receives
+ * them through the IngressTransport interface. Everything the exchange sends is kept in
+ * a per-client outbox that the simulated client drains with drain(). Safe to use from
+ * a client thread and the exchange thread at the same time.
+ */
+class LoopbackTransport : public IngressTransport, public EgressTransport {
+public:
+    /**
+     * @brief Queues a client -> exchange message
+     */
+    void submit(std::string message);
+
+    std::optional<std::string> receive(std::chrono::microseconds timeout) override;
+
+    bool send(const std::string& uid, const std::string& message) override;
+
+    /**
+     * @brief Removes and returns every message sent to the given client so far
+     */
+    std::vector<std::string> drain(const std::string& uid);
+
+    /**
+     * @brief Number of client -> exchange messages not yet received
+     */
+    size_t pending() const;
+
+private:
+    mutable std::mutex mutex;
+    std::condition_variable submitted;
+    std::deque<std::string> inbound;
+    std::unordered_map<std::string, std::vector<std::string>> outboxes;
+};
+
+} // namespace transport
+} // namespace nutc
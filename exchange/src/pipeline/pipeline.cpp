@@ -0,0 +1,468 @@
+#include "pipeline.hpp"
+
+#include "leaderboard/leaderboard.hpp"
+#include "logging.hpp"
+#include "monitoring/state_publisher.hpp"
+#include "networking/rabbitmq/client_manager/RabbitMQClientManager.hpp"
+#include "networking/rabbitmq/consumer/RabbitMQConsumer.hpp"
+#include "networking/rabbitmq/order_handler/RabbitMQOrderHandler.hpp"
+#include "networking/rabbitmq/publisher/RabbitMQPublisher.hpp"
+#include "networking/transport/TransportManager.hpp"
+#include "process_spawning/isolation.hpp"
+#include "process_spawning/supervisor.hpp"
+#include "tracing/trace.hpp"
+#include "utils/logger/logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace nutc {
+namespace pipeline {
+
+namespace {
+using latency::now_ns;
+
+constexpr const char*
+stage_name(size_t stage)
+{
+    constexpr std::array<const char*, NUM_STAGES> names{
+        "decode", "risk", "match", "publish"
+    };
+    return names[stage];
+}
+} // namespace
+
+void
+StageStats::record(uint64_t wait, uint64_t busy, uint64_t occupancy)
+{
+    // Single writer, so plain load/store is enough
+    processed.store(processed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    wait_ns.store(wait_ns.load(std::memory_order_relaxed) + wait, std::memory_order_relaxed);
+    busy_ns.store(busy_ns.load(std::memory_order_relaxed) + busy, std::memory_order_relaxed);
+    occupancy_sum.store(
+        occupancy_sum.load(std::memory_order_relaxed) + occupancy,
+        std::memory_order_relaxed
+    );
+    if (busy > max_busy_ns.load(std::memory_order_relaxed))
+        max_busy_ns.store(busy, std::memory_order_relaxed);
+    if (occupancy > max_occupancy.load(std::memory_order_relaxed))
+        max_occupancy.store(occupancy, std::memory_order_relaxed);
+}
+
+Pipeline::Pipeline(
+    manager::ClientManager& clients, engine_manager::Manager& engine_manager
+) :
+    clients(clients),
+    engine_manager(engine_manager), active_uids(clients.get_active_uids()),
+    known_uids([&clients] {
+        std::unordered_set<std::string> uids;
+        for (bool active : {true, false}) {
+            for (const auto& client : clients.get_clients(active))
+                uids.insert(client.uid);
+        }
+        return uids;
+    }()),
+    tickers([&engine_manager] {
+        auto list = engine_manager.get_tickers();
+        return std::unordered_set<std::string>(list.begin(), list.end());
+    }())
+{
+    // Decode reads the transports rather than a ring, so it has no depth of its own
+    auto& registry = monitoring::MetricsRegistry::getInstance();
+    for (size_t stage = 1; stage < NUM_STAGES; stage++) {
+        queue_depths[stage] = &registry.gauge(
+            "nutc_pipeline_queue_depth", "Items waiting in front of a pipeline stage",
+            monitoring::label("stage", stage_name(stage))
+        );
+    }
+}
+
+Pipeline::~Pipeline()
+{
+    stop();
+}
+
+void
+Pipeline::start()
+{
+    if (running.exchange(true))
+        return;
+
+    log_i(pipeline, "Starting pipeline with {} active clients", active_uids.size());
+    threads.emplace_back(&Pipeline::run_decode, this);
+    threads.emplace_back(&Pipeline::run_risk, this);
+    threads.emplace_back(&Pipeline::run_match, this);
+    threads.emplace_back(&Pipeline::run_publish, this);
+}
+
+void
+Pipeline::stop()
+{
+    running.store(false);
+    for (auto& thread : threads) {
+        if (thread.joinable())
+            thread.join();
+    }
+    threads.clear();
+}
+
+template <typename Ring, typename Item>
+bool
+Pipeline::push(Ring& ring, Item& item)
+{
+    while (!ring.try_push(item)) {
+        if (!running.load(std::memory_order_relaxed)) [[unlikely]]
+            return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+void
+Pipeline::run_decode()
+{
+    TRACE_THREAD_NAME("pipeline decode");
+    client::ClientIsolation::getInstance().pin_hot_thread(2);
+    auto& transports = transport::TransportManager::getInstance();
+    StageStats& stage_stats = stats[static_cast<size_t>(Stage::DECODE)];
+    // Shared with the legacy consumer loop, only one of them runs
+    auto& metrics = rabbitmq::RabbitMQConsumer::getMetrics();
+
+    while (running.load(std::memory_order_relaxed)) {
+        std::optional<std::string> buf =
+            transports.receive(std::chrono::microseconds(INGRESS_POLL_TIMEOUT_US));
+        if (!buf.has_value())
+            continue;
+
+        uint64_t start = now_ns();
+        metrics.received.inc();
+        Decoded item = [&buf] {
+            TRACE_SPAN(decode_span, "decode");
+            return Decoded{decode(buf.value()), 0, {}};
+        }();
+        uint64_t end = now_ns();
+        stage_stats.record(0, end - start, 0);
+        if (std::holds_alternative<rate_limiting::Rejection>(item.message)) [[unlikely]]
+            metrics.throttled.inc();
+        else if (std::holds_alternative<messages::RMQError>(item.message)) [[unlikely]]
+            metrics.decode_errors.inc();
+
+        item.enqueued_ns = end;
+        item.timestamps.received_ns = start;
+        item.timestamps.decoded_ns = end;
+        push(decoded, item);
+    }
+}
+
+Pipeline::IncomingMessage
+Pipeline::decode(const std::string& buf)
+{
+    auto rejection = rate_limiting::OrderThrottle::getInstance().check(buf);
+    if (rejection.has_value()) [[unlikely]]
+        return std::move(rejection.value());
+
+    return std::visit(
+        [](auto&& message) -> IncomingMessage { return std::move(message); },
+        rabbitmq::RabbitMQConsumer::decodeMessage(buf)
+    );
+}
+
+bool
+Pipeline::passes_risk_checks(const messages::MarketOrder& order) const
+{
+    if (!known_uids.contains(order.client_uid)) {
+        log_w(pipeline, "Rejecting order from unknown client {}", order.client_uid);
+        return false;
+    }
+    if (!tickers.contains(order.ticker)) {
+        log_w(
+            pipeline, "Rejecting order from {} for unknown ticker {}", order.client_uid,
+            order.ticker
+        );
+        return false;
+    }
+    if (!std::isfinite(order.price) || !std::isfinite(order.quantity)
+        || order.price <= 0 || order.quantity <= 0) {
+        log_w(
+            pipeline, "Rejecting order from {} with price {} and quantity {}",
+            order.client_uid, order.price, order.quantity
+        );
+        return false;
+    }
+    return true;
+}
+
+void
+Pipeline::run_risk()
+{
+    TRACE_THREAD_NAME("pipeline risk");
+    client::ClientIsolation::getInstance().pin_hot_thread(3);
+    StageStats& stage_stats = stats[static_cast<size_t>(Stage::RISK)];
+    monitoring::Gauge& queue_depth = *queue_depths[static_cast<size_t>(Stage::RISK)];
+
+    while (running.load(std::memory_order_relaxed)) {
+        size_t occupancy = decoded.size();
+        queue_depth.set(static_cast<double>(occupancy));
+        std::optional<Decoded> item = decoded.try_pop();
+        if (!item.has_value()) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        uint64_t start = now_ns();
+        bool forward = std::visit(
+            [&](const auto& message) {
+                using T = std::decay_t<decltype(message)>;
+                if constexpr (std::is_same_v<T, messages::MarketOrder>) {
+                    return passes_risk_checks(message);
+                }
+                else if constexpr (std::is_same_v<T, messages::SnapshotRequest>
+                                   || std::is_same_v<T, rate_limiting::Rejection>) {
+                    return true;
+                }
+                else if constexpr (std::is_same_v<T, messages::InitMessage>) {
+                    // Stragglers and restarted clients
+                    return message.ready;
+                }
+                else if constexpr (std::is_same_v<T, messages::RMQError>) {
+                    log_e(pipeline, "Received RMQError: {}", message.message);
+                    return false;
+                }
+            },
+            item->message
+        );
+        uint64_t end = now_ns();
+        stage_stats.record(start - item->enqueued_ns, end - start, occupancy);
+
+        if (forward) {
+            item->enqueued_ns = end;
+            push(checked, item.value());
+        }
+    }
+}
+
+Pipeline::Outbound
+Pipeline::match(messages::MarketOrder& order, const latency::OrderTimestamps& timestamps)
+{
+    OrderResult result;
+    result.placer_uid = order.client_uid;
+    result.ticker = order.ticker;
+    result.order_index = order.order_index;
+    result.timestamps = timestamps;
+
+    // Risk already rejected unknown tickers
+    TRACE_SPAN(match_span, "match");
+    TRACE_ARG(match_span, order.order_index);
+    auto& engine = engine_manager.get_engine(order.ticker).value().get();
+    auto [matches, ob_updates] = engine.match_order(order, clients);
+
+    // Capital must be read here, before the next order changes it
+    for (const auto& match : matches) {
+        for (auto& update : rabbitmq::RabbitMQPublisher::makeAccountUpdates(clients, match))
+            result.account_updates.push_back(std::move(update));
+    }
+    result.matches = std::move(matches);
+    result.ob_updates = std::move(ob_updates);
+    result.timestamps.matched_ns = now_ns();
+    return Outbound{std::move(result), 0};
+}
+
+Pipeline::Outbound
+Pipeline::snapshot(const messages::SnapshotRequest& request)
+{
+    return Outbound{
+        SnapshotReply{
+                      request.requester_uid,
+                      rabbitmq::RabbitMQOrderHandler::buildSnapshot(engine_manager)
+        },
+        0
+    };
+}
+
+void
+Pipeline::run_match()
+{
+    TRACE_THREAD_NAME("pipeline match");
+    client::ClientIsolation::getInstance().pin_hot_thread(0);
+    StageStats& stage_stats = stats[static_cast<size_t>(Stage::MATCH)];
+    monitoring::Gauge& queue_depth = *queue_depths[static_cast<size_t>(Stage::MATCH)];
+    leaderboard::SnapshotWriter leaderboard(
+        LEADERBOARD_FILE, std::chrono::seconds(LEADERBOARD_INTERVAL_SECS), LEADERBOARD_SIZE
+    );
+    auto state = monitoring::StatePublisher::create();
+    auto& supervisor = client::Supervisor::getInstance();
+
+    while (running.load(std::memory_order_relaxed)) {
+        leaderboard.maybe_write(clients);
+        if (state.has_value())
+            state->maybe_publish(clients, engine_manager);
+        if (supervisor.has_exited()) [[unlikely]] {
+            for (auto& uid : supervisor.take_exited()) {
+                clients.set_inactive(uid);
+                Outbound change{RosterChange{std::move(uid), false}, now_ns()};
+                push(outbound, change);
+            }
+        }
+
+        size_t occupancy = checked.size();
+        queue_depth.set(static_cast<double>(occupancy));
+        std::optional<Decoded> item = checked.try_pop();
+        if (!item.has_value()) {
+            // Idle, so the journal is written out rather than waiting for more events
+            events::Logger::get_logger().flush();
+            std::this_thread::yield();
+            continue;
+        }
+
+        uint64_t start = now_ns();
+        std::optional<Outbound> result;
+        if (auto* order = std::get_if<messages::MarketOrder>(&item->message))
+            result = match(*order, item->timestamps);
+        else if (auto* request = std::get_if<messages::SnapshotRequest>(&item->message))
+            result = snapshot(*request);
+        else if (auto* rejection = std::get_if<rate_limiting::Rejection>(&item->message))
+            result = Outbound{std::move(*rejection), 0};
+        else if (auto* init = std::get_if<messages::InitMessage>(&item->message))
+            result = join(*init);
+        uint64_t end = now_ns();
+        stage_stats.record(start - item->enqueued_ns, end - start, occupancy);
+
+        if (result.has_value()) {
+            result->enqueued_ns = end;
+            push(outbound, result.value());
+        }
+    }
+}
+
+std::optional<Pipeline::Outbound>
+Pipeline::join(const messages::InitMessage& init)
+{
+    if (!known_uids.contains(init.client_uid))
+        return std::nullopt;
+    // Repeats from a client already trading would be unthrottled snapshots
+    auto client = clients.get_client_id(init.client_uid);
+    if (!client.has_value() || clients.get_client(client.value()).active)
+        return std::nullopt;
+    log_i(pipeline, "Client {} joined late", init.client_uid);
+    clients.set_active(init.client_uid);
+
+    // The roster change (and so the start time) follows the snapshot, and both
+    // precede anything matched after this
+    Outbound reply = snapshot(messages::SnapshotRequest{init.client_uid});
+    reply.enqueued_ns = now_ns();
+    push(outbound, reply);
+    return Outbound{RosterChange{init.client_uid, true}, 0};
+}
+
+void
+Pipeline::update_roster(const RosterChange& change)
+{
+    auto existing = std::find(active_uids.begin(), active_uids.end(), change.uid);
+    if (!change.active) {
+        if (existing != active_uids.end()) {
+            std::iter_swap(existing, active_uids.end() - 1);
+            active_uids.pop_back();
+        }
+        return;
+    }
+    if (existing == active_uids.end())
+        active_uids.push_back(change.uid);
+    rabbitmq::RabbitMQClientManager::sendStartTime(change.uid, 0);
+}
+
+void
+Pipeline::publish(Outbound& item)
+{
+    using rabbitmq::RabbitMQPublisher;
+
+    if (auto* reply = std::get_if<SnapshotReply>(&item.result)) {
+        // Everything matched before the request has been broadcast by now
+        reply->snapshot.sequence =
+            transport::TransportManager::getInstance().nextBroadcastSequence();
+        std::string buffer;
+        glz::write<glz::opts{}>(reply->snapshot, buffer);
+        RabbitMQPublisher::publishMessage(reply->requester_uid, buffer);
+        return;
+    }
+    if (auto* rejection = std::get_if<rate_limiting::Rejection>(&item.result)) {
+        RabbitMQPublisher::publishOrderRejected(rejection->client_uid, rejection->message);
+        return;
+    }
+    if (auto* change = std::get_if<RosterChange>(&item.result)) {
+        update_roster(*change);
+        return;
+    }
+
+    auto& result = std::get<OrderResult>(item.result);
+    TRACE_SPAN(publish_span, "publish");
+    TRACE_ARG(publish_span, result.order_index);
+    for (const auto& [uid, update] : result.account_updates)
+        RabbitMQPublisher::publishAccountUpdate(uid, update);
+    if (!result.matches.empty())
+        RabbitMQPublisher::broadcastMatches(active_uids, result.matches);
+    if (!result.ob_updates.empty()) {
+        RabbitMQPublisher::broadcastObUpdates(
+            active_uids, result.ob_updates, result.placer_uid
+        );
+    }
+
+    result.timestamps.published_ns = now_ns();
+    latency::OrderLatency::getInstance().record(result.timestamps, result.ticker);
+    rabbitmq::RabbitMQConsumer::getMetrics().handle_seconds.observe(
+        static_cast<double>(
+            result.timestamps.published_ns - result.timestamps.received_ns
+        )
+        / 1e9
+    );
+}
+
+void
+Pipeline::run_publish()
+{
+    TRACE_THREAD_NAME("pipeline publish");
+    client::ClientIsolation::getInstance().pin_hot_thread(1);
+    StageStats& stage_stats = stats[static_cast<size_t>(Stage::PUBLISH)];
+    monitoring::Gauge& queue_depth = *queue_depths[static_cast<size_t>(Stage::PUBLISH)];
+
+    while (running.load(std::memory_order_relaxed)) {
+        size_t occupancy = outbound.size();
+        queue_depth.set(static_cast<double>(occupancy));
+        std::optional<Outbound> item = outbound.try_pop();
+        if (!item.has_value()) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        uint64_t start = now_ns();
+        publish(item.value());
+        stage_stats.record(start - item->enqueued_ns, now_ns() - start, occupancy);
+    }
+}
+
+void
+Pipeline::log_stats() const
+{
+    for (size_t stage = 0; stage < NUM_STAGES; stage++) {
+        const StageStats& stage_stats = stats[stage];
+        uint64_t processed = stage_stats.processed.load(std::memory_order_relaxed);
+        if (processed == 0)
+            continue;
+
+        log_i(
+            pipeline,
+            "{}: {} items, avg wait {}ns, avg busy {}ns, max busy {}ns, avg occupancy "
+            "{:.1f}, max occupancy {}",
+            stage_name(stage), processed,
+            stage_stats.wait_ns.load(std::memory_order_relaxed) / processed,
+            stage_stats.busy_ns.load(std::memory_order_relaxed) / processed,
+            stage_stats.max_busy_ns.load(std::memory_order_relaxed),
+            static_cast<double>(stage_stats.occupancy_sum.load(std::memory_order_relaxed))
+                / static_cast<double>(processed),
+            stage_stats.max_occupancy.load(std::memory_order_relaxed)
+        );
+    }
+}
+
+} // namespace pipeline
+} // namespace nutc
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "client_manager/client_manager.hpp"
+#include "config.h"
+#include "latency/order_latency.hpp"
+#include "matching/manager/engine_manager.hpp"
+#include "monitoring/metrics.hpp"
+#include "rate_limiting/order_throttle.hpp"
+#include "utils/concurrency/spsc_ring.hpp"
+#include "utils/messages.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace nutc {
+/**
+ * @brief Multi-threaded alternative to RabbitMQConsumer::handleIncomingMessages
+ */
+namespace pipeline {
+
+/**
+ * @brief Counters a stage updates for every item it handles
+ *
+ * Only the owning stage thread writes; any thread may read.
+ */
+struct StageStats {
+    std::atomic<uint64_t> processed{0};
+    // Time items spent queued in front of this stage
+    std::atomic<uint64_t> wait_ns{0};
+    // Time this stage spent handling items
+    std::atomic<uint64_t> busy_ns{0};
+    std::atomic<uint64_t> max_busy_ns{0};
+    // Input ring occupancy seen when each item was taken
+    std::atomic<uint64_t> occupancy_sum{0};
+    std::atomic<uint64_t> max_occupancy{0};
+
+    void record(uint64_t wait, uint64_t busy, uint64_t occupancy);
+};
+
+enum class Stage { DECODE, RISK, MATCH, PUBLISH };
+inline constexpr size_t NUM_STAGES = 4;
+
+/**
+ * @class Pipeline
+ * @brief Runs the exchange as four threads connected by bounded lock-free rings
+ *
+ * decode:  receives from the registered transports, applies the OrderThrottle and
+ *          parses JSON; throttled orders travel on as rejections so the publish stage
+ *          can notify their client
+ * risk:    rejects orders that can never be valid (unknown ticker or client, bad
+ *          price/quantity) so they don't reach the matching thread
+ * match:   matches orders and captures the resulting account updates; the only thread
+ *          that touches the ClientManager or the engines, so it also writes the
+ *          leaderboard and the monitoring state region
+ * publish: serializes and sends matches, orderbook updates, account updates and
+ *          snapshots, then records each order's lifecycle in OrderLatency
+ *
+ * Each stage pins itself to one of the cores ClientIsolation reserved, the match stage
+ * first.
+ *
+ * The set of active clients is captured when the pipeline is built, once trading
+ * starts. Afterwards the match stage deactivates clients the Supervisor saw exit and
+ * activates late (straggling or restarted) clients when their InitMessage arrives,
+ * passing each change on to the publish stage's roster. A late client is sent a book
+ * snapshot before its start time.
+ *
+ * The egress transport must not share a connection with the ingress (see
+ * RabbitMQConnectionManager::openPublishConnection).
+ */
+class Pipeline {
+public:
+    Pipeline(manager::ClientManager& clients, engine_manager::Manager& engine_manager);
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+    Pipeline(Pipeline&&) = delete;
+    Pipeline& operator=(Pipeline&&) = delete;
+
+    ~Pipeline();
+
+    void start();
+
+    /**
+     * @brief Stops and joins all stage threads; queued items are discarded
+     */
+    void stop();
+
+    [[nodiscard]] const StageStats&
+    get_stats(Stage stage) const
+    {
+        return stats[static_cast<size_t>(stage)];
+    }
+
+    /**
+     * @brief Logs occupancy and latency of every stage
+     */
+    void log_stats() const;
+
+private:
+    using IncomingMessage = std::variant<
+        messages::InitMessage, messages::MarketOrder, messages::SnapshotRequest,
+        messages::RMQError, rate_limiting::Rejection>;
+
+    struct Decoded {
+        IncomingMessage message;
+        uint64_t enqueued_ns = 0;
+        latency::OrderTimestamps timestamps;
+    };
+
+    struct OrderResult {
+        std::string placer_uid;
+        std::string ticker;
+        // Ties the order's trace spans together across stages
+        int64_t order_index;
+        latency::OrderTimestamps timestamps;
+        std::vector<messages::Match> matches;
+        std::vector<messages::ObUpdate> ob_updates;
+        std::vector<std::pair<std::string, messages::AccountUpdate>> account_updates;
+    };
+
+    struct SnapshotReply {
+        std::string requester_uid;
+        // sequence is filled in by the publish stage, once everything matched before
+        // the request has been broadcast
+        messages::BookSnapshot snapshot;
+    };
+
+    // A client joined or left after the pipeline was built
+    struct RosterChange {
+        std::string uid;
+        bool active;
+    };
+
+    struct Outbound {
+        std::variant<OrderResult, SnapshotReply, rate_limiting::Rejection, RosterChange>
+            result;
+        uint64_t enqueued_ns = 0;
+    };
+
+    using DecodedRing = concurrency::SpscRing<Decoded, PIPELINE_RING_SLOTS>;
+    using OutboundRing = concurrency::SpscRing<Outbound, PIPELINE_RING_SLOTS>;
+
+    void run_decode();
+    void run_risk();
+    void run_match();
+    void run_publish();
+
+    static IncomingMessage decode(const std::string& buf);
+    bool passes_risk_checks(const messages::MarketOrder& order) const;
+    Outbound match(messages::MarketOrder& order, const latency::OrderTimestamps& timestamps);
+    Outbound snapshot(const messages::SnapshotRequest& request);
+    std::optional<Outbound> join(const messages::InitMessage& init);
+    void update_roster(const RosterChange& change);
+    void publish(Outbound& outbound);
+
+    // Blocks (while running) until the ring accepts the item
+    template <typename Ring, typename Item>
+    bool push(Ring& ring, Item& item);
+
+    manager::ClientManager& clients;
+    engine_manager::Manager& engine_manager;
+    // Fanout roster; after start, only the publish stage touches it
+    std::vector<std::string> active_uids;
+    // Every client, including those that haven't joined yet
+    const std::unordered_set<std::string> known_uids;
+    const std::unordered_set<std::string> tickers;
+
+    DecodedRing decoded;
+    DecodedRing checked;
+    OutboundRing outbound;
+
+    std::array<StageStats, NUM_STAGES> stats;
+    // Items waiting in front of each stage, as last seen by that stage
+    std::array<monitoring::Gauge*, NUM_STAGES> queue_depths{};
+    std::atomic<bool> running{false};
+    std::vector<std::thread> threads;
+};
+
+} // namespace pipeline
+} // namespace nutc
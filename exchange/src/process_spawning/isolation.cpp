@@ -0,0 +1,527 @@
+#include "process_spawning/isolation.hpp"
+
+#include "config.h"
+#include "logging.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace nutc {
+namespace client {
+
+namespace {
+constexpr const char* CGROUP_MOUNT = "/sys/fs/cgroup";
+constexpr uint64_t CPU_PERIOD_US = 100000;
+// Killed clients leave their groups asynchronously; 10ms apart
+constexpr int CGROUP_RELEASE_ATTEMPTS = 50;
+
+std::optional<std::string>
+read_file(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+        return std::nullopt;
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+bool
+write_file(const std::string& path, const std::string& value)
+{
+    std::ofstream file(path);
+    file << value;
+    file.flush();
+    return static_cast<bool>(file);
+}
+
+template <typename T>
+std::optional<T>
+parse_number(std::string_view text)
+{
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+        text.remove_prefix(1);
+    T value{};
+    auto [end, err] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (err != std::errc{})
+        return std::nullopt;
+    return value;
+}
+
+// The value on the line starting with key in a "key value" file, like cpu.stat or
+// /proc/<pid>/status
+std::optional<uint64_t>
+find_field(std::string_view contents, std::string_view key)
+{
+    size_t pos = 0;
+    while (pos < contents.size()) {
+        size_t end = contents.find('\n', pos);
+        if (end == std::string_view::npos)
+            end = contents.size();
+        std::string_view line = contents.substr(pos, end - pos);
+        if (line.starts_with(key) && line.size() > key.size()
+            && (line[key.size()] == ' ' || line[key.size()] == '\t')) {
+            return parse_number<uint64_t>(line.substr(key.size() + 1));
+        }
+        pos = end + 1;
+    }
+    return std::nullopt;
+}
+
+std::vector<int>
+allowed_cores()
+{
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    std::vector<int> cores;
+    if (sched_getaffinity(0, sizeof(mask), &mask) != 0)
+        return cores;
+    for (int core = 0; core < CPU_SETSIZE; core++) {
+        if (CPU_ISSET(core, &mask))
+            cores.push_back(core);
+    }
+    return cores;
+}
+
+cpu_set_t
+to_mask(const std::vector<int>& cores)
+{
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int core : cores)
+        CPU_SET(core, &mask);
+    return mask;
+}
+
+std::string
+join(const std::vector<int>& cores)
+{
+    std::string joined;
+    for (int core : cores)
+        joined += (joined.empty() ? "" : ",") + std::to_string(core);
+    return joined;
+}
+
+// Nice and affinity are per thread, so every thread of a running process is changed
+std::vector<pid_t>
+threads_of(pid_t pid)
+{
+    std::vector<pid_t> threads;
+    std::error_code err;
+    std::filesystem::directory_iterator tasks(fmt::format("/proc/{}/task", pid), err);
+    for (; !err && tasks != std::filesystem::directory_iterator(); tasks.increment(err)) {
+        auto tid = parse_number<pid_t>(tasks->path().filename().string());
+        if (tid.has_value())
+            threads.push_back(tid.value());
+    }
+    if (threads.empty())
+        threads.push_back(pid);
+    return threads;
+}
+} // namespace
+
+std::string
+cgroup_name(const std::string& uid)
+{
+    // Everything but letters and digits is hex escaped, '_' included, so no two uids
+    // share a group
+    std::string name = "nutc_client_";
+    for (char chr : uid) {
+        auto byte = static_cast<unsigned char>(chr);
+        if (std::isalnum(byte))
+            name += chr;
+        else
+            name += fmt::format("_{:02x}", byte);
+    }
+    return name;
+}
+
+void
+apply_limits(const PreparedLimits& limits)
+{
+    bool joined = false;
+    if (!limits.cgroup_procs.empty()) {
+        int fd = open(limits.cgroup_procs.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            joined = write(fd, "0", 1) == 1;
+            close(fd);
+        }
+    }
+    if (!joined && limits.memory.has_value()) {
+        setrlimit(RLIMIT_AS, &limits.memory.value());
+        setpriority(PRIO_PROCESS, 0, limits.nice);
+    }
+    if (limits.cores.has_value())
+        sched_setaffinity(0, sizeof(cpu_set_t), &limits.cores.value());
+}
+
+std::optional<CoreSplit>
+split_cores(const std::vector<int>& allowed, size_t reserved)
+{
+    if (reserved == 0 || allowed.size() <= reserved)
+        return std::nullopt;
+    auto middle = allowed.begin() + static_cast<std::ptrdiff_t>(reserved);
+    return CoreSplit{{allowed.begin(), middle}, {middle, allowed.end()}};
+}
+
+std::optional<uint64_t>
+parse_cpu_stat_usec(std::string_view cpu_stat)
+{
+    return find_field(cpu_stat, "usage_usec");
+}
+
+std::optional<ClientUsage>
+read_proc_usage(pid_t pid)
+{
+    auto stat = read_file(fmt::format("/proc/{}/stat", pid));
+    auto status = read_file(fmt::format("/proc/{}/status", pid));
+    if (!stat.has_value() || !status.has_value())
+        return std::nullopt;
+
+    // comm may contain spaces; fields are counted from the ')' that closes it.
+    // utime and stime are fields 14 and 15, the 12th and 13th after comm
+    size_t pos = stat->rfind(')');
+    if (pos == std::string::npos)
+        return std::nullopt;
+    std::istringstream fields(stat->substr(pos + 1));
+    std::string field;
+    uint64_t ticks = 0;
+    for (int index = 3; index <= 15 && fields >> field; index++) {
+        if (index >= 14)
+            ticks += parse_number<uint64_t>(field).value_or(0);
+    }
+
+    // Both in kB
+    std::optional<uint64_t> memory_kb = find_field(status.value(), "VmHWM:");
+    if (!memory_kb.has_value())
+        memory_kb = find_field(status.value(), "VmRSS:");
+
+    static const auto ticks_per_second = static_cast<double>(sysconf(_SC_CLK_TCK));
+    return ClientUsage{
+        static_cast<double>(ticks) / ticks_per_second, memory_kb.value_or(0) * 1024
+    };
+}
+
+void
+ClientIsolation::configure(const ClientLimits& client_limits, size_t reserved_cores)
+{
+    limits = client_limits;
+    configured = true;
+
+    if (setup_cgroups()) {
+        log_i(
+            client_spawning, "Clients get their own cgroup under {} ({} cores, {}MB)",
+            cgroup_root, limits.cpu_quota, limits.memory_bytes / (1024 * 1024)
+        );
+    }
+    else {
+        log_w(
+            client_spawning,
+            "cgroup v2 delegation unavailable, limiting clients with nice {} and a "
+            "{}MB address space",
+            CLIENT_NICE, limits.memory_bytes / (1024 * 1024)
+        );
+    }
+
+    std::vector<int> allowed = allowed_cores();
+    cores = split_cores(allowed, reserved_cores);
+    if (cores.has_value()) {
+        client_mask = to_mask(cores->clients);
+        log_i(
+            client_spawning, "Reserved cores {} for the exchange, clients run on {}",
+            join(cores->exchange), join(cores->clients)
+        );
+    }
+    else {
+        log_w(
+            client_spawning, "Only {} cores available, not reserving {} for the exchange",
+            allowed.size(), reserved_cores
+        );
+    }
+}
+
+bool
+ClientIsolation::setup_cgroups()
+{
+    if (!std::filesystem::exists(std::string(CGROUP_MOUNT) + "/cgroup.controllers"))
+        return false;
+
+    // Unified hierarchy only: "0::/path"
+    auto self = read_file("/proc/self/cgroup");
+    if (!self.has_value())
+        return false;
+    size_t pos = self->find("0::");
+    if (pos == std::string::npos)
+        return false;
+    std::string relative = self->substr(pos + 3, self->find('\n', pos) - pos - 3);
+    std::string base = std::string(CGROUP_MOUNT) + (relative == "/" ? "" : relative);
+
+    // A group with processes in it can't hand controllers to its children, so the
+    // exchange moves into a leaf of its own first
+    std::error_code err;
+    std::string exchange_group = base + "/nutc_exchange";
+    std::filesystem::create_directory(exchange_group, err);
+    if (err || !write_file(exchange_group + "/cgroup.procs", "0")) {
+        log_d(client_spawning, "Could not move the exchange into {}", exchange_group);
+        return false;
+    }
+    if (!write_file(base + "/cgroup.subtree_control", "+cpu +memory")) {
+        log_d(client_spawning, "Could not enable cpu and memory controllers in {}", base);
+        return false;
+    }
+    cgroup_root = base;
+    return true;
+}
+
+bool
+ClientIsolation::create_client_cgroup(const std::string& path) const
+{
+    std::error_code err;
+    std::filesystem::create_directory(path, err);
+    if (err)
+        return false;
+
+    auto quota = static_cast<uint64_t>(std::llround(limits.cpu_quota * CPU_PERIOD_US));
+    return write_file(path + "/cpu.max", fmt::format("{} {}", quota, CPU_PERIOD_US))
+           && write_file(path + "/memory.max", std::to_string(limits.memory_bytes));
+}
+
+std::optional<PreparedLimits>
+ClientIsolation::prepare_shared() const
+{
+    if (!configured)
+        return std::nullopt;
+    PreparedLimits prepared{"", "", "", std::nullopt, 0, client_mask};
+    if (!uses_cgroups()) {
+        prepared.memory = rlimit{limits.memory_bytes, limits.memory_bytes};
+        prepared.nice = CLIENT_NICE;
+    }
+    return prepared;
+}
+
+std::optional<PreparedLimits>
+ClientIsolation::prepare(const std::string& uid) const
+{
+    std::optional<PreparedLimits> prepared = prepare_shared();
+    if (!prepared.has_value())
+        return std::nullopt;
+    prepared->uid = uid;
+    if (!uses_cgroups())
+        return prepared;
+
+    std::string path = cgroup_root + "/" + cgroup_name(uid);
+    if (create_client_cgroup(path)) {
+        prepared->cgroup_procs = path + "/cgroup.procs";
+        prepared->cgroup = std::move(path);
+    }
+    else {
+        log_w(client_spawning, "Failed to create {} for client {}", path, uid);
+        prepared->memory = rlimit{limits.memory_bytes, limits.memory_bytes};
+        prepared->nice = CLIENT_NICE;
+    }
+    return prepared;
+}
+
+void
+ClientIsolation::track(const PreparedLimits& prepared, pid_t pid)
+{
+    add_client({prepared.uid, pid, prepared.cgroup});
+}
+
+void
+ClientIsolation::isolate(const std::string& uid, pid_t pid)
+{
+    if (!configured)
+        return;
+
+    IsolatedClient client{uid, pid, ""};
+    if (uses_cgroups()) {
+        // Joining moves every thread of the process
+        std::string path = cgroup_root + "/" + cgroup_name(uid);
+        if (create_client_cgroup(path)
+            && write_file(path + "/cgroup.procs", std::to_string(pid)))
+            client.cgroup = std::move(path);
+        else
+            log_w(client_spawning, "Failed to place client {} in {}", uid, path);
+    }
+    bool fallback = client.cgroup.empty();
+    if (fallback) {
+        rlimit memory{limits.memory_bytes, limits.memory_bytes};
+        if (prlimit(pid, RLIMIT_AS, &memory, nullptr) != 0) {
+            log_w(
+                client_spawning, "Failed to limit memory of client {}: {}", uid,
+                std::strerror(errno)
+            );
+        }
+    }
+
+    // Threads the client starts later inherit the nice value and mask
+    for (pid_t thread : threads_of(pid)) {
+        if (fallback)
+            setpriority(PRIO_PROCESS, static_cast<id_t>(thread), CLIENT_NICE);
+        if (client_mask.has_value()
+            && sched_setaffinity(thread, sizeof(cpu_set_t), &client_mask.value()) != 0) {
+            log_w(
+                client_spawning, "Failed to keep client {} off reserved cores: {}", uid,
+                std::strerror(errno)
+            );
+        }
+    }
+    add_client(std::move(client));
+}
+
+void
+ClientIsolation::add_client(IsolatedClient client)
+{
+    // A restarted client replaces its predecessor
+    std::lock_guard<std::mutex> lock(clients_mutex);
+    auto existing = std::find_if(clients.begin(), clients.end(), [&](const auto& other) {
+        return other.uid == client.uid;
+    });
+    if (existing != clients.end())
+        *existing = std::move(client);
+    else
+        clients.push_back(std::move(client));
+}
+
+void
+ClientIsolation::release()
+{
+    std::vector<std::string> groups;
+    std::vector<pid_t> ungrouped;
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex);
+        for (const auto& client : clients) {
+            if (client.cgroup.empty())
+                ungrouped.push_back(client.pid);
+            else
+                groups.push_back(client.cgroup);
+        }
+        clients.clear();
+    }
+
+    // Clients under the rlimit fallback have no group to empty
+    for (pid_t pid : ungrouped)
+        kill(pid, SIGKILL);
+
+    // A group can only be removed once it is empty
+    for (const auto& group : groups) {
+        std::istringstream procs(read_file(group + "/cgroup.procs").value_or(""));
+        pid_t pid = 0;
+        while (procs >> pid)
+            kill(pid, SIGKILL);
+    }
+    for (int attempt = 0; attempt < CGROUP_RELEASE_ATTEMPTS && !groups.empty();
+         attempt++) {
+        std::erase_if(groups, [](const std::string& group) {
+            return rmdir(group.c_str()) == 0 || errno == ENOENT;
+        });
+        if (!groups.empty())
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    for (const auto& group : groups)
+        log_w(client_spawning, "Failed to remove {}: {}", group, std::strerror(errno));
+}
+
+void
+ClientIsolation::pin_hot_thread(size_t slot) const
+{
+    if (!cores.has_value())
+        return;
+    int core = cores->exchange[slot % cores->exchange.size()];
+    cpu_set_t mask = to_mask({core});
+    if (sched_setaffinity(0, sizeof(mask), &mask) != 0)
+        log_w(client_spawning, "Failed to pin thread to core {}", core);
+}
+
+std::optional<ClientUsage>
+ClientIsolation::read_usage(const IsolatedClient& client) const
+{
+    if (client.cgroup.empty())
+        return read_proc_usage(client.pid);
+
+    auto cpu_stat = read_file(client.cgroup + "/cpu.stat");
+    if (!cpu_stat.has_value())
+        return std::nullopt;
+    // memory.peak needs Linux 5.19
+    auto memory = read_file(client.cgroup + "/memory.peak");
+    if (!memory.has_value())
+        memory = read_file(client.cgroup + "/memory.current");
+    return ClientUsage{
+        static_cast<double>(parse_cpu_stat_usec(cpu_stat.value()).value_or(0)) / 1e6,
+        memory.has_value() ? parse_number<uint64_t>(memory.value()).value_or(0) : 0
+    };
+}
+
+std::optional<ClientUsage>
+ClientIsolation::get_usage(const std::string& uid) const
+{
+    std::lock_guard<std::mutex> lock(clients_mutex);
+    auto client = std::find_if(clients.begin(), clients.end(), [&uid](const auto& c) {
+        return c.uid == uid;
+    });
+    if (client == clients.end())
+        return std::nullopt;
+    return read_usage(*client);
+}
+
+void
+ClientIsolation::log_usage() const
+{
+    std::vector<std::pair<std::string, ClientUsage>> usages;
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex);
+        for (const auto& client : clients) {
+            auto usage = read_usage(client);
+            if (usage.has_value())
+                usages.emplace_back(client.uid, usage.value());
+        }
+    }
+    if (usages.empty())
+        return;
+
+    double total_cpu = 0;
+    uint64_t total_memory = 0;
+    for (const auto& [uid, usage] : usages) {
+        total_cpu += usage.cpu_seconds;
+        total_memory += usage.memory_bytes;
+    }
+    log_i(
+        client_spawning, "{} clients used {:.1f}s of CPU and {}MB of memory",
+        usages.size(), total_cpu, total_memory / (1024 * 1024)
+    );
+
+    size_t shown = std::min<size_t>(CLIENT_USAGE_REPORT_SIZE, usages.size());
+    std::partial_sort(
+        usages.begin(), usages.begin() + static_cast<std::ptrdiff_t>(shown), usages.end(),
+        [](const auto& lhs, const auto& rhs) {
+            return lhs.second.cpu_seconds > rhs.second.cpu_seconds;
+        }
+    );
+    for (size_t i = 0; i < shown; i++) {
+        const auto& [uid, usage] = usages[i];
+        log_i(
+            client_spawning, "  {}: {:.2f}s CPU, {}MB", uid, usage.cpu_seconds,
+            usage.memory_bytes / (1024 * 1024)
+        );
+    }
+}
+
+} // namespace client
+} // namespace nutc
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nutc {
+namespace client {
+
+struct ClientLimits {
+    // Cores' worth of CPU time per client
+    double cpu_quota;
+    uint64_t memory_bytes;
+};
+
+struct ClientUsage {
+    double cpu_seconds;
+    // Peak where the kernel tracks it, otherwise current
+    uint64_t memory_bytes;
+};
+
+/**
+ * @brief Which cores the exchange keeps for itself and which clients may use
+ */
+struct CoreSplit {
+    std::vector<int> exchange;
+    std::vector<int> clients;
+};
+
+/**
+ * @brief Limits set up for a client before it starts, which the new process applies to
+ * itself between fork and exec so nothing it runs is ever unlimited
+ */
+struct PreparedLimits {
+    std::string uid;
+    // The client's group, empty to fall back to nice and an rlimit
+    std::string cgroup;
+    // cgroup.procs of that group
+    std::string cgroup_procs;
+    // Applied only without a group
+    std::optional<rlimit> memory;
+    int nice;
+    std::optional<cpu_set_t> cores;
+};
+
+/**
+ * @brief Moves the calling process into prepared limits, falling back to nice and the
+ * rlimit if it can't join the cgroup
+ * @details Makes only async-signal-safe calls, so a child forked from a multithreaded
+ * process may call it before exec
+ */
+void apply_limits(const PreparedLimits& limits);
+
+/**
+ * @brief Name of a client's cgroup; distinct uids always get distinct names
+ */
+std::string cgroup_name(const std::string& uid);
+
+/**
+ * @brief Reserves the first `reserved` of the allowed cores for the exchange
+ * @return nullopt if that would leave clients without a core
+ */
+std::optional<CoreSplit> split_cores(const std::vector<int>& allowed, size_t reserved);
+
+/**
+ * @brief Parses usage_usec out of a cgroup's cpu.stat
+ */
+std::optional<uint64_t> parse_cpu_stat_usec(std::string_view cpu_stat);
+
+/**
+ * @brief CPU time and peak resident memory of a process, from /proc
+ */
+std::optional<ClientUsage> read_proc_usage(pid_t pid);
+
+/**
+ * @class ClientIsolation
+ * @brief Keeps clients from taking CPU and memory away from the exchange
+ *
+ * Every client gets its own cgroup v2 group (a sibling of the exchange's, under the
+ * cgroup the exchange was started in) with a CPU quota and memory limit. Where cgroups
+ * can't be delegated, clients are niced and get an address space rlimit instead.
+ * Either way clients are kept off the cores reserved for the exchange's hot threads,
+ * which pin themselves with pin_hot_thread. Limits are prepared before a client is
+ * spawned and applied by the client process before it execs.
+ *
+ * Does nothing until configured.
+ */
+class ClientIsolation {
+public:
+    ClientIsolation(const ClientIsolation&) = delete;
+    ClientIsolation& operator=(const ClientIsolation&) = delete;
+    ClientIsolation(ClientIsolation&&) = delete;
+    ClientIsolation& operator=(ClientIsolation&&) = delete;
+
+    static ClientIsolation&
+    getInstance()
+    {
+        static ClientIsolation instance;
+        return instance;
+    }
+
+    /**
+     * @brief Sets up the cgroups (or the fallback) and reserves cores; call before
+     * spawning clients or starting hot threads
+     */
+    void configure(const ClientLimits& limits, size_t reserved_cores);
+
+    /**
+     * @brief Creates a client's cgroup with its limits, for the client to join before
+     * exec (see apply_limits)
+     * @return nullopt if isolation isn't configured
+     * @details Safe to call from several spawning threads at once, as is track
+     */
+    std::optional<PreparedLimits> prepare(const std::string& uid) const;
+
+    /**
+     * @brief Limits for a process that forks clients, which its children inherit until
+     * they are isolated: the core mask and fallback limits, but no cgroup
+     */
+    std::optional<PreparedLimits> prepare_shared() const;
+
+    /**
+     * @brief Records a client started with prepared limits, for usage reports and
+     * release
+     */
+    void track(const PreparedLimits& limits, pid_t pid);
+
+    /**
+     * @brief Applies the limits and core mask to a client that is already running
+     * @details For clients forked by the zygote; every thread of the process is
+     * covered. Safe to call from several threads at once
+     */
+    void isolate(const std::string& uid, pid_t pid);
+
+    /**
+     * @brief Kills whatever is left in the client cgroups and removes them
+     * @details Clients isolated with the rlimit fallback are killed by pid
+     */
+    void release();
+
+    /**
+     * @brief Pins the calling thread to one of the reserved cores
+     * @param slot Threads with different slots get different cores while there are
+     * enough; the most latency sensitive thread should use 0
+     */
+    void pin_hot_thread(size_t slot) const;
+
+    [[nodiscard]] std::optional<ClientUsage> get_usage(const std::string& uid) const;
+
+    /**
+     * @brief Logs the CLIENT_USAGE_REPORT_SIZE clients that have used the most CPU
+     */
+    void log_usage() const;
+
+    [[nodiscard]] bool
+    uses_cgroups() const
+    {
+        return !cgroup_root.empty();
+    }
+
+private:
+    ClientIsolation() = default;
+
+    struct IsolatedClient {
+        std::string uid;
+        pid_t pid;
+        // Empty when isolated with the rlimit fallback
+        std::string cgroup;
+    };
+
+    bool setup_cgroups();
+    bool create_client_cgroup(const std::string& path) const;
+    void add_client(IsolatedClient client);
+    [[nodiscard]] std::optional<ClientUsage> read_usage(const IsolatedClient& client
+    ) const;
+
+    bool configured = false;
+    ClientLimits limits{};
+    // Directory client groups are created in; empty if cgroups are unavailable
+    std::string cgroup_root;
+    std::optional<CoreSplit> cores;
+    std::optional<cpu_set_t> client_mask;
+
+    mutable std::mutex clients_mutex;
+    std::vector<IsolatedClient> clients;
+};
+
+} // namespace client
+} // namespace nutc
@@ -1,18 +1,246 @@
 #include "process_spawning/spawning.hpp"
 
 #include "config.h"
-#include "utils/dev_mode/dev_mode.hpp"
 #include "logging.hpp"
+#include "process_spawning/isolation.hpp"
+#include "process_spawning/supervisor.hpp"
+#include "utils/dev_mode/dev_mode.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ; // NOLINT(readability-redundant-declaration)
 
 namespace nutc {
 namespace client {
 
+namespace {
+std::vector<std::string>
+client_args(bool development_mode)
+{
+    std::vector<std::string> args{"NUTC-client"};
+    if (development_mode)
+        args.emplace_back("--dev");
+    if (CONFLATE_CLIENT_UPDATES)
+        args.emplace_back("--conflate");
+    if (ALLOW_NATIVE_STRATEGIES)
+        args.emplace_back("--native");
+    return args;
+}
+
+// Resolved before forking, since the child may only make async-signal-safe calls
+std::optional<std::string>
+find_executable(const std::string& name)
+{
+    if (name.find('/') != std::string::npos)
+        return access(name.c_str(), X_OK) == 0 ? std::optional(name) : std::nullopt;
+    const char* path = std::getenv("PATH");
+    std::string_view directories = path == nullptr ? "/usr/bin:/bin" : path;
+    while (true) {
+        size_t colon = directories.find(':');
+        std::string directory(directories.substr(0, colon));
+        std::string candidate = (directory.empty() ? "." : directory) + "/" + name;
+        if (access(candidate.c_str(), X_OK) == 0)
+            return candidate;
+        if (colon == std::string_view::npos)
+            return std::nullopt;
+        directories.remove_prefix(colon + 1);
+    }
+}
+
+// Forks and execs rather than posix_spawn, so the child can apply its limits before
+// running anything. redirects are (from, to) pairs dup2'd in the child
+std::optional<pid_t>
+spawn_process(
+    std::vector<std::string> args, const std::vector<std::pair<int, int>>& redirects,
+    const std::optional<PreparedLimits>& limits
+)
+{
+    std::optional<std::string> executable = find_executable(args[0]);
+    if (!executable.has_value()) {
+        log_e(client_spawning, "Failed to execute {}: not found", args[0]);
+        return std::nullopt;
+    }
+    std::vector<char*> c_args;
+    for (auto& arg : args)
+        c_args.push_back(arg.data());
+    c_args.push_back(nullptr);
+
+    // Carries errno back if exec fails; closed by a successful exec
+    std::array<int, 2> status{};
+    if (pipe2(status.data(), O_CLOEXEC) != 0) {
+        log_e(client_spawning, "Failed to create pipe: {}", std::strerror(errno));
+        return std::nullopt;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // The exchange blocks SIGINT on every thread, clients shouldn't inherit that
+        sigset_t none;
+        sigemptyset(&none);
+        sigprocmask(SIG_SETMASK, &none, nullptr);
+        for (auto [from, to] : redirects) {
+            if (from == to)
+                fcntl(to, F_SETFD, 0);
+            else
+                dup2(from, to);
+        }
+        if (limits.has_value())
+            apply_limits(limits.value());
+        execve(executable->c_str(), c_args.data(), environ);
+        int err = errno;
+        (void)!write(status[1], &err, sizeof(err));
+        _exit(127);
+    }
+    close(status[1]);
+    if (pid < 0) {
+        log_e(client_spawning, "Failed to fork {}: {}", args[0], std::strerror(errno));
+        close(status[0]);
+        return std::nullopt;
+    }
+
+    int err = 0;
+    ssize_t bytes = 0;
+    do {
+        bytes = read(status[0], &err, sizeof(err));
+    } while (bytes < 0 && errno == EINTR);
+    close(status[0]);
+    if (bytes == sizeof(err)) {
+        waitpid(pid, nullptr, 0);
+        log_e(client_spawning, "Failed to execute {}: {}", args[0], std::strerror(err));
+        return std::nullopt;
+    }
+    return pid;
+}
+
+// Spawns with the limits prepared for the first uid, and records them
+std::optional<pid_t>
+spawn_isolated(std::vector<std::string> args, const std::string& uid)
+{
+    auto& isolation = ClientIsolation::getInstance();
+    std::optional<PreparedLimits> limits = isolation.prepare(uid);
+    std::optional<pid_t> pid = spawn_process(std::move(args), {}, limits);
+    if (pid.has_value() && limits.has_value())
+        isolation.track(limits.value(), pid.value());
+    return pid;
+}
+
+// Sends the zygote every request while reading its reports, so neither side blocks on
+// a full pipe waiting for the other; each report line is handled as soon as it arrives
+void
+exchange_with_zygote(
+    int request_fd, int report_fd, const std::string& request,
+    const std::function<void(std::string_view)>& on_report
+)
+{
+    if (fcntl(request_fd, F_SETFL, O_NONBLOCK) != 0)
+        log_w(client_spawning, "Failed to make zygote pipe nonblocking");
+
+    std::string reports;
+    std::array<char, 4096> chunk{};
+    size_t written = 0;
+    while (true) {
+        bool writing = request_fd >= 0;
+        std::array<pollfd, 2> fds{{{report_fd, POLLIN, 0}, {request_fd, POLLOUT, 0}}};
+        if (poll(fds.data(), writing ? 2 : 1, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            log_e(client_spawning, "Failed to poll zygote: {}", std::strerror(errno));
+            break;
+        }
+
+        if (writing && fds[1].revents != 0) {
+            ssize_t result =
+                write(request_fd, request.data() + written, request.size() - written);
+            if (result > 0)
+                written += static_cast<size_t>(result);
+            // The zygote exits at EOF, so the requests are closed once all are sent
+            bool failed = result < 0 && errno != EAGAIN && errno != EINTR;
+            if (failed || written == request.size()) {
+                close(request_fd);
+                request_fd = -1;
+            }
+        }
+        if (fds[0].revents != 0) {
+            ssize_t bytes = read(report_fd, chunk.data(), chunk.size());
+            if (bytes < 0 && errno == EINTR)
+                continue;
+            if (bytes <= 0)
+                break;
+            reports.append(chunk.data(), static_cast<size_t>(bytes));
+            size_t line_start = 0;
+            for (size_t end = reports.find('\n'); end != std::string::npos;
+                 line_start = end + 1, end = reports.find('\n', line_start)) {
+                on_report(std::string_view(reports).substr(line_start, end - line_start));
+            }
+            reports.erase(0, line_start);
+        }
+    }
+    if (request_fd >= 0)
+        close(request_fd);
+}
+
+// Concurrent spawns; the slow part of starting a client is the exec, not the
+// spawn call, but hundreds of serial execs still add up
+std::vector<SpawnedClient>
+spawn_in_parallel(const std::vector<ClientLaunch>& clients, bool development_mode)
+{
+    std::vector<std::vector<ClientLaunch>> hosts;
+    for (size_t i = 0; i < clients.size(); i += CLIENTS_PER_HOST) {
+        size_t end = std::min<size_t>(i + CLIENTS_PER_HOST, clients.size());
+        hosts.emplace_back(clients.begin() + i, clients.begin() + end);
+    }
+
+    std::vector<std::optional<pid_t>> pids(hosts.size());
+    size_t num_threads = std::min<size_t>(SPAWN_THREADS, hosts.size());
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (size_t worker = 0; worker < num_threads; worker++) {
+        threads.emplace_back([&, worker] {
+            for (size_t i = worker; i < hosts.size(); i += num_threads)
+                pids[i] = launch_host(hosts[i], development_mode);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    std::vector<SpawnedClient> spawned;
+    for (size_t i = 0; i < hosts.size(); i++) {
+        if (!pids[i].has_value())
+            continue;
+        for (const auto& launch : hosts[i])
+            spawned.push_back({launch.uid, pids[i].value()});
+    }
+    return spawned;
+}
+} // namespace
+
 int
-initialize(manager::ClientManager& users, bool development_mode)
+initialize(
+    manager::ClientManager& users, bool development_mode,
+    shm::ShmOrderIngress* shm_ingress, SpawnMode mode
+)
 {
     if (development_mode) {
         dev_mode::initialize_client_manager(users, DEBUG_NUM_USERS);
-        spawn_all_clients(users, development_mode);
+        spawn_all_clients(users, development_mode, shm_ingress, mode);
         return DEBUG_NUM_USERS;
     }
     else {
@@ -21,8 +249,10 @@ initialize(manager::ClientManager& users, bool development_mode)
         users.initialize_from_firebase(firebase_users);
 
         // Spawn clients
-        const int num_clients =
-            nutc::client::spawn_all_clients(users, development_mode);
+        const auto num_clients = static_cast<int>(
+            nutc::client::spawn_all_clients(users, development_mode, shm_ingress, mode)
+                .size()
+        );
 
         if (num_clients == 0) {
             log_c(client_spawning, "Spawned 0 clients");
@@ -40,46 +270,150 @@ get_all_users()
     return res.get<glz::json_t::object_t>();
 }
 
-int
-spawn_all_clients(const nutc::manager::ClientManager& users, bool development_mode)
+std::vector<SpawnedClient>
+spawn_all_clients(
+    const nutc::manager::ClientManager& users, bool development_mode,
+    shm::ShmOrderIngress* shm_ingress, SpawnMode mode
+)
 {
-    int clients = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    // Rings are created up front, on this thread, so the spawns can run concurrently
+    std::vector<ClientLaunch> launches;
     for (const auto& client : users.get_clients(false)) {
-      const std::string uid = client.uid;
-        log_i(client_spawning, "Spawning client: {}", uid);
-        std::string quote_uid = std::string(uid);
-        std::replace(quote_uid.begin(), quote_uid.end(), '-', ' ');
-        spawn_client(quote_uid, development_mode);
-        clients++;
-    };
-    return clients;
+        bool use_shm = shm_ingress != nullptr && shm_ingress->addClient(client.uid);
+        launches.push_back({client.uid, use_shm});
+    }
+
+    std::vector<SpawnedClient> spawned =
+        mode == SpawnMode::ZYGOTE ? spawn_with_zygote(launches, development_mode)
+                                  : spawn_in_parallel(launches, development_mode);
+    // Every client was isolated as it was spawned
+    auto& supervisor = Supervisor::getInstance();
+    for (const SpawnedClient& client : spawned) {
+        auto launch = std::find_if(launches.begin(), launches.end(), [&](const auto& l) {
+            return l.uid == client.uid;
+        });
+        if (launch != launches.end())
+            supervisor.watch(*launch, client.pid);
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start
+    );
+    log_i(
+        client_spawning, "Spawned {} of {} clients in {}ms ({})", spawned.size(),
+        launches.size(), elapsed.count(), mode == SpawnMode::ZYGOTE ? "zygote" : "exec"
+    );
+    return spawned;
 }
 
-void
-spawn_client(const std::string& uid, bool development_mode)
+std::optional<pid_t>
+spawn_client(const std::string& uid, bool development_mode, bool use_shm)
 {
-    pid_t pid = fork();
-    if (pid == 0) {
-        std::vector<std::string> args = {"NUTC-client", "--uid", uid};
-        if (development_mode) {
-            args.push_back("--dev");
-        }
+    log_i(client_spawning, "Spawning client: {}", uid);
+    std::vector<std::string> args = client_args(development_mode);
+    args.emplace_back("--uid");
+    args.push_back(uid);
+    if (use_shm)
+        args.emplace_back("--shm");
+    return spawn_isolated(std::move(args), uid);
+}
 
-        std::vector<char*> c_args;
-        for (auto& arg : args)
-            c_args.push_back(arg.data());
-        c_args.push_back(nullptr);
+std::optional<pid_t>
+launch_client(const ClientLaunch& launch, bool development_mode)
+{
+    return launch_host({launch}, development_mode);
+}
+
+std::optional<pid_t>
+launch_host(const std::vector<ClientLaunch>& launches, bool development_mode)
+{
+    if (launches.empty())
+        return std::nullopt;
+    if (launches.size() == 1)
+        log_i(client_spawning, "Spawning client: {}", launches.front().uid);
+    else
+        log_i(client_spawning, "Spawning host for {} clients", launches.size());
 
-        execvp(c_args[0], c_args.data());
+    std::vector<std::string> args = client_args(development_mode);
+    args.emplace_back("--uid");
+    bool use_shm = true;
+    for (const auto& launch : launches) {
+        // The wrapper turns spaces back into dashes
+        std::string quote_uid = launch.uid;
+        std::replace(quote_uid.begin(), quote_uid.end(), '-', ' ');
+        args.push_back(std::move(quote_uid));
+        use_shm = use_shm && launch.use_shm;
+    }
+    if (use_shm)
+        args.emplace_back("--shm");
+    // Co-hosted clients share a process, and so a cgroup
+    return spawn_isolated(std::move(args), launches.front().uid);
+}
 
-        log_e(client_spawning, "Failed to execute NUTC-client");
+std::vector<SpawnedClient>
+spawn_with_zygote(const std::vector<ClientLaunch>& clients, bool development_mode)
+{
+    // Clients are the zygote's children; once it exits they should become ours
+    if (prctl(PR_SET_CHILD_SUBREAPER, 1) != 0)
+        log_w(client_spawning, "Failed to become a subreaper: {}", std::strerror(errno));
 
-        exit(1);
+    std::array<int, 2> requests{};
+    std::array<int, 2> reports{};
+    if (pipe2(requests.data(), O_CLOEXEC) != 0 || pipe2(reports.data(), O_CLOEXEC) != 0) {
+        log_e(client_spawning, "Failed to create zygote pipes: {}", std::strerror(errno));
+        return {};
     }
-    else if (pid < 0) {
-        log_e(client_spawning, "Failed to fork");
-        exit(1);
+
+    // Children inherit the zygote's core mask (and fallback limits) until isolated
+    std::vector<std::string> args = client_args(development_mode);
+    args.emplace_back("--zygote");
+    std::optional<pid_t> zygote = spawn_process(
+        std::move(args), {{requests[0], STDIN_FILENO}, {reports[1], ZYGOTE_REPORT_FD}},
+        ClientIsolation::getInstance().prepare_shared()
+    );
+    close(requests[0]);
+    close(reports[1]);
+
+    if (!zygote.has_value()) {
+        close(requests[1]);
+        close(reports[0]);
+        return {};
     }
+    log_i(
+        client_spawning, "Started zygote {} for {} clients", zygote.value(),
+        clients.size()
+    );
+
+    std::string request;
+    for (const auto& client : clients)
+        request += fmt::format("{}\t{}\n", client.uid, client.use_shm ? 1 : 0);
+    // One "<uid>\t<pid>" line per client, then EOF once the zygote exits. Each child
+    // is isolated as soon as it is reported, before it has run much of anything
+    auto& isolation = ClientIsolation::getInstance();
+    std::vector<SpawnedClient> spawned;
+    auto on_report = [&](std::string_view line) {
+        size_t tab = line.find('\t');
+        if (tab == std::string_view::npos)
+            return;
+        pid_t pid = -1;
+        std::string_view pid_field = line.substr(tab + 1);
+        std::from_chars(pid_field.data(), pid_field.data() + pid_field.size(), pid);
+        std::string uid(line.substr(0, tab));
+        if (pid <= 0) {
+            log_e(client_spawning, "Zygote failed to fork client {}", uid);
+            return;
+        }
+        log_i(client_spawning, "Zygote forked client {} as {}", uid, pid);
+        isolation.isolate(uid, pid);
+        spawned.push_back({std::move(uid), pid});
+    };
+    exchange_with_zygote(requests[1], reports[0], request, on_report);
+    close(reports[0]);
+    waitpid(zygote.value(), nullptr, 0);
+    return spawned;
 }
+
 } // namespace client
 } // namespace nutc
@@ -2,23 +2,77 @@
 
 #include "client_manager/client_manager.hpp"
 #include "networking/firebase/firebase.hpp"
+#include "networking/shm/order_ingress/ShmOrderIngress.hpp"
 
 #include <glaze/glaze.hpp>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <optional>
+#include <string>
+#include <vector>
+
 namespace nutc {
 
 /** @brief Contains all functions related to spawning client processes */
 namespace client {
 
+enum class SpawnMode {
+    // One NUTC-client exec per CLIENTS_PER_HOST clients, several at a time
+    EXEC,
+    // One NUTC-client --zygote that imports Python's heavy modules once and forks
+    // every client from itself
+    ZYGOTE
+};
+
+/**
+ * @brief A client process that was started
+ */
+struct SpawnedClient {
+    std::string uid;
+    pid_t pid;
+};
+
+/**
+ * @brief Everything needed to start one client
+ */
+struct ClientLaunch {
+    std::string uid;
+    bool use_shm;
+};
+
 /**
  * @brief Spawns a client process with the given uid
- * Forks and execve's a client process with the given uid
- * Spawns in the binary "NUTC-client", expecting it to be in the $PATH
+ * Spawns the binary "NUTC-client", expecting it to be in the $PATH
+ * @param use_shm Whether the client should send orders through its shared memory ring
+ * @return The client's pid, or nullopt if it could not be started
+ */
+std::optional<pid_t>
+spawn_client(const std::string& uid, bool development_mode, bool use_shm = false);
+
+/**
+ * @brief Spawns one client the way spawn_all_clients does without a zygote
+ * @details Used to restart clients after the zygote is gone
+ */
+std::optional<pid_t> launch_client(const ClientLaunch& launch, bool development_mode);
+
+/**
+ * @brief Spawns one wrapper process that hosts all of the given clients
+ * @details The wrapper uses shared memory only if every client has an order ring
+ * @return The process's pid, or nullopt if it could not be started
+ */
+std::optional<pid_t>
+launch_host(const std::vector<ClientLaunch>& launches, bool development_mode);
+
+/**
+ * @brief Starts a zygote and has it fork every client
+ * @details Makes this process a child subreaper, so clients are reparented to it
+ * (rather than init) once the zygote exits
+ * @return The clients the zygote reported forking
  */
-void spawn_client(const std::string& uid, bool development_mode);
+std::vector<SpawnedClient>
+spawn_with_zygote(const std::vector<ClientLaunch>& clients, bool development_mode);
 
 /**
  * @brief Fetches all users from firebase
@@ -27,12 +81,22 @@ glz::json_t::object_t get_all_users();
 
 /**
  * @brief Spawns all clients in the given ClientManager
+ * @details Without a zygote, clients are grouped CLIENTS_PER_HOST to a process
  * @param users The ClientManager to spawn clients for
- * @returns the number of clients spawned
+ * @param shm_ingress If set, an order ring is created for every client before it is
+ * spawned and the client is told to use it instead of the broker
+ * @details Every client that starts is handed to ClientIsolation and the Supervisor
+ * @returns the clients that were started
  */
-int spawn_all_clients(const nutc::manager::ClientManager& users, bool development_mode);
+std::vector<SpawnedClient> spawn_all_clients(
+    const nutc::manager::ClientManager& users, bool development_mode,
+    shm::ShmOrderIngress* shm_ingress = nullptr, SpawnMode mode = SpawnMode::EXEC
+);
 
-int initialize(manager::ClientManager& users, bool development_mode);
+int initialize(
+    manager::ClientManager& users, bool development_mode,
+    shm::ShmOrderIngress* shm_ingress = nullptr, SpawnMode mode = SpawnMode::EXEC
+);
 
 } // namespace client
 } // namespace nutc
@@ -0,0 +1,338 @@
+#include "process_spawning/supervisor.hpp"
+
+#include "config.h"
+#include "logging.hpp"
+#include "monitoring/metrics.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace nutc {
+namespace client {
+
+namespace {
+struct SupervisorMetrics {
+    monitoring::Counter& exited;
+    monitoring::Counter& killed;
+    monitoring::Counter& restarts;
+};
+
+SupervisorMetrics&
+supervisor_metrics()
+{
+    auto& registry = monitoring::MetricsRegistry::getInstance();
+    static SupervisorMetrics metrics{
+        registry.counter(
+            "nutc_client_exits_total", "Client processes that ended",
+            monitoring::label("reason", "exit")
+        ),
+        registry.counter(
+            "nutc_client_exits_total", "Client processes that ended",
+            monitoring::label("reason", "signal")
+        ),
+        registry.counter("nutc_client_restarts_total", "Client processes restarted"),
+    };
+    return metrics;
+}
+
+int
+open_pidfd(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+} // namespace
+
+std::string
+describe_exit(int status)
+{
+    if (status < 0)
+        return "exited (reaped elsewhere)";
+    if (WIFEXITED(status))
+        return fmt::format("exited with status {}", WEXITSTATUS(status));
+    if (WIFSIGNALED(status)) {
+        return fmt::format(
+            "killed by signal {} ({}){}", WTERMSIG(status), strsignal(WTERMSIG(status)),
+            WCOREDUMP(status) ? ", core dumped" : ""
+        );
+    }
+    return fmt::format("ended with status {}", status);
+}
+
+std::chrono::milliseconds
+restart_backoff(const RestartPolicy& policy, int restarts)
+{
+    std::chrono::milliseconds backoff = policy.initial_backoff;
+    for (int i = 0; i < restarts && backoff < policy.max_backoff; i++)
+        backoff *= 2;
+    return std::min(backoff, policy.max_backoff);
+}
+
+Supervisor::~Supervisor()
+{
+    stop();
+}
+
+bool
+Supervisor::start(const RestartPolicy& restart_policy, Respawn respawn_client)
+{
+    if (running.load())
+        return false;
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd < 0) {
+        log_e(supervision, "Failed to create eventfd: {}", std::strerror(errno));
+        return false;
+    }
+    policy = restart_policy;
+    respawn = std::move(respawn_client);
+    running = true;
+    thread = std::thread(&Supervisor::run, this);
+    return true;
+}
+
+void
+Supervisor::stop()
+{
+    if (!running.exchange(false))
+        return;
+    wake();
+    thread.join();
+    close(wake_fd);
+    wake_fd = -1;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& child : children) {
+        if (child.pidfd >= 0)
+            close(child.pidfd);
+    }
+    children.clear();
+    pending_restarts.clear();
+    exit_records.clear();
+    restarts.clear();
+    exited.clear();
+    pending_exits = false;
+}
+
+void
+Supervisor::wake() const
+{
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = write(wake_fd, &one, sizeof(one));
+}
+
+void
+Supervisor::watch(const ClientLaunch& launch, pid_t pid)
+{
+    if (!running.load())
+        return;
+
+    int pidfd = open_pidfd(pid);
+    if (pidfd < 0 && errno != ENOSYS)
+        log_w(supervision, "Failed to open pidfd for {}: {}", pid, std::strerror(errno));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        children.push_back({launch, pid, pidfd});
+    }
+    wake();
+}
+
+std::vector<std::string>
+Supervisor::take_exited()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    pending_exits.store(false, std::memory_order_relaxed);
+    return std::exchange(exited, {});
+}
+
+std::vector<ExitRecord>
+Supervisor::get_exit_records() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return exit_records;
+}
+
+int
+Supervisor::get_restarts(const std::string& uid) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto restart_count = restarts.find(uid);
+    return restart_count == restarts.end() ? 0 : restart_count->second;
+}
+
+void
+Supervisor::run()
+{
+    while (running.load()) {
+        std::vector<pollfd> fds{
+            {wake_fd, POLLIN, 0}
+        };
+        std::vector<Child> watched;
+        int timeout = -1;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            watched = children;
+            auto now = std::chrono::steady_clock::now();
+            for (const auto& restart : pending_restarts) {
+                auto wait =
+                    std::chrono::ceil<std::chrono::milliseconds>(restart.at - now);
+                int wait_ms = static_cast<int>(std::max<int64_t>(wait.count(), 0));
+                timeout = timeout < 0 ? wait_ms : std::min(timeout, wait_ms);
+            }
+        }
+        for (const auto& child : watched) {
+            if (child.pidfd >= 0)
+                fds.push_back({child.pidfd, POLLIN, 0});
+            else if (timeout < 0 || timeout > SUPERVISOR_POLL_MS)
+                timeout = SUPERVISOR_POLL_MS;
+        }
+
+        poll(fds.data(), fds.size(), timeout);
+        uint64_t wakes = 0;
+        [[maybe_unused]] ssize_t bytes = read(wake_fd, &wakes, sizeof(wakes));
+
+        // A readable pidfd means its process ended; the rest can only be polled
+        std::vector<pid_t> reaped;
+        size_t next_fd = 1;
+        for (const auto& child : watched) {
+            bool ended = child.pidfd < 0;
+            if (child.pidfd >= 0) {
+                ended = (fds[next_fd].revents & POLLIN) != 0;
+                next_fd++;
+            }
+            bool already_reaped =
+                std::find(reaped.begin(), reaped.end(), child.pid) != reaped.end();
+            if (!ended || already_reaped)
+                continue;
+            std::vector<Child> hosted;
+            std::copy_if(
+                watched.begin(), watched.end(), std::back_inserter(hosted),
+                [&child](const Child& other) { return other.pid == child.pid; }
+            );
+            if (try_reap(hosted))
+                reaped.push_back(child.pid);
+        }
+        if (!reaped.empty()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::erase_if(children, [&reaped](const Child& child) {
+                if (std::find(reaped.begin(), reaped.end(), child.pid) == reaped.end())
+                    return false;
+                if (child.pidfd >= 0)
+                    close(child.pidfd);
+                return true;
+            });
+        }
+
+        restart_due(std::chrono::steady_clock::now());
+    }
+}
+
+bool
+Supervisor::try_reap(const std::vector<Child>& hosted)
+{
+    const Child& child = hosted.front();
+    int status = 0;
+    rusage usage{};
+    pid_t result = wait4(child.pid, &status, WNOHANG, &usage);
+    if (result == 0)
+        return false;
+    if (result < 0) {
+        // Not our child (the zygote that forked it is still alive); all that can be
+        // known is that it's gone
+        if (errno != ECHILD || (child.pidfd < 0 && kill(child.pid, 0) == 0))
+            return false;
+        status = -1;
+    }
+
+    SupervisorMetrics& metrics = supervisor_metrics();
+    if (status >= 0 && WIFSIGNALED(status))
+        metrics.killed.inc();
+    else
+        metrics.exited.inc();
+
+    for (const auto& client : hosted) {
+        const std::string& uid = client.launch.uid;
+        ExitRecord record{
+            uid,
+            client.pid,
+            status,
+            static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+                + static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec)
+                      / 1e6,
+            static_cast<uint64_t>(usage.ru_maxrss) * 1024,
+            false
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            int restart_count = restarts[uid];
+            if (respawn && restart_count < policy.max_restarts) {
+                record.restarting = true;
+                auto backoff = restart_backoff(policy, restart_count);
+                pending_restarts.push_back(
+                    {client.launch, std::chrono::steady_clock::now() + backoff}
+                );
+            }
+            exit_records.push_back(record);
+            exited.push_back(uid);
+            pending_exits.store(true, std::memory_order_relaxed);
+        }
+
+        log_w(
+            supervision, "Client {} (pid {}) {} after {:.2f}s of CPU, {}MB peak{}", uid,
+            client.pid, describe_exit(status), record.cpu_seconds,
+            record.max_rss_bytes / (1024 * 1024), record.restarting ? ", restarting" : ""
+        );
+    }
+    return true;
+}
+
+void
+Supervisor::restart_due(std::chrono::steady_clock::time_point now)
+{
+    std::vector<ClientLaunch> due;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::erase_if(pending_restarts, [&](const PendingRestart& restart) {
+            if (restart.at > now)
+                return false;
+            due.push_back(restart.launch);
+            restarts[restart.launch.uid]++;
+            return true;
+        });
+    }
+
+    for (const auto& launch : due) {
+        std::optional<pid_t> pid = respawn(launch);
+        if (!pid.has_value()) {
+            log_e(supervision, "Failed to restart client {}", launch.uid);
+            continue;
+        }
+        supervisor_metrics().restarts.inc();
+        log_i(
+            supervision, "Restarted client {} as {} (restart {} of {})", launch.uid,
+            pid.value(), get_restarts(launch.uid), policy.max_restarts
+        );
+        watch(launch, pid.value());
+    }
+}
+
+} // namespace client
+} // namespace nutc
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "process_spawning/spawning.hpp"
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace nutc {
+namespace client {
+
+/**
+ * @brief Why and how a client process ended
+ */
+struct ExitRecord {
+    std::string uid;
+    pid_t pid;
+    // Raw waitpid status; -1 if the process wasn't ours to reap
+    int status;
+    double cpu_seconds;
+    uint64_t max_rss_bytes;
+    // Whether a replacement was scheduled
+    bool restarting;
+};
+
+/**
+ * @brief "exited with status 1", "killed by signal 11 (Segmentation fault)", ...
+ */
+std::string describe_exit(int status);
+
+struct RestartPolicy {
+    int max_restarts;
+    std::chrono::milliseconds initial_backoff;
+    std::chrono::milliseconds max_backoff;
+};
+
+/**
+ * @brief Delay before a client's nth restart (counting from 0)
+ */
+std::chrono::milliseconds restart_backoff(const RestartPolicy& policy, int restarts);
+
+/**
+ * @class Supervisor
+ * @brief Reaps client processes, reports their exits and restarts them
+ *
+ * A single thread waits on a pidfd per client (or polls waitpid every
+ * SUPERVISOR_POLL_MS where pidfds are unsupported). Clients that exit are reaped,
+ * logged with their exit reason and resource usage, and queued for deactivation.
+ * The thread that owns the ClientManager takes them with take_exited, so they drop out
+ * of the fanout. If a respawn function was given, exited clients are restarted after
+ * an exponential backoff, up to the policy's limit; a restarted client becomes active
+ * again once it sends its InitMessage.
+ *
+ * Clients hosted by the same process are watched with the same pid; when it exits,
+ * each of them is recorded and restarted on its own.
+ *
+ * Watching only starts once the supervisor is started; clients spawned before that
+ * are never reaped.
+ */
+class Supervisor {
+public:
+    // Starts a replacement client, returning its pid
+    using Respawn = std::function<std::optional<pid_t>(const ClientLaunch& launch)>;
+
+    Supervisor(const Supervisor&) = delete;
+    Supervisor& operator=(const Supervisor&) = delete;
+    Supervisor(Supervisor&&) = delete;
+    Supervisor& operator=(Supervisor&&) = delete;
+
+    static Supervisor&
+    getInstance()
+    {
+        static Supervisor instance;
+        return instance;
+    }
+
+    /**
+     * @param respawn If empty, exited clients are not restarted
+     */
+    bool start(const RestartPolicy& policy, Respawn respawn = {});
+
+    /**
+     * @brief Stops watching and forgets every client and exit
+     */
+    void stop();
+
+    /**
+     * @brief Watches a spawned client; safe to call from any thread
+     */
+    void watch(const ClientLaunch& launch, pid_t pid);
+
+    /**
+     * @brief Whether take_exited would return anything; cheap enough for a hot loop
+     */
+    [[nodiscard]] bool
+    has_exited() const
+    {
+        return pending_exits.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief uids of clients that exited since the last call, to be deactivated
+     */
+    std::vector<std::string> take_exited();
+
+    [[nodiscard]] std::vector<ExitRecord> get_exit_records() const;
+
+    [[nodiscard]] int get_restarts(const std::string& uid) const;
+
+private:
+    Supervisor() = default;
+    ~Supervisor();
+
+    struct Child {
+        ClientLaunch launch;
+        pid_t pid;
+        // -1 if pidfds are unsupported
+        int pidfd;
+    };
+
+    struct PendingRestart {
+        ClientLaunch launch;
+        std::chrono::steady_clock::time_point at;
+    };
+
+    void run();
+    // Reaps a process if it has exited, recording an exit for every client it hosted;
+    // true if it's gone
+    bool try_reap(const std::vector<Child>& hosted);
+    void restart_due(std::chrono::steady_clock::time_point now);
+    void wake() const;
+
+    RestartPolicy policy{};
+    Respawn respawn;
+
+    mutable std::mutex mutex;
+    std::vector<Child> children;
+    std::vector<PendingRestart> pending_restarts;
+    std::vector<ExitRecord> exit_records;
+    std::unordered_map<std::string, int> restarts;
+    std::vector<std::string> exited;
+    std::atomic<bool> pending_exits{false};
+
+    // Wakes the supervisor thread when children are added or it should stop
+    int wake_fd = -1;
+    std::atomic<bool> running{false};
+    std::thread thread;
+};
+
+} // namespace client
+} // namespace nutc
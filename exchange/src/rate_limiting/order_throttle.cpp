@@ -0,0 +1,234 @@
+#include "order_throttle.hpp"
+
+#include "config.h"
+#include "logging.hpp"
+
+namespace nutc {
+namespace rate_limiting {
+
+namespace {
+constexpr std::string_view WHITESPACE = " \t\r\n";
+
+// Position of the first character after the key's colon, npos if the key is absent
+size_t
+find_value(std::string_view raw, std::string_view key, size_t from)
+{
+    for (size_t pos = raw.find(key, from); pos != std::string_view::npos;
+         pos = raw.find(key, pos + 1)) {
+        size_t cursor = raw.find_first_not_of(WHITESPACE, pos + key.size());
+        // Same text appearing as a value rather than a key
+        if (cursor == std::string_view::npos || raw[cursor] != ':')
+            continue;
+        return cursor + 1;
+    }
+    return std::string_view::npos;
+}
+
+bool
+has_key(std::string_view raw, std::string_view key)
+{
+    return find_value(raw, key, 0) != std::string_view::npos;
+}
+} // namespace
+
+std::optional<std::string_view>
+peek_string_field(std::string_view raw, std::string_view key)
+{
+    size_t value = find_value(raw, key, 0);
+    if (value == std::string_view::npos)
+        return std::nullopt;
+
+    size_t cursor = raw.find_first_not_of(WHITESPACE, value);
+    if (cursor == std::string_view::npos || raw[cursor] != '"')
+        return std::nullopt;
+
+    size_t end = raw.find('"', cursor + 1);
+    if (end == std::string_view::npos)
+        return std::nullopt;
+    std::string_view field = raw.substr(cursor + 1, end - cursor - 1);
+
+    // The decoder would unescape the value or take another occurrence of the key
+    if (field.find('\\') != std::string_view::npos
+        || find_value(raw, key, end) != std::string_view::npos)
+        return std::nullopt;
+    return field;
+}
+
+void
+OrderThrottle::configure(
+    BucketLimit client_limit, BucketLimit ticker_limit,
+    const std::vector<std::string>& client_uids, const std::vector<std::string>& tickers,
+    time_point now
+)
+{
+    reset();
+    for (const auto& uid : client_uids) {
+        clients.try_emplace(uid, client_limit, now);
+        snapshot_requests.try_emplace(
+            uid, BucketLimit{SNAPSHOT_REQUEST_RATE, SNAPSHOT_REQUEST_BURST}, now
+        );
+    }
+    for (const auto& ticker : tickers)
+        this->tickers.try_emplace(ticker, ticker_limit, now);
+    enabled = true;
+
+    log_i(
+        rate_limiting,
+        "Throttling {} clients at {}/s (burst {}) and {} tickers at {}/s (burst {})",
+        clients.size(), client_limit.rate, client_limit.burst, this->tickers.size(),
+        ticker_limit.rate, ticker_limit.burst
+    );
+}
+
+void
+OrderThrottle::reset()
+{
+    clients.clear();
+    tickers.clear();
+    snapshot_requests.clear();
+    throttled_total.store(0, std::memory_order_relaxed);
+    enabled = false;
+}
+
+std::optional<Rejection>
+OrderThrottle::check(std::string_view raw, time_point now)
+{
+    if (!enabled)
+        return std::nullopt;
+
+    std::optional<std::string_view> requester =
+        peek_string_field(raw, "\"requester_uid\"");
+    std::optional<std::string_view> uid = peek_string_field(raw, "\"client_uid\"");
+    std::optional<std::string_view> ticker = peek_string_field(raw, "\"ticker\"");
+
+    // Read differently here than by the decoder, it could dodge the limits; no valid
+    // message holds an escape sequence, even in its keys
+    bool unreadable = raw.find('\\') != std::string_view::npos
+                      || (!requester.has_value() && has_key(raw, "\"requester_uid\""))
+                      || (!uid.has_value() && has_key(raw, "\"client_uid\""))
+                      || (!ticker.has_value() && has_key(raw, "\"ticker\""));
+    if (unreadable) [[unlikely]] {
+        throttled_total.fetch_add(1, std::memory_order_relaxed);
+        return Rejection{
+            std::string(uid.value_or(requester.value_or(""))),
+            messages::OrderRejected{"malformed message", std::string(ticker.value_or(""))}
+        };
+    }
+
+    if (requester.has_value())
+        return check_snapshot_request(requester.value(), now);
+
+    // Only market orders carry both fields
+    if (!uid.has_value() || !ticker.has_value())
+        return std::nullopt;
+
+    auto client_it = clients.find(uid.value());
+    if (client_it == clients.end()) [[unlikely]]
+        return reject_unknown(uid.value(), ticker.value());
+    auto ticker_it = tickers.find(ticker.value());
+    Entry* client = &client_it->second;
+    Entry* book = ticker_it == tickers.end() ? nullptr : &ticker_it->second;
+
+    const char* reason = nullptr;
+    Entry* offender = nullptr;
+    if (!client->bucket.has_token(now)) {
+        reason = "client order rate limit exceeded";
+        offender = client;
+    }
+    else if (book != nullptr && !book->bucket.has_token(now)) {
+        reason = "ticker order rate limit exceeded";
+        offender = book;
+    }
+
+    if (offender == nullptr) [[likely]] {
+        client->bucket.consume();
+        if (book != nullptr)
+            book->bucket.consume();
+        return std::nullopt;
+    }
+
+    // Warn once per offender; the counters carry the rest
+    if (offender->throttled.fetch_add(1, std::memory_order_relaxed) == 0) {
+        log_w(
+            rate_limiting, "Throttling orders from {} for {}: {}", uid.value(),
+            ticker.value(), reason
+        );
+    }
+    throttled_total.fetch_add(1, std::memory_order_relaxed);
+    return Rejection{
+        std::string(uid.value()), messages::OrderRejected{reason, std::string(ticker.value())}
+    };
+}
+
+std::optional<Rejection>
+OrderThrottle::check_snapshot_request(std::string_view uid, time_point now)
+{
+    auto entry = snapshot_requests.find(uid);
+    if (entry == snapshot_requests.end()) [[unlikely]]
+        return reject_unknown(uid, "");
+
+    TokenBucket& bucket = entry->second.bucket;
+    if (bucket.has_token(now)) [[likely]] {
+        bucket.consume();
+        return std::nullopt;
+    }
+
+    if (entry->second.throttled.fetch_add(1, std::memory_order_relaxed) == 0)
+        log_w(rate_limiting, "Throttling snapshot requests from {}", uid);
+    return Rejection{
+        std::string(uid), messages::OrderRejected{"snapshot request rate limit exceeded", ""}
+    };
+}
+
+Rejection
+OrderThrottle::reject_unknown(std::string_view uid, std::string_view ticker)
+{
+    throttled_total.fetch_add(1, std::memory_order_relaxed);
+    return Rejection{
+        std::string(uid), messages::OrderRejected{"unknown client", std::string(ticker)}
+    };
+}
+
+uint64_t
+OrderThrottle::get_throttled(const EntryMap& entries, std::string_view key)
+{
+    auto entry = entries.find(key);
+    if (entry == entries.end())
+        return 0;
+    return entry->second.throttled.load(std::memory_order_relaxed);
+}
+
+uint64_t
+OrderThrottle::get_throttled_for_client(std::string_view uid) const
+{
+    return get_throttled(clients, uid);
+}
+
+uint64_t
+OrderThrottle::get_throttled_for_ticker(std::string_view ticker) const
+{
+    return get_throttled(tickers, ticker);
+}
+
+void
+OrderThrottle::log_stats() const
+{
+    uint64_t total = get_throttled_total();
+    if (total == 0)
+        return;
+
+    log_i(rate_limiting, "{} orders throttled", total);
+    for (const auto& [uid, entry] : clients) {
+        uint64_t throttled = entry.throttled.load(std::memory_order_relaxed);
+        if (throttled > 0)
+            log_i(rate_limiting, "client {}: {} orders throttled", uid, throttled);
+    }
+    for (const auto& [ticker, entry] : tickers) {
+        uint64_t throttled = entry.throttled.load(std::memory_order_relaxed);
+        if (throttled > 0)
+            log_i(rate_limiting, "ticker {}: {} orders throttled", ticker, throttled);
+    }
+}
+
+} // namespace rate_limiting
+} // namespace nutc
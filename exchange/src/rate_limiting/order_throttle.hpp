@@ -0,0 +1,145 @@
+#pragma once
+
+#include "rate_limiting/token_bucket.hpp"
+#include "utils/messages.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace nutc {
+/**
+ * @brief Exchange-side protection against clients flooding the order path
+ */
+namespace rate_limiting {
+
+/**
+ * @brief An order the throttle dropped, and the message to send its client
+ */
+struct Rejection {
+    std::string client_uid;
+    messages::OrderRejected message;
+};
+
+/**
+ * @class OrderThrottle
+ * @brief Token bucket rate limits per client and per ticker, checked at ingress
+ *
+ * The client and ticker are peeked from the raw message, so a throttled order is never
+ * fully parsed. SnapshotRequests are limited per client as well, with their own buckets
+ * (SNAPSHOT_REQUEST_RATE in config.h), since each one copies every book. Orders and
+ * snapshot requests from clients not registered through configure() are rejected, as
+ * is anything naming a client or ticker the scan can't read the way the decoder would
+ * (escaped or repeated); tickers not registered pass through to be rejected by normal
+ * validation. Nothing a misbehaving client sends grows the bucket tables.
+ *
+ * Disabled until configured. check() must only be called from one thread at a time
+ * (the ingress thread); the counters may be read from any thread.
+ */
+class OrderThrottle {
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    OrderThrottle(const OrderThrottle&) = delete;
+    OrderThrottle& operator=(const OrderThrottle&) = delete;
+    OrderThrottle(OrderThrottle&&) = delete;
+    OrderThrottle& operator=(OrderThrottle&&) = delete;
+
+    static OrderThrottle&
+    getInstance()
+    {
+        static OrderThrottle instance;
+        return instance;
+    }
+
+    /**
+     * @brief Enables throttling for the given clients and tickers, with full buckets
+     */
+    void configure(
+        BucketLimit client_limit, BucketLimit ticker_limit,
+        const std::vector<std::string>& client_uids,
+        const std::vector<std::string>& tickers,
+        time_point now = std::chrono::steady_clock::now()
+    );
+
+    /**
+     * @brief Disables throttling and drops all buckets and counters
+     */
+    void reset();
+
+    /**
+     * @brief Takes a token from the client's and the ticker's bucket if both have one
+     * @param raw The serialized message, as received
+     * @return The rejection to send if the message is an order over either limit, or a
+     * snapshot request over the client's snapshot limit
+     */
+    std::optional<Rejection>
+    check(std::string_view raw, time_point now = std::chrono::steady_clock::now());
+
+    [[nodiscard]] uint64_t
+    get_throttled_total() const
+    {
+        return throttled_total.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t get_throttled_for_client(std::string_view uid) const;
+    [[nodiscard]] uint64_t get_throttled_for_ticker(std::string_view ticker) const;
+
+    /**
+     * @brief Logs how many orders were throttled, per client and per ticker
+     */
+    void log_stats() const;
+
+private:
+    OrderThrottle() = default;
+
+    struct Entry {
+        Entry(BucketLimit limit, time_point now) : bucket(limit, now) {}
+
+        TokenBucket bucket;
+        std::atomic<uint64_t> throttled{0};
+    };
+
+    // Allows lookups by the string_views peeked from raw messages
+    struct StringHash {
+        using is_transparent = void;
+
+        size_t
+        operator()(std::string_view str) const
+        {
+            return std::hash<std::string_view>{}(str);
+        }
+    };
+
+    using EntryMap = std::unordered_map<std::string, Entry, StringHash, std::equal_to<>>;
+
+    static uint64_t get_throttled(const EntryMap& entries, std::string_view key);
+
+    std::optional<Rejection> check_snapshot_request(std::string_view uid, time_point now);
+    Rejection reject_unknown(std::string_view uid, std::string_view ticker);
+
+    // Tables are only rebuilt by configure/reset, never while check() runs
+    EntryMap clients;
+    EntryMap tickers;
+    EntryMap snapshot_requests;
+    std::atomic<uint64_t> throttled_total{0};
+    bool enabled = false;
+};
+
+/**
+ * @brief Finds a string field in a flat serialized message without parsing it
+ * @param key The field name, including its quotes
+ * @return The value, or nullopt if the field is missing, not a string, repeated or
+ * holds an escape sequence
+ */
+std::optional<std::string_view>
+peek_string_field(std::string_view raw, std::string_view key);
+
+} // namespace rate_limiting
+} // namespace nutc
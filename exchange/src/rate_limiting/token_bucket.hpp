@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+namespace nutc {
+namespace rate_limiting {
+
+struct BucketLimit {
+    // Tokens added per second
+    double rate;
+    // Maximum tokens held, i.e. the largest burst allowed after idling
+    double burst;
+};
+
+/**
+ * @class TokenBucket
+ * @brief Classic token bucket; every admitted order takes one token
+ *
+ * Not thread safe. Starts full.
+ */
+class TokenBucket {
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    TokenBucket(BucketLimit limit, time_point now) :
+        limit(limit), tokens(limit.burst), last_refill(now)
+    {}
+
+    /**
+     * @brief Whether a token is available at the given time, without taking it
+     */
+    bool
+    has_token(time_point now)
+    {
+        refill(now);
+        return tokens >= 1.0;
+    }
+
+    /**
+     * @brief Takes a token; only valid right after has_token returned true
+     */
+    void
+    consume()
+    {
+        tokens -= 1.0;
+    }
+
+private:
+    void
+    refill(time_point now)
+    {
+        if (now <= last_refill)
+            return;
+        std::chrono::duration<double> elapsed = now - last_refill;
+        tokens = std::min(limit.burst, tokens + elapsed.count() * limit.rate);
+        last_refill = now;
+    }
+
+    BucketLimit limit;
+    double tokens;
+    time_point last_refill;
+};
+
+} // namespace rate_limiting
+} // namespace nutc
@@ -0,0 +1,148 @@
+#include "trace.hpp"
+
+#include "config.h"
+#include "logging.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+
+namespace nutc {
+namespace tracing {
+
+namespace {
+uint64_t
+steady_ns()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch()
+    )
+                                     .count());
+}
+} // namespace
+
+std::vector<TraceEvent>
+TraceRing::snapshot() const
+{
+    uint64_t end = head.load(std::memory_order_acquire);
+    uint64_t capacity = events.size();
+    uint64_t begin = end > capacity ? end - capacity : 0;
+
+    std::vector<TraceEvent> copy;
+    copy.reserve(end - begin);
+    for (uint64_t position = begin; position < end; position++)
+        copy.push_back(events[position % capacity]);
+
+    // Anything the writer lapped while we copied may be torn, including the slot it
+    // may be writing now (position `now` shares a slot with `now - capacity`)
+    uint64_t now = head.load(std::memory_order_acquire);
+    uint64_t overwritten = now >= capacity ? now - capacity + 1 : 0;
+    if (overwritten > begin) {
+        auto torn = static_cast<ptrdiff_t>(std::min(overwritten - begin, end - begin));
+        copy.erase(copy.begin(), copy.begin() + torn);
+    }
+    return copy;
+}
+
+Tracer::Tracer() : origin_clock(read_clock()), origin_ns(steady_ns()) {}
+
+TraceRing&
+Tracer::thread_ring()
+{
+    thread_local TraceRing* ring = nullptr;
+    if (ring != nullptr) [[likely]]
+        return *ring;
+
+    std::lock_guard guard(rings_mutex);
+    auto tid = static_cast<uint32_t>(rings.size() + 1);
+    rings.push_back(std::make_shared<TraceRing>(tid, TRACE_RING_EVENTS));
+    ring = rings.back().get();
+    ring->name = fmt::format("thread {}", tid);
+    return *ring;
+}
+
+void
+Tracer::set_thread_name(const std::string& name)
+{
+    TraceRing& ring = thread_ring();
+    std::lock_guard guard(rings_mutex);
+    ring.name = name;
+}
+
+void
+Tracer::reset()
+{
+    std::lock_guard guard(rings_mutex);
+    for (auto& ring : rings)
+        ring->clear();
+}
+
+std::string
+Tracer::to_chrome_json() const
+{
+    // Scale ticks by how many passed alongside steady_clock since construction
+    uint64_t elapsed_ticks = read_clock() - origin_clock;
+    uint64_t elapsed_ns = steady_ns() - origin_ns;
+    double ticks_per_us = elapsed_ns == 0 ? 1.0
+                                          : static_cast<double>(elapsed_ticks) * 1000.0
+                                                / static_cast<double>(elapsed_ns);
+    auto to_us = [&](uint64_t ticks) {
+        return static_cast<double>(ticks - origin_clock) / ticks_per_us;
+    };
+
+    std::string out = R"({"displayTimeUnit":"ns","traceEvents":[)";
+    auto inserter = std::back_inserter(out);
+    bool first = true;
+    auto separate = [&] {
+        if (!first)
+            out.push_back(',');
+        first = false;
+    };
+
+    std::lock_guard guard(rings_mutex);
+    for (const auto& ring : rings) {
+        separate();
+        fmt::format_to(
+            inserter, R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},)"
+                      R"("args":{{"name":"{}"}}}})",
+            ring->get_tid(), ring->name
+        );
+
+        for (const TraceEvent& event : ring->snapshot()) {
+            // Spans from before the tracer existed can't be placed
+            if (event.start < origin_clock) [[unlikely]]
+                continue;
+            separate();
+            fmt::format_to(
+                inserter, R"({{"name":"{}","ph":"X","pid":1,"tid":{},"ts":{:.3f},)"
+                          R"("dur":{:.3f})",
+                event.name, ring->get_tid(), to_us(event.start),
+                static_cast<double>(event.end - event.start) / ticks_per_us
+            );
+            if (event.arg >= 0)
+                fmt::format_to(inserter, R"(,"args":{{"order":{}}})", event.arg);
+            out.push_back('}');
+        }
+    }
+    out += "]}";
+    return out;
+}
+
+bool
+Tracer::write_chrome_json(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+        log_e(monitoring, "Failed to open trace file {}", path);
+        return false;
+    }
+    file << to_chrome_json();
+    log_i(monitoring, "Wrote trace spans to {}", path);
+    return true;
+}
+
+} // namespace tracing
+} // namespace nutc
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+#else
+#  include <chrono>
+#endif
+
+namespace nutc {
+/**
+ * @brief Hot path spans recorded into per-thread rings and exported as Chrome trace JSON
+ *
+ * Spans are compiled in only when NUTC_TRACING is defined (cmake
+ * -DNUTC24_ENABLE_TRACING=ON); otherwise the TRACE_* macros expand to nothing. Load
+ * the exported JSON in chrome://tracing or ui.perfetto.dev.
+ */
+namespace tracing {
+
+#ifdef NUTC_TRACING
+inline constexpr bool ENABLED = true;
+#else
+inline constexpr bool ENABLED = false;
+#endif
+
+/**
+ * @brief Timestamp counter ticks where available, nanoseconds otherwise
+ */
+inline uint64_t
+read_clock()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch()
+    )
+                                     .count());
+#endif
+}
+
+struct TraceEvent {
+    // Must outlive the tracer; spans are always named by string literals
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+    // Shown as the event's argument, e.g. the order index; negative for none
+    int64_t arg;
+};
+
+/**
+ * @class TraceRing
+ * @brief Most recent spans of one thread; old spans are overwritten, never waited on
+ *
+ * Only the owning thread records. Any thread may snapshot, at the cost of dropping
+ * the oldest spans if they are being overwritten while it copies; once the ring has
+ * wrapped, the oldest slot is always dropped, since the next record reuses it.
+ */
+class TraceRing {
+public:
+    TraceRing(uint32_t tid, size_t capacity) : tid(tid), events(capacity) {}
+
+    void
+    record(const TraceEvent& event)
+    {
+        uint64_t position = head.load(std::memory_order_relaxed);
+        events[position % events.size()] = event;
+        head.store(position + 1, std::memory_order_release);
+    }
+
+    [[nodiscard]] std::vector<TraceEvent> snapshot() const;
+
+    /**
+     * @brief Drops every span; not safe while the owning thread records
+     */
+    void
+    clear()
+    {
+        head.store(0, std::memory_order_release);
+    }
+
+    [[nodiscard]] uint32_t
+    get_tid() const
+    {
+        return tid;
+    }
+
+    std::string name;
+
+private:
+    const uint32_t tid;
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> head{0};
+};
+
+/**
+ * @class Tracer
+ * @brief Owns every thread's ring and converts clock ticks to wall time on export
+ */
+class Tracer {
+public:
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+    Tracer(Tracer&&) = delete;
+    Tracer& operator=(Tracer&&) = delete;
+
+    static Tracer&
+    getInstance()
+    {
+        static Tracer instance;
+        return instance;
+    }
+
+    void
+    record(const TraceEvent& event)
+    {
+        thread_ring().record(event);
+    }
+
+    /**
+     * @brief Names the calling thread in exported traces
+     */
+    void set_thread_name(const std::string& name);
+
+    /**
+     * @brief Every recorded span, as a Chrome trace ("traceEvents") JSON document
+     */
+    [[nodiscard]] std::string to_chrome_json() const;
+
+    bool write_chrome_json(const std::string& path) const;
+
+    /**
+     * @brief Drops every recorded span; not safe while other threads record
+     */
+    void reset();
+
+private:
+    Tracer();
+
+    TraceRing& thread_ring();
+
+    // Pairs a clock reading with steady_clock, to scale ticks to microseconds
+    const uint64_t origin_clock;
+    const uint64_t origin_ns;
+
+    mutable std::mutex rings_mutex;
+    std::vector<std::shared_ptr<TraceRing>> rings;
+};
+
+/**
+ * @class Span
+ * @brief Records the time between its construction and destruction
+ */
+class Span {
+public:
+    explicit Span(const char* name, int64_t arg = -1) :
+        name(name), arg(arg), start(read_clock())
+    {}
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+    Span(Span&&) = delete;
+    Span& operator=(Span&&) = delete;
+
+    ~Span() { Tracer::getInstance().record({name, start, read_clock(), arg}); }
+
+    void
+    set_arg(int64_t value)
+    {
+        arg = value;
+    }
+
+private:
+    const char* name;
+    int64_t arg;
+    uint64_t start;
+};
+
+} // namespace tracing
+} // namespace nutc
+
+#ifdef NUTC_TRACING
+// Opens a span named by a string literal that closes at the end of the scope
+#  define TRACE_SPAN(var, name) ::nutc::tracing::Span var(name)
+// Attaches a value (e.g. the order index) to an open span
+#  define TRACE_ARG(var, value) (var).set_arg(static_cast<int64_t>(value))
+#  define TRACE_THREAD_NAME(name)                                                   \
+    ::nutc::tracing::Tracer::getInstance().set_thread_name(name)
+#else
+#  define TRACE_SPAN(var, name) ((void)0)
+#  define TRACE_ARG(var, value) ((void)0)
+#  define TRACE_THREAD_NAME(name) ((void)0)
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+namespace nutc {
+namespace concurrency {
+
+/**
+ * @class Spinlock
+ * @brief Test-and-test-and-set lock for critical sections of a few instructions
+ *
+ * Yields while contended rather than burning the core, since the holder may be waiting
+ * for the same one. Padded to a cache line so neighbouring locks don't false share.
+ * Satisfies Lockable, so it works with std::lock_guard and std::scoped_lock.
+ */
+class alignas(64) Spinlock {
+public:
+    void
+    lock()
+    {
+        while (locked.exchange(true, std::memory_order_acquire)) {
+            while (locked.load(std::memory_order_relaxed))
+                std::this_thread::yield();
+        }
+    }
+
+    bool
+    try_lock()
+    {
+        return !locked.load(std::memory_order_relaxed)
+               && !locked.exchange(true, std::memory_order_acquire);
+    }
+
+    void
+    unlock()
+    {
+        locked.store(false, std::memory_order_release);
+    }
+
+private:
+    std::atomic<bool> locked{false};
+};
+
+} // namespace concurrency
+} // namespace nutc
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+namespace nutc {
+/**
+ * @brief Lock-free building blocks for handing work between exchange threads
+ */
+namespace concurrency {
+
+/**
+ * @class SpscRing
+ * @brief Bounded lock-free queue between exactly one producer thread and one consumer
+ * thread
+ *
+ * Each side keeps a cached copy of the other side's index so the shared cache line is
+ * only touched when the ring looks full (producer) or empty (consumer).
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    SpscRing() : slots(std::make_unique<T[]>(Capacity)) {}
+
+    /**
+     * @brief Producer only
+     * @return False (leaving item untouched) if the ring is full
+     */
+    bool
+    try_push(T& item)
+    {
+        size_t tail_pos = tail.load(std::memory_order_relaxed);
+        if (tail_pos - cached_head == Capacity) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (tail_pos - cached_head == Capacity)
+                return false;
+        }
+
+        slots[tail_pos & (Capacity - 1)] = std::move(item);
+        tail.store(tail_pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer only
+     */
+    std::optional<T>
+    try_pop()
+    {
+        size_t head_pos = head.load(std::memory_order_relaxed);
+        if (head_pos == cached_tail) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (head_pos == cached_tail)
+                return std::nullopt;
+        }
+
+        std::optional<T> item{std::move(slots[head_pos & (Capacity - 1)])};
+        head.store(head_pos + 1, std::memory_order_release);
+        return item;
+    }
+
+    /**
+     * @brief Approximate number of queued items; safe from any thread
+     */
+    [[nodiscard]] size_t
+    size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t
+    capacity()
+    {
+        return Capacity;
+    }
+
+private:
+    // Consumer side
+    alignas(64) std::atomic<size_t> head{0};
+    size_t cached_tail = 0;
+
+    // Producer side
+    alignas(64) std::atomic<size_t> tail{0};
+    size_t cached_head = 0;
+
+    alignas(64) std::unique_ptr<T[]> slots;
+};
+
+} // namespace concurrency
+} // namespace nutc
@@ -1,11 +1,14 @@
 #include "utils/logger/logger.hpp" // includes fstream, string, optional
 
+#include "utils/concurrency/spinlock.hpp"
+
 #include <fmt/chrono.h>
 #include <fmt/format.h>
 
 #include <chrono>
 
 #include <iostream>
+#include <iterator>
 
 namespace nutc {
 namespace events {
@@ -17,6 +20,73 @@ Logger::get_logger()
     return logger;
 }
 
+struct Logger::ThreadBuffer {
+    // Only contended when flush_all runs
+    concurrency::Spinlock lock;
+    std::string events;
+    std::chrono::steady_clock::time_point last_write = std::chrono::steady_clock::now();
+
+    ThreadBuffer()
+    {
+        events.reserve(EVENT_LOG_FLUSH_BYTES);
+        Logger& logger = get_logger();
+        std::lock_guard<std::mutex> guard(logger.buffers_mutex_);
+        logger.buffers_.push_back(this);
+    }
+
+    ThreadBuffer(const ThreadBuffer&) = delete;
+    ThreadBuffer& operator=(const ThreadBuffer&) = delete;
+    ThreadBuffer(ThreadBuffer&&) = delete;
+    ThreadBuffer& operator=(ThreadBuffer&&) = delete;
+
+    ~ThreadBuffer()
+    {
+        Logger& logger = get_logger();
+        std::lock_guard<std::mutex> guard(logger.buffers_mutex_);
+        std::erase(logger.buffers_, this);
+        if (!events.empty())
+            logger.write(events);
+    }
+};
+
+Logger::ThreadBuffer&
+Logger::thread_buffer()
+{
+    thread_local ThreadBuffer buffer;
+    return buffer;
+}
+
+void
+Logger::write(std::string& events)
+{
+    std::lock_guard<std::mutex> guard(output_mutex_);
+    output_file_.write(events.data(), static_cast<std::streamsize>(events.size()));
+    events.clear();
+}
+
+void
+Logger::flush()
+{
+    ThreadBuffer& buffer = thread_buffer();
+    std::lock_guard<concurrency::Spinlock> guard(buffer.lock);
+    if (!buffer.events.empty())
+        write(buffer.events);
+    buffer.last_write = std::chrono::steady_clock::now();
+}
+
+void
+Logger::flush_all()
+{
+    std::lock_guard<std::mutex> guard(buffers_mutex_);
+    for (ThreadBuffer* buffer : buffers_) {
+        std::lock_guard<concurrency::Spinlock> buffer_guard(buffer->lock);
+        if (!buffer->events.empty())
+            write(buffer->events);
+    }
+    std::lock_guard<std::mutex> output_guard(output_mutex_);
+    output_file_.flush();
+}
+
 void
 Logger::log_event(
     MESSAGE_TYPE type, const std::string& json_message,
@@ -29,22 +99,25 @@ Logger::log_event(
         return;
     }
 
-    // Write start of JSON
-    output_file_ << "{ ";
-
-    // Write current GMT time
-    const auto now = std::chrono::system_clock::now();
-    output_file_ << fmt::format("\"time\": \"{:%FT%TZ}\", ", now);
+    ThreadBuffer& buffer = thread_buffer();
+    std::lock_guard<concurrency::Spinlock> guard(buffer.lock);
+    auto out = std::back_inserter(buffer.events);
 
-    // Add MessageType and JSON message (and opt UID) to file
-    output_file_ << "\"type\": " << static_cast<int>(type) << ", "; // add type
-    output_file_ << "\"message\": " << json_message;                // add message
+    // Current GMT time, MessageType and JSON message (and opt UID)
+    fmt::format_to(
+        out, "{{ \"time\": \"{:%FT%TZ}\", \"type\": {}, \"message\": {}",
+        std::chrono::system_clock::now(), static_cast<int>(type), json_message
+    );
+    if (uid.has_value())
+        fmt::format_to(out, ", \"uid\": {}", uid.value());
+    buffer.events += " }\n"; // close the brace and end the line
 
-    if (uid.has_value()) {
-        output_file_ << ", \"uid\": " << uid.value(); // add uid if exists
+    auto now = std::chrono::steady_clock::now();
+    if (buffer.events.size() >= EVENT_LOG_FLUSH_BYTES
+        || now - buffer.last_write >= std::chrono::milliseconds(EVENT_LOG_FLUSH_MS)) {
+        write(buffer.events);
+        buffer.last_write = now;
     }
-
-    output_file_ << " }\n"; // close the brace and end the line
 }
 
 } // namespace events
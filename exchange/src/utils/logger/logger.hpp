@@ -5,8 +5,10 @@
 #include "utils/messages.hpp" // TYPE should be an enum {AccountUpdate, OrderbookUpdate, TradeUpdate, MarketOrder}
 
 #include <fstream>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace nutc {
 namespace events {
@@ -28,6 +30,21 @@ class Logger {
      */
     std::ofstream output_file_;
 
+    /**
+     * @brief Keeps chunks of events written by different threads whole
+     */
+    std::mutex output_mutex_;
+
+    // Events a thread has formatted but not yet written
+    struct ThreadBuffer;
+    static ThreadBuffer& thread_buffer();
+
+    // Every live thread's buffer, so they can all be written out at shutdown
+    std::mutex buffers_mutex_;
+    std::vector<ThreadBuffer*> buffers_;
+
+    void write(std::string& events);
+
 public:
     /**
      * @brief Construct a new Logger object
@@ -45,6 +62,12 @@ public:
     /**
      * @brief Log an event to this Logger's file
      *
+     * The event is formatted into a buffer owned by the calling thread, which is
+     * written out in chunks (see EVENT_LOG_FLUSH_BYTES), so threads only contend for
+     * the file once per chunk. Threads that log should call flush() when idle, and
+     * flush_all() before exiting the process; a thread's remaining events are also
+     * written when it exits.
+     *
      * @param type the type of message this is, see `enum MessageType`
      * @param json_message the message to log
      * @param uid optional UID to log with this message
@@ -54,6 +77,17 @@ public:
         const std::optional<std::string>& uid = std::nullopt
     );
 
+    /**
+     * @brief Writes out the events the calling thread has buffered
+     */
+    void flush();
+
+    /**
+     * @brief Writes out the events every thread has buffered, and flushes the file
+     * @details For shutdown, from any thread
+     */
+    void flush_all();
+
     /**
      * @brief Get the file name string
      *
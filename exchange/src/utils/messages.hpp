@@ -3,7 +3,10 @@
 #include <fmt/format.h>
 #include <glaze/glaze.hpp>
 
+#include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <vector>
 
 namespace nutc {
 
@@ -80,8 +83,9 @@ struct MarketOrder {
     static long long
     get_and_increment_global_index()
     {
-        static long long global_index = 0;
-        return global_index++;
+        // Orders may be decoded on a different thread than the one matching them
+        static std::atomic<long long> global_index = 0;
+        return global_index.fetch_add(1, std::memory_order_relaxed);
     }
 
     MarketOrder(
@@ -173,12 +177,17 @@ struct MarketOrder {
 
 /**
  * @brief Sent by exchange to clients to indicate an orderbook update
+ *
+ * quantity is what the order that changed now has resting (0 once it is filled);
+ * level_quantity is the total resting at its price afterwards, so the latest update
+ * for a level supersedes every earlier one
  */
 struct ObUpdate {
     std::string security;
     SIDE side;
     float price;
     float quantity;
+    float level_quantity = 0;
 };
 
 /**
@@ -193,6 +202,42 @@ struct AccountUpdate {
     float quantity;
 };
 
+/**
+ * @brief Sent by a client that lost track of the orderbook (e.g. it was overrun on the
+ * shared memory market data ring) to ask for the current state of every book
+ */
+struct SnapshotRequest {
+    std::string requester_uid;
+};
+
+/**
+ * @brief Sent by exchange to a single client in response to a SnapshotRequest
+ * levels holds every resting price level of every book, aggregated by price. sequence is
+ * the market data ring position the snapshot is consistent with; the client resumes
+ * reading the ring from there
+ */
+struct BookSnapshot {
+    uint64_t sequence;
+    std::vector<ObUpdate> levels;
+};
+
+/**
+ * @brief Sent by exchange to a client whose order was dropped before matching, e.g.
+ * because the client exceeded its order rate limit
+ */
+struct OrderRejected {
+    std::string reject_reason;
+    std::string ticker;
+};
+
+/**
+ * @brief Sent by exchange to the client whose order changed the book, in place of the
+ * ObUpdates withheld from it, so the client's mirrored book stays current
+ */
+struct LevelTotals {
+    std::vector<ObUpdate> level_totals;
+};
+
 } // namespace messages
 } // namespace nutc
 
@@ -202,7 +247,7 @@ struct glz::meta<nutc::messages::ObUpdate> {
     using T = nutc::messages::ObUpdate;
     static constexpr auto value = object(
         "security", &T::security, "side", &T::side, "price", &T::price, "quantity",
-        &T::quantity
+        &T::quantity, "level_quantity", &T::level_quantity
     );
 };
 
@@ -257,3 +302,32 @@ struct glz::meta<nutc::messages::InitMessage> {
     static constexpr auto value =
         object("client_uid", &T::client_uid, "ready", &T::ready);
 };
+
+/// \cond
+template <>
+struct glz::meta<nutc::messages::SnapshotRequest> {
+    using T = nutc::messages::SnapshotRequest;
+    static constexpr auto value = object("requester_uid", &T::requester_uid);
+};
+
+/// \cond
+template <>
+struct glz::meta<nutc::messages::BookSnapshot> {
+    using T = nutc::messages::BookSnapshot;
+    static constexpr auto value = object("sequence", &T::sequence, "levels", &T::levels);
+};
+
+/// \cond
+template <>
+struct glz::meta<nutc::messages::OrderRejected> {
+    using T = nutc::messages::OrderRejected;
+    static constexpr auto value =
+        object("reject_reason", &T::reject_reason, "ticker", &T::ticker);
+};
+
+/// \cond
+template <>
+struct glz::meta<nutc::messages::LevelTotals> {
+    using T = nutc::messages::LevelTotals;
+    static constexpr auto value = object("level_totals", &T::level_totals);
+};
@@ -0,0 +1,104 @@
+#include "utils/shared_memory/shared_memory.hpp"
+
+#include "logging.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace nutc {
+namespace shared_memory {
+
+std::optional<SharedMemoryRegion>
+SharedMemoryRegion::create(const std::string& name, size_t size)
+{
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd < 0) {
+        log_e(shared_memory, "shm_open({}) failed: {}", name, std::strerror(errno));
+        return std::nullopt;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        log_e(shared_memory, "ftruncate({}) failed: {}", name, std::strerror(errno));
+        close(fd);
+        shm_unlink(name.c_str());
+        return std::nullopt;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        log_e(shared_memory, "mmap({}) failed: {}", name, std::strerror(errno));
+        shm_unlink(name.c_str());
+        return std::nullopt;
+    }
+
+    return SharedMemoryRegion{name, data, size, true};
+}
+
+std::optional<SharedMemoryRegion>
+SharedMemoryRegion::open(const std::string& name, size_t size, bool writable)
+{
+    int fd = shm_open(name.c_str(), writable ? O_RDWR : O_RDONLY, 0600);
+    if (fd < 0) {
+        log_e(shared_memory, "shm_open({}) failed: {}", name, std::strerror(errno));
+        return std::nullopt;
+    }
+
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* data = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        log_e(shared_memory, "mmap({}) failed: {}", name, std::strerror(errno));
+        return std::nullopt;
+    }
+
+    return SharedMemoryRegion{name, data, size, false};
+}
+
+SharedMemoryRegion::SharedMemoryRegion(SharedMemoryRegion&& other) noexcept :
+    name_(std::move(other.name_)), data_(other.data_), size_(other.size_),
+    owner_(other.owner_)
+{
+    other.data_ = nullptr;
+    other.owner_ = false;
+}
+
+SharedMemoryRegion&
+SharedMemoryRegion::operator=(SharedMemoryRegion&& other) noexcept
+{
+    if (this == &other)
+        return *this;
+
+    release();
+    name_ = std::move(other.name_);
+    data_ = other.data_;
+    size_ = other.size_;
+    owner_ = other.owner_;
+    other.data_ = nullptr;
+    other.owner_ = false;
+    return *this;
+}
+
+SharedMemoryRegion::~SharedMemoryRegion()
+{
+    release();
+}
+
+void
+SharedMemoryRegion::release()
+{
+    if (data_ != nullptr)
+        munmap(data_, size_);
+    if (owner_)
+        shm_unlink(name_.c_str());
+
+    data_ = nullptr;
+    owner_ = false;
+}
+
+} // namespace shared_memory
+} // namespace nutc
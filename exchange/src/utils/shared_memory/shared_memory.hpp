@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace nutc {
+/**
+ * @brief POSIX shared memory helpers used by the co-located transports
+ */
+namespace shared_memory {
+
+/**
+ * @class SharedMemoryRegion
+ * @brief RAII wrapper around a named, memory-mapped POSIX shared memory object
+ *
+ * The creating side owns the name and unlinks it on destruction; the opening side only
+ * unmaps its view.
+ */
+class SharedMemoryRegion {
+public:
+    /**
+     * @brief Creates (or truncates) a zero-filled region with the given name and size
+     * @return The mapped region, or nullopt if it could not be created
+     */
+    static std::optional<SharedMemoryRegion> create(const std::string& name, size_t size);
+
+    /**
+     * @brief Maps an existing region that was created by another process
+     * @param writable Whether the mapping should allow writes
+     */
+    static std::optional<SharedMemoryRegion>
+    open(const std::string& name, size_t size, bool writable = true);
+
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+    SharedMemoryRegion(SharedMemoryRegion&& other) noexcept;
+    SharedMemoryRegion& operator=(SharedMemoryRegion&& other) noexcept;
+
+    ~SharedMemoryRegion();
+
+    [[nodiscard]] void*
+    data() const
+    {
+        return data_;
+    }
+
+    [[nodiscard]] size_t
+    size() const
+    {
+        return size_;
+    }
+
+    [[nodiscard]] const std::string&
+    name() const
+    {
+        return name_;
+    }
+
+private:
+    SharedMemoryRegion(std::string name, void* data, size_t size, bool owner) :
+        name_(std::move(name)), data_(data), size_(size), owner_(owner)
+    {}
+
+    void release();
+
+    std::string name_;
+    void* data_ = nullptr;
+    size_t size_ = 0;
+    bool owner_ = false;
+};
+
+} // namespace shared_memory
+} // namespace nutc
@@ -284,3 +284,39 @@ TEST_F(BasicMatching, MultiplePartialFillReversed)
     EXPECT_EQ_OB_UPDATE(ob_updates3.at(1), "ETHUSD", SELL, 1, 0);
     EXPECT_EQ_OB_UPDATE(ob_updates3.at(2), "ETHUSD", BUY, 1, 1);
 }
+
+TEST_F(BasicMatching, FillsMarkTickerToLastTrade)
+{
+    MarketOrder order1{"DEF", SELL, "ETHUSD", 2, 1};
+    MarketOrder order2{"ABC", BUY, "ETHUSD", 1, 3};
+    engine.match_order(order1, manager);
+    engine.match_order(order2, manager);
+
+    auto ticker = manager.find_ticker_id("ETHUSD").value();
+    EXPECT_FLOAT_EQ(manager.get_mark(ticker), 1);
+
+    // Both now hold a position marked at the trade price
+    auto abc = manager.get_client_id("ABC").value();
+    auto def = manager.get_client_id("DEF").value();
+    EXPECT_DOUBLE_EQ(manager.get_portfolio_value(abc), STARTING_CAPITAL - 1 + 1001);
+    EXPECT_DOUBLE_EQ(manager.get_portfolio_value(def), STARTING_CAPITAL + 1 + 999);
+}
+
+TEST_F(BasicMatching, UpdatesCarryLevelTotal)
+{
+    MarketOrder buy1{"ABC", BUY, "ETHUSD", 1, 1};
+    MarketOrder buy2{"ABC", BUY, "ETHUSD", 2, 1};
+    MarketOrder sell{"DEF", SELL, "ETHUSD", 2, 1};
+    engine.match_order(buy1, manager);
+    auto [matches, ob_updates] = engine.match_order(buy2, manager);
+    ASSERT_EQ(ob_updates.size(), 1);
+    EXPECT_FLOAT_EQ(ob_updates.at(0).level_quantity, 3);
+
+    // buy1 is filled, then buy2 is removed and put back with 1 left
+    auto [matches2, ob_updates2] = engine.match_order(sell, manager);
+    ASSERT_EQ(ob_updates2.size(), 3);
+    EXPECT_FLOAT_EQ(ob_updates2.at(0).level_quantity, 2);
+    EXPECT_FLOAT_EQ(ob_updates2.at(1).level_quantity, 0);
+    EXPECT_FLOAT_EQ(ob_updates2.at(2).level_quantity, 1);
+    EXPECT_FLOAT_EQ(engine.get_level_quantity(BUY, 1), 1);
+}
@@ -0,0 +1,223 @@
+#include "client_manager/client_manager.hpp"
+#include "leaderboard/leaderboard.hpp"
+#include "matching/engine/engine.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using ClientManager = nutc::manager::ClientManager;
+
+TEST(ClientManagerTest, IdsAreStableAcrossAdds)
+{
+    ClientManager clients;
+    clients.add_client("ABC", 100, true);
+    auto abc = clients.get_client_id("ABC");
+    ASSERT_TRUE(abc.has_value());
+
+    for (int i = 0; i < 100; i++)
+        clients.add_client("client_" + std::to_string(i));
+
+    EXPECT_EQ(clients.get_client_id("ABC"), abc);
+    EXPECT_EQ(clients.get_client(abc.value()).uid, "ABC");
+    EXPECT_FALSE(clients.get_client_id("XYZ").has_value());
+}
+
+TEST(ClientManagerTest, HandlesAndUidsAddressSameAccount)
+{
+    ClientManager clients;
+    clients.add_client("ABC", 100, true);
+    auto abc = clients.get_client_id("ABC").value();
+    auto ticker = clients.get_ticker_id("A");
+
+    clients.modify_capital(abc, -40);
+    clients.modify_holdings(abc, ticker, 5);
+    EXPECT_FLOAT_EQ(clients.get_capital("ABC"), 60);
+    EXPECT_FLOAT_EQ(clients.get_holdings("ABC", "A"), 5);
+
+    clients.modify_holdings("ABC", "A", 2);
+    EXPECT_FLOAT_EQ(clients.get_holdings(abc, ticker), 7);
+    EXPECT_FLOAT_EQ(clients.get_holdings("ABC", "B"), 0);
+}
+
+TEST(ClientManagerTest, HoldingsSurviveGrowingTickerCount)
+{
+    ClientManager clients;
+    clients.add_client("ABC");
+    clients.add_client("DEF");
+
+    constexpr int num_tickers = 50;
+    for (int i = 0; i < num_tickers; i++) {
+        clients.modify_holdings("ABC", "T" + std::to_string(i), static_cast<float>(i));
+        clients.modify_holdings("DEF", "T" + std::to_string(i), static_cast<float>(-i));
+    }
+
+    for (int i = 0; i < num_tickers; i++) {
+        EXPECT_FLOAT_EQ(clients.get_holdings("ABC", "T" + std::to_string(i)), i);
+        EXPECT_FLOAT_EQ(clients.get_holdings("DEF", "T" + std::to_string(i)), -i);
+    }
+}
+
+TEST(ClientManagerTest, ReaddingResetsAccountButKeepsId)
+{
+    ClientManager clients;
+    clients.add_client("ABC", 100);
+    auto abc = clients.get_client_id("ABC");
+    clients.modify_holdings("ABC", "A", 10);
+
+    clients.add_client("ABC", 50, true);
+    EXPECT_EQ(clients.get_client_id("ABC"), abc);
+    EXPECT_FLOAT_EQ(clients.get_capital("ABC"), 50);
+    EXPECT_FLOAT_EQ(clients.get_holdings("ABC", "A"), 0);
+    EXPECT_EQ(clients.get_clients(true).size(), 1);
+}
+
+TEST(ClientManagerTest, ActiveRosterFollowsActivation)
+{
+    ClientManager clients;
+    clients.add_client("ABC", 100, true);
+    clients.add_client("DEF");
+    clients.add_client("GHI", 100, true);
+    clients.set_active("DEF");
+    clients.set_active("DEF");
+
+    auto sorted_roster = [&clients] {
+        auto uids = clients.get_active_uids();
+        std::sort(uids.begin(), uids.end());
+        return uids;
+    };
+    EXPECT_EQ(sorted_roster(), (std::vector<std::string>{"ABC", "DEF", "GHI"}));
+
+    clients.set_inactive("ABC");
+    EXPECT_EQ(sorted_roster(), (std::vector<std::string>{"DEF", "GHI"}));
+    clients.set_inactive("GHI");
+    clients.set_inactive("XYZ");
+    EXPECT_EQ(sorted_roster(), (std::vector<std::string>{"DEF"}));
+
+    // Re-adding as inactive takes the client off the roster too
+    clients.add_client("DEF");
+    EXPECT_TRUE(clients.get_active_uids().empty());
+    EXPECT_EQ(clients.get_clients(false).size(), 3);
+}
+
+TEST(ClientManagerTest, PortfolioValueFollowsFillsAndMarks)
+{
+    ClientManager clients;
+    clients.add_client("ABC", 100, true);
+    clients.add_client("DEF", 100, true);
+    auto abc = clients.get_client_id("ABC").value();
+    auto def = clients.get_client_id("DEF").value();
+    auto ticker = clients.get_ticker_id("A");
+
+    clients.set_mark(ticker, 2);
+    clients.modify_capital(abc, -20);
+    clients.modify_holdings(abc, ticker, 10);
+    clients.modify_holdings(def, ticker, -10);
+    clients.modify_capital(def, 20);
+    EXPECT_DOUBLE_EQ(clients.get_portfolio_value(abc), 100);
+    EXPECT_DOUBLE_EQ(clients.get_portfolio_value(def), 100);
+
+    clients.set_mark(ticker, 5);
+    EXPECT_DOUBLE_EQ(clients.get_portfolio_value(abc), 130);
+    EXPECT_DOUBLE_EQ(clients.get_portfolio_value(def), 70);
+
+    clients.revalue_all();
+    EXPECT_DOUBLE_EQ(clients.get_portfolio_value(abc), 130);
+    EXPECT_DOUBLE_EQ(clients.get_portfolio_value(def), 70);
+}
+
+TEST(ClientManagerTest, LeaderboardRanksActiveClientsByValue)
+{
+    ClientManager clients;
+    clients.add_client("ABC", 100, true);
+    clients.add_client("DEF", 300, true);
+    clients.add_client("GHI", 200, true);
+    clients.add_client("JKL", 1000);
+
+    auto standings = clients.get_leaderboard(2);
+    ASSERT_EQ(standings.size(), 2);
+    EXPECT_EQ(standings.at(0).uid, "DEF");
+    EXPECT_EQ(standings.at(1).uid, "GHI");
+    EXPECT_EQ(clients.get_leaderboard(10).size(), 3);
+}
+
+TEST(ClientManagerTest, SnapshotWriterAppendsStandings)
+{
+    ClientManager clients;
+    clients.add_client("ABC", 100, true);
+    clients.add_client("DEF", 300, true);
+
+    auto path = std::filesystem::temp_directory_path() / "nutc_leaderboard_test.log";
+    std::filesystem::remove(path);
+    {
+        nutc::leaderboard::SnapshotWriter writer(path.string(), std::chrono::seconds(5), 1);
+        auto now = std::chrono::steady_clock::now();
+        writer.maybe_write(clients, now);
+        writer.maybe_write(clients, now + std::chrono::seconds(6));
+        writer.maybe_write(clients, now + std::chrono::seconds(7));
+    }
+
+    std::ifstream file(path);
+    std::string line;
+    std::vector<std::string> lines;
+    while (std::getline(file, line))
+        lines.push_back(line);
+    std::filesystem::remove(path);
+
+    ASSERT_EQ(lines.size(), 1);
+    nutc::leaderboard::LeaderboardSnapshot snapshot{};
+    ASSERT_FALSE(glz::read_json(snapshot, lines.at(0)));
+    ASSERT_EQ(snapshot.standings.size(), 1);
+    EXPECT_EQ(snapshot.standings.at(0).uid, "DEF");
+}
+
+TEST(ClientManagerTest, ParallelSettlementNeverOverspends)
+{
+    // Buyers can afford a fraction of what they bid for, on two tickers at once
+    constexpr int num_pairs = 4;
+    constexpr int orders_per_ticker = 2000;
+    constexpr float buyer_capital = 100;
+    const std::vector<std::string> tickers{"A", "B"};
+
+    ClientManager clients;
+    for (int i = 0; i < num_pairs; i++) {
+        clients.add_client("buyer_" + std::to_string(i), buyer_capital, true);
+        clients.add_client("seller_" + std::to_string(i), 0, true);
+        for (const auto& ticker : tickers)
+            clients.modify_holdings("seller_" + std::to_string(i), ticker, 1000);
+    }
+
+    auto trade = [&clients](const std::string& ticker) {
+        nutc::matching::Engine engine;
+        for (int i = 0; i < orders_per_ticker; i++) {
+            std::string pair = std::to_string(i % num_pairs);
+            MarketOrder sell{"seller_" + pair, SIDE::SELL, ticker, 1, 1};
+            MarketOrder buy{"buyer_" + pair, SIDE::BUY, ticker, 1, 1};
+            engine.match_order(sell, clients);
+            engine.match_order(buy, clients);
+        }
+    };
+    std::thread other(trade, tickers.at(1));
+    trade(tickers.at(0));
+    other.join();
+
+    float total_capital = 0;
+    float total_bought = 0;
+    for (int i = 0; i < num_pairs; i++) {
+        std::string buyer = "buyer_" + std::to_string(i);
+        std::string seller = "seller_" + std::to_string(i);
+        EXPECT_GE(clients.get_capital(buyer), 0);
+        total_capital += clients.get_capital(buyer) + clients.get_capital(seller);
+        for (const auto& ticker : tickers)
+            total_bought += clients.get_holdings(buyer, ticker);
+    }
+
+    // Everything the buyers had was spent, once, on exactly what they hold
+    EXPECT_FLOAT_EQ(total_capital, num_pairs * buyer_capital);
+    EXPECT_FLOAT_EQ(total_bought, num_pairs * buyer_capital);
+}
@@ -128,3 +128,14 @@ TEST_F(InvalidOrders, SimpleManyInvalidOrder)
     EXPECT_EQ_OB_UPDATE(updates4[1], "ETHUSD", BUY, 1, 0);
     EXPECT_EQ_OB_UPDATE(updates4[2], "ETHUSD", SELL, 1, 1);
 }
+
+TEST_F(InvalidOrders, UnregisteredTicker)
+{
+    MarketOrder order1{"ABC", BUY, "BTCUSD", 1, 1};
+
+    // Thrown out, and the ticker is still unknown
+    auto [matches, ob_updates] = engine.match_order(order1, manager);
+    EXPECT_EQ(matches.size(), 0);
+    EXPECT_EQ(ob_updates.size(), 0);
+    EXPECT_FALSE(manager.find_ticker_id("BTCUSD").has_value());
+}
@@ -0,0 +1,94 @@
+#include "process_spawning/isolation.hpp"
+
+#include <gtest/gtest.h>
+
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <vector>
+
+namespace client = nutc::client;
+
+TEST(IsolationTest, ReservesLeadingCoresForExchange)
+{
+    auto split = client::split_cores({0, 1, 2, 3, 6}, 2);
+    ASSERT_TRUE(split.has_value());
+    EXPECT_EQ(split->exchange, (std::vector<int>{0, 1}));
+    EXPECT_EQ(split->clients, (std::vector<int>{2, 3, 6}));
+}
+
+TEST(IsolationTest, DoesNotReserveEveryCore)
+{
+    EXPECT_FALSE(client::split_cores({0, 1}, 2).has_value());
+    EXPECT_FALSE(client::split_cores({0}, 1).has_value());
+    EXPECT_FALSE(client::split_cores({0, 1, 2}, 0).has_value());
+}
+
+TEST(IsolationTest, ParsesCgroupCpuStat)
+{
+    EXPECT_EQ(
+        client::parse_cpu_stat_usec(
+            "usage_usec 1500000\nuser_usec 1000000\nsystem_usec 500000\n"
+        ),
+        1500000
+    );
+    EXPECT_FALSE(client::parse_cpu_stat_usec("user_usec 10\n").has_value());
+}
+
+TEST(IsolationTest, ReadsOwnUsageFromProc)
+{
+    auto usage = client::read_proc_usage(getpid());
+    ASSERT_TRUE(usage.has_value());
+    EXPECT_GE(usage->cpu_seconds, 0);
+    EXPECT_GT(usage->memory_bytes, 0);
+}
+
+TEST(IsolationTest, UnconfiguredIsolationIgnoresClients)
+{
+    auto& isolation = client::ClientIsolation::getInstance();
+    isolation.isolate("ABC", getpid());
+    isolation.pin_hot_thread(0);
+    EXPECT_FALSE(isolation.get_usage("ABC").has_value());
+}
+
+TEST(IsolationTest, CgroupNamesDoNotCollide)
+{
+    EXPECT_NE(client::cgroup_name("a-b"), client::cgroup_name("a_b"));
+    EXPECT_NE(client::cgroup_name("a.b"), client::cgroup_name("a/b"));
+    EXPECT_EQ(client::cgroup_name("abc123"), "nutc_client_abc123");
+}
+
+TEST(IsolationTest, UnconfiguredIsolationPreparesNothing)
+{
+    auto& isolation = client::ClientIsolation::getInstance();
+    EXPECT_FALSE(isolation.prepare("ABC").has_value());
+    EXPECT_FALSE(isolation.prepare_shared().has_value());
+}
+
+TEST(IsolationTest, ForkedChildAppliesCoreMask)
+{
+    cpu_set_t allowed;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+    int core = 0;
+    while (!CPU_ISSET(core, &allowed))
+        core++;
+
+    client::PreparedLimits limits{};
+    limits.cores.emplace();
+    CPU_ZERO(&limits.cores.value());
+    CPU_SET(core, &limits.cores.value());
+
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        client::apply_limits(limits);
+        cpu_set_t applied;
+        sched_getaffinity(0, sizeof(applied), &applied);
+        _exit(CPU_COUNT(&applied) == 1 && CPU_ISSET(core, &applied) ? 0 : 1);
+    }
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+}
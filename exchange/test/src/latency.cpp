@@ -0,0 +1,67 @@
+#include "latency/latency_histogram.hpp"
+#include "latency/order_latency.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+using LatencyHistogram = nutc::latency::LatencyHistogram;
+using OrderLatency = nutc::latency::OrderLatency;
+using OrderTimestamps = nutc::latency::OrderTimestamps;
+using LatencyStage = nutc::latency::LatencyStage;
+
+TEST(LatencyHistogramTest, BucketsCoverTheirValues)
+{
+    for (uint64_t value : {0ULL, 1ULL, 63ULL, 64ULL, 100ULL, 1000ULL, 123456ULL, 1ULL << 39}) {
+        uint32_t index = LatencyHistogram::bucket_index(value);
+        EXPECT_GE(LatencyHistogram::bucket_upper_bound(index), value);
+        if (index > 0) {
+            EXPECT_LT(LatencyHistogram::bucket_upper_bound(index - 1), value);
+        }
+    }
+    EXPECT_EQ(
+        LatencyHistogram::bucket_index(UINT64_MAX), LatencyHistogram::NUM_BUCKETS - 1
+    );
+}
+
+TEST(LatencyHistogramTest, QuantilesStayWithinPrecision)
+{
+    LatencyHistogram histogram;
+    for (uint64_t value = 1; value <= 10000; value++)
+        histogram.record(value * 100);
+
+    EXPECT_EQ(histogram.count(), 10000);
+    EXPECT_EQ(histogram.max(), 1000000);
+    EXPECT_EQ(histogram.mean(), 500050);
+    EXPECT_NEAR(histogram.value_at_quantile(0.5), 500000, 500000 * 0.04);
+    EXPECT_NEAR(histogram.value_at_quantile(0.99), 990000, 990000 * 0.04);
+    EXPECT_EQ(histogram.value_at_quantile(1.0), 1000000);
+
+    histogram.reset();
+    EXPECT_EQ(histogram.count(), 0);
+    EXPECT_EQ(histogram.value_at_quantile(0.5), 0);
+}
+
+TEST(OrderLatencyTest, RecordsEveryStageOverallAndPerTicker)
+{
+    auto& order_latency = OrderLatency::getInstance();
+    order_latency.reset();
+    order_latency.configure({"A"});
+
+    order_latency.record(OrderTimestamps{1000, 1010, 1030, 1060}, "A");
+    order_latency.record(OrderTimestamps{1000, 1010, 1030, 1060}, "B");
+
+    EXPECT_EQ(order_latency.get_histogram(LatencyStage::DECODE).max(), 10);
+    EXPECT_EQ(order_latency.get_histogram(LatencyStage::MATCH).max(), 20);
+    EXPECT_EQ(order_latency.get_histogram(LatencyStage::PUBLISH).max(), 30);
+    EXPECT_EQ(order_latency.get_histogram(LatencyStage::TOTAL).count(), 2);
+    EXPECT_EQ(order_latency.get_histogram(LatencyStage::TOTAL).max(), 60);
+
+    const LatencyHistogram* ticker_total =
+        order_latency.get_histogram(LatencyStage::TOTAL, "A");
+    ASSERT_NE(ticker_total, nullptr);
+    EXPECT_EQ(ticker_total->count(), 1);
+    EXPECT_EQ(order_latency.get_histogram(LatencyStage::TOTAL, "B"), nullptr);
+
+    order_latency.reset();
+}
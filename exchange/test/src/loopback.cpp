@@ -0,0 +1,229 @@
+#include "client_manager/client_manager.hpp"
+#include "matching/manager/engine_manager.hpp"
+#include "networking/rabbitmq/client_manager/RabbitMQClientManager.hpp"
+#include "networking/rabbitmq/consumer/RabbitMQConsumer.hpp"
+#include "networking/transport/TransportManager.hpp"
+#include "networking/transport/loopback/LoopbackTransport.hpp"
+#include "rate_limiting/order_throttle.hpp"
+#include "test_utils/macros.hpp"
+#include "utils/messages.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+using nutc::messages::SIDE::BUY;
+using nutc::messages::SIDE::SELL;
+using LoopbackTransport = nutc::transport::LoopbackTransport;
+using TransportManager = nutc::transport::TransportManager;
+using RabbitMQConsumer = nutc::rabbitmq::RabbitMQConsumer;
+using RabbitMQClientManager = nutc::rabbitmq::RabbitMQClientManager;
+using InitMessage = nutc::messages::InitMessage;
+using AccountUpdate = nutc::messages::AccountUpdate;
+using LevelTotals = nutc::messages::LevelTotals;
+using OrderThrottle = nutc::rate_limiting::OrderThrottle;
+
+class LoopbackExchange : public ::testing::Test {
+protected:
+    void
+    SetUp() override
+    {
+        auto& transports = TransportManager::getInstance();
+        transports.reset();
+        loopback = std::make_shared<LoopbackTransport>();
+        transports.addIngress(loopback);
+        transports.setEgress(loopback);
+
+        clients.add_client("ABC", STARTING_CAPITAL, true);
+        clients.add_client("DEF", STARTING_CAPITAL, true);
+        clients.add_client("GHI", STARTING_CAPITAL, true);
+        clients.modify_holdings("DEF", "A", 1000);
+        engine_manager.add_engine("A", clients);
+    }
+
+    void
+    TearDown() override
+    {
+        TransportManager::getInstance().reset();
+        OrderThrottle::getInstance().reset();
+    }
+
+    void
+    submit(const std::string& uid, SIDE side, float quantity, float price)
+    {
+        loopback->submit(glz::write_json(MarketOrder{uid, side, "A", quantity, price}));
+    }
+
+    // Runs the exchange until every submitted message has been handled
+    void
+    run_exchange()
+    {
+        while (RabbitMQConsumer::handleIncomingMessage(
+            clients, engine_manager, std::chrono::microseconds(0)
+        )) {}
+    }
+
+    std::shared_ptr<LoopbackTransport> loopback;
+    ClientManager clients;
+    nutc::engine_manager::Manager engine_manager;
+};
+
+TEST_F(LoopbackExchange, OrderReachesEveryOtherClient)
+{
+    submit("DEF", SELL, 1, 1);
+    run_exchange();
+
+    // The placer's algo isn't told of its own order, but its mirrored book is
+    auto placer_messages = loopback->drain("DEF");
+    ASSERT_EQ(placer_messages.size(), 1);
+    LevelTotals totals{};
+    ASSERT_FALSE(glz::read_json(totals, placer_messages.at(0)));
+    ASSERT_EQ(totals.level_totals.size(), 1);
+    EXPECT_EQ_OB_UPDATE(totals.level_totals.at(0), "A", SELL, 1, 1);
+    EXPECT_FLOAT_EQ(totals.level_totals.at(0).level_quantity, 1);
+
+    for (const char* uid : {"ABC", "GHI"}) {
+        auto messages = loopback->drain(uid);
+        ASSERT_EQ(messages.size(), 1);
+        ObUpdate update{};
+        ASSERT_FALSE(glz::read_json(update, messages.at(0)));
+        EXPECT_EQ_OB_UPDATE(update, "A", SELL, 1, 1);
+    }
+}
+
+TEST_F(LoopbackExchange, MatchSendsAccountUpdatesAndBroadcasts)
+{
+    submit("DEF", SELL, 1, 1);
+    submit("ABC", BUY, 1, 1);
+    run_exchange();
+    loopback->drain("GHI");
+
+    // Buyer: the resting ask, its account update, the match, then the level totals.
+    // The book update for the consumed ask is withheld since the buyer placed the
+    // order that caused it, so the buyer only gets the totals for its mirrored book
+    auto buyer_messages = loopback->drain("ABC");
+    ASSERT_EQ(buyer_messages.size(), 4);
+    AccountUpdate buyer_update{};
+    ASSERT_FALSE(glz::read_json(buyer_update, buyer_messages.at(1)));
+    EXPECT_EQ(buyer_update.side, BUY);
+    EXPECT_FLOAT_EQ(buyer_update.capital_remaining, STARTING_CAPITAL - 1);
+
+    Match match{};
+    ASSERT_FALSE(glz::read_json(match, buyer_messages.at(2)));
+    EXPECT_EQ_MATCH(match, "A", "ABC", "DEF", BUY, 1, 1);
+
+    LevelTotals totals{};
+    ASSERT_FALSE(glz::read_json(totals, buyer_messages.at(3)));
+    ASSERT_EQ(totals.level_totals.size(), 1);
+    EXPECT_FLOAT_EQ(totals.level_totals.at(0).level_quantity, 0);
+
+    EXPECT_FLOAT_EQ(clients.get_holdings("ABC", "A"), 1);
+    EXPECT_FLOAT_EQ(clients.get_holdings("DEF", "A"), 999);
+}
+
+TEST_F(LoopbackExchange, InvalidMessageIsDropped)
+{
+    loopback->submit("not json");
+    submit("DEF", SELL, 1, 1);
+    run_exchange();
+
+    EXPECT_EQ(loopback->pending(), 0);
+    EXPECT_EQ(loopback->drain("ABC").size(), 1);
+}
+
+TEST_F(LoopbackExchange, ManyOrdersRoundTrip)
+{
+    // DEF holds exactly enough to fill every order
+    constexpr int num_orders = 1000;
+    for (int i = 0; i < num_orders; i++) {
+        submit("DEF", SELL, 1, 1);
+        submit("ABC", BUY, 1, 1);
+    }
+    run_exchange();
+
+    EXPECT_FLOAT_EQ(clients.get_holdings("ABC", "A"), num_orders);
+    EXPECT_FLOAT_EQ(clients.get_capital("DEF"), STARTING_CAPITAL + num_orders);
+    EXPECT_EQ(loopback->drain("GHI").size(), 3 * num_orders);
+}
+
+TEST_F(LoopbackExchange, ThrottledOrderIsRejectedBeforeMatching)
+{
+    OrderThrottle::getInstance().configure({0.001, 1}, {1000, 1000}, {"ABC"}, {"A"});
+    submit("ABC", BUY, 1, 1);
+    submit("ABC", BUY, 1, 2);
+    run_exchange();
+
+    // Only the first bid reaches the book
+    EXPECT_EQ(loopback->drain("GHI").size(), 1);
+    // The level totals for the first bid, then the rejection of the second
+    auto messages = loopback->drain("ABC");
+    ASSERT_EQ(messages.size(), 2);
+    nutc::messages::OrderRejected rejected{};
+    ASSERT_FALSE(glz::read_json(rejected, messages.at(1)));
+    EXPECT_EQ(rejected.ticker, "A");
+    EXPECT_EQ(OrderThrottle::getInstance().get_throttled_for_client("ABC"), 1);
+}
+
+TEST_F(LoopbackExchange, StartsWithReadyClientsAtDeadline)
+{
+    clients.set_inactive("ABC");
+    clients.set_inactive("DEF");
+    loopback->submit(glz::write_json(InitMessage{"ABC", true}));
+
+    auto start = std::chrono::steady_clock::now();
+    int ready = RabbitMQClientManager::waitForClients(
+        clients, 2, std::chrono::milliseconds(50)
+    );
+    EXPECT_EQ(ready, 1);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+    EXPECT_EQ(clients.get_active_uids().size(), 2); // ABC and GHI
+}
+
+TEST_F(LoopbackExchange, StartsOnceEveryClientReported)
+{
+    loopback->submit(glz::write_json(InitMessage{"ABC", true}));
+    loopback->submit(glz::write_json(InitMessage{"DEF", false}));
+
+    auto start = std::chrono::steady_clock::now();
+    int ready =
+        RabbitMQClientManager::waitForClients(clients, 2, std::chrono::seconds(30));
+    EXPECT_EQ(ready, 1);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST_F(LoopbackExchange, LateClientJoinsFromSnapshot)
+{
+    clients.set_inactive("GHI");
+    submit("DEF", SELL, 1, 1);
+    run_exchange();
+    EXPECT_TRUE(loopback->drain("GHI").empty());
+
+    loopback->submit(glz::write_json(InitMessage{"GHI", true}));
+    submit("DEF", SELL, 2, 2);
+    run_exchange();
+
+    // The books as of joining, the start time, then live updates
+    auto messages = loopback->drain("GHI");
+    ASSERT_EQ(messages.size(), 3);
+    nutc::messages::BookSnapshot snapshot{};
+    ASSERT_FALSE(glz::read_json(snapshot, messages.at(0)));
+    ASSERT_EQ(snapshot.levels.size(), 1);
+    EXPECT_EQ_OB_UPDATE(snapshot.levels.at(0), "A", SELL, 1, 1);
+    nutc::messages::StartTime start_time{};
+    EXPECT_FALSE(glz::read_json(start_time, messages.at(1)));
+    ObUpdate update{};
+    ASSERT_FALSE(glz::read_json(update, messages.at(2)));
+    EXPECT_EQ_OB_UPDATE(update, "A", SELL, 2, 2);
+}
+
+TEST_F(LoopbackExchange, RepeatedInitFromActiveClientIsIgnored)
+{
+    // Each one would otherwise cost a full snapshot outside the throttle
+    loopback->submit(glz::write_json(InitMessage{"ABC", true}));
+    loopback->submit(glz::write_json(InitMessage{"ABC", true}));
+    run_exchange();
+    EXPECT_TRUE(loopback->drain("ABC").empty());
+}
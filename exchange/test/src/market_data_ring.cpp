@@ -0,0 +1,140 @@
+#include "matching/engine/engine.hpp"
+#include "networking/shm/market_data_ring/MarketDataRing.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+
+using MarketDataRing = nutc::shm::MarketDataRing;
+using ReadStatus = nutc::shm::ReadStatus;
+using Engine = nutc::matching::Engine;
+
+class MarketDataRingTest : public ::testing::Test {
+protected:
+    void
+    SetUp() override
+    {
+        ring = std::make_unique<MarketDataRing>();
+        ring->initialize();
+    }
+
+    std::unique_ptr<MarketDataRing> ring;
+};
+
+TEST_F(MarketDataRingTest, EveryReaderSeesEveryMessage)
+{
+    EXPECT_TRUE(ring->publish("first", ""));
+    EXPECT_TRUE(ring->publish("second", ""));
+
+    std::string message;
+    for (const char* reader : {"reader_a", "reader_b"}) {
+        EXPECT_EQ(ring->read(0, message, reader), ReadStatus::OK);
+        EXPECT_EQ(message, "first");
+        EXPECT_EQ(ring->read(1, message, reader), ReadStatus::OK);
+        EXPECT_EQ(message, "second");
+        EXPECT_EQ(ring->read(2, message, reader), ReadStatus::EMPTY);
+    }
+}
+
+TEST_F(MarketDataRingTest, ExcludedReaderSkipsMessage)
+{
+    EXPECT_TRUE(ring->publish("update", "placer"));
+
+    std::string message;
+    EXPECT_EQ(ring->read(0, message, "placer"), ReadStatus::OK);
+    EXPECT_TRUE(message.empty());
+    EXPECT_EQ(ring->read(0, message, "other"), ReadStatus::OK);
+    EXPECT_EQ(message, "update");
+}
+
+TEST_F(MarketDataRingTest, DetectsOverrun)
+{
+    for (uint64_t i = 0; i <= MarketDataRing::CAPACITY; i++)
+        EXPECT_TRUE(ring->publish(std::to_string(i), ""));
+
+    std::string message;
+    EXPECT_EQ(ring->read(0, message, ""), ReadStatus::OVERRUN);
+    EXPECT_EQ(ring->read(1, message, ""), ReadStatus::OK);
+    EXPECT_EQ(message, "1");
+    EXPECT_EQ(ring->read(MarketDataRing::CAPACITY, message, ""), ReadStatus::OK);
+    EXPECT_EQ(message, std::to_string(MarketDataRing::CAPACITY));
+}
+
+TEST_F(MarketDataRingTest, RejectsOversizedMessage)
+{
+    std::string message(SHM_MARKET_DATA_SLOT_PAYLOAD + 1, 'x');
+    EXPECT_FALSE(ring->publish(message, ""));
+    EXPECT_EQ(ring->read(0, message, ""), ReadStatus::EMPTY);
+}
+
+TEST_F(MarketDataRingTest, ConcurrentReaderNeverSeesTornMessage)
+{
+    constexpr uint64_t num_messages = 200000;
+
+    std::thread writer([this] {
+        for (uint64_t i = 0; i < num_messages; i++) {
+            // Payload is the index repeated, so a torn copy is detectable
+            std::string index = std::to_string(i);
+            std::string message;
+            while (message.size() + index.size() <= SHM_MARKET_DATA_SLOT_PAYLOAD)
+                message += index;
+            ring->publish(message, "");
+        }
+    });
+
+    uint64_t cursor = 0;
+    std::string message;
+    while (cursor < num_messages) {
+        ReadStatus status = ring->read(cursor, message, "");
+        if (status == ReadStatus::EMPTY)
+            continue;
+        if (status == ReadStatus::OVERRUN) {
+            // Resynchronize to the writer like a client would after a snapshot
+            cursor = ring->write_index.load();
+            continue;
+        }
+
+        std::string index = std::to_string(cursor);
+        ASSERT_EQ(message.substr(0, index.size()), index);
+        ASSERT_EQ(message.substr(message.size() - index.size()), index);
+        cursor++;
+    }
+    writer.join();
+}
+
+TEST(BookLevelsTest, AggregatesRestingOrdersByPrice)
+{
+    Engine engine;
+    engine.add_order_without_matching(MarketOrder{"A", SIDE::SELL, "ETHUSD", 1, 2});
+    engine.add_order_without_matching(MarketOrder{"B", SIDE::SELL, "ETHUSD", 3, 1});
+    engine.add_order_without_matching(MarketOrder{"C", SIDE::SELL, "ETHUSD", 2, 2});
+    engine.add_order_without_matching(MarketOrder{"D", SIDE::BUY, "ETHUSD", 4, 0.5});
+
+    auto asks = engine.get_levels(SIDE::SELL, "ETHUSD");
+    ASSERT_EQ(asks.size(), 2);
+    EXPECT_EQ(asks[0].security, "ETHUSD");
+    EXPECT_EQ(asks[0].side, SIDE::SELL);
+    EXPECT_FLOAT_EQ(asks[0].price, 1);
+    EXPECT_FLOAT_EQ(asks[0].quantity, 3);
+    EXPECT_FLOAT_EQ(asks[1].price, 2);
+    EXPECT_FLOAT_EQ(asks[1].quantity, 3);
+
+    auto bids = engine.get_levels(SIDE::BUY, "ETHUSD");
+    ASSERT_EQ(bids.size(), 1);
+    EXPECT_FLOAT_EQ(bids[0].quantity, 4);
+}
+
+TEST(BookLevelsTest, OrdersBidsFromBest)
+{
+    Engine engine;
+    engine.add_order_without_matching(MarketOrder{"A", SIDE::BUY, "ETHUSD", 1, 0.5});
+    engine.add_order_without_matching(MarketOrder{"B", SIDE::BUY, "ETHUSD", 2, 0.75});
+
+    auto bids = engine.get_levels(SIDE::BUY, "ETHUSD");
+    ASSERT_EQ(bids.size(), 2);
+    EXPECT_FLOAT_EQ(bids[0].price, 0.75);
+    EXPECT_FLOAT_EQ(bids[0].level_quantity, 2);
+    EXPECT_FLOAT_EQ(bids[1].price, 0.5);
+}
@@ -0,0 +1,105 @@
+#include "monitoring/metrics.hpp"
+#include "monitoring/metrics_server.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using MetricsRegistry = nutc::monitoring::MetricsRegistry;
+using MetricsServer = nutc::monitoring::MetricsServer;
+
+namespace {
+bool
+contains(const std::string& text, const std::string& line)
+{
+    return text.find(line) != std::string::npos;
+}
+} // namespace
+
+TEST(MetricsTest, SameNameAndLabelsShareAMetric)
+{
+    auto& registry = MetricsRegistry::getInstance();
+    auto& first = registry.counter("test_shared_total", "help", R"(id="1")");
+    auto& second = registry.counter("test_shared_total", "help", R"(id="1")");
+    auto& other = registry.counter("test_shared_total", "help", R"(id="2")");
+
+    EXPECT_EQ(&first, &second);
+    EXPECT_NE(&first, &other);
+}
+
+TEST(MetricsTest, RendersCountersAndGauges)
+{
+    auto& registry = MetricsRegistry::getInstance();
+    registry.counter("test_render_total", "Things counted").inc(3);
+    registry.gauge("test_render_depth", "Things waiting", R"(side="bid")").set(7);
+
+    std::string text = registry.render();
+    EXPECT_TRUE(contains(text, "# HELP test_render_total Things counted\n"));
+    EXPECT_TRUE(contains(text, "# TYPE test_render_total counter\n"));
+    EXPECT_TRUE(contains(text, "test_render_total 3\n"));
+    EXPECT_TRUE(contains(text, "# TYPE test_render_depth gauge\n"));
+    EXPECT_TRUE(contains(text, "test_render_depth{side=\"bid\"} 7\n"));
+}
+
+TEST(MetricsTest, HistogramBucketsAreCumulative)
+{
+    auto& histogram = MetricsRegistry::getInstance().histogram(
+        "test_histogram_seconds", "Durations", {0.1, 1}
+    );
+    histogram.observe(0.05);
+    histogram.observe(0.1);
+    histogram.observe(0.5);
+    histogram.observe(5);
+
+    std::string text = MetricsRegistry::getInstance().render();
+    EXPECT_TRUE(contains(text, "test_histogram_seconds_bucket{le=\"0.1\"} 2\n"));
+    EXPECT_TRUE(contains(text, "test_histogram_seconds_bucket{le=\"1\"} 3\n"));
+    EXPECT_TRUE(contains(text, "test_histogram_seconds_bucket{le=\"+Inf\"} 4\n"));
+    EXPECT_TRUE(contains(text, "test_histogram_seconds_count 4\n"));
+    EXPECT_DOUBLE_EQ(histogram.sum(), 5.65);
+}
+
+TEST(MetricsTest, LabelValuesAreEscaped)
+{
+    EXPECT_EQ(nutc::monitoring::label("client", "a\"b\\c"), R"(client="a\"b\\c")");
+}
+
+TEST(MetricsTest, ServerAnswersScrapes)
+{
+    MetricsRegistry::getInstance().counter("test_scraped_total", "Scraped").inc();
+    MetricsServer server;
+    ASSERT_TRUE(server.start(0));
+
+    int client_fd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(client_fd, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(server.get_port());
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(
+        connect(
+            client_fd, reinterpret_cast<sockaddr*>(&address), // NOLINT
+            sizeof(address)
+        ),
+        0
+    );
+
+    std::string request = "GET /metrics HTTP/1.0\r\n\r\n";
+    send(client_fd, request.data(), request.size(), 0);
+    std::string response;
+    std::array<char, 4096> buffer{};
+    ssize_t received = 0;
+    while ((received = recv(client_fd, buffer.data(), buffer.size(), 0)) > 0)
+        response.append(buffer.data(), static_cast<size_t>(received));
+    close(client_fd);
+    server.stop();
+
+    EXPECT_TRUE(response.starts_with("HTTP/1.0 200 OK\r\n"));
+    EXPECT_TRUE(contains(response, "test_scraped_total 1\n"));
+}
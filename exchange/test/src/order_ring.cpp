@@ -0,0 +1,130 @@
+#include "networking/shm/order_ingress/ShmOrderIngress.hpp"
+#include "networking/shm/order_ring/OrderRing.hpp"
+#include "utils/shared_memory/shared_memory.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+using OrderRing = nutc::shm::OrderRing;
+using ShmOrderIngress = nutc::shm::ShmOrderIngress;
+using SharedMemoryRegion = nutc::shared_memory::SharedMemoryRegion;
+
+class OrderRingTest : public ::testing::Test {
+protected:
+    void
+    SetUp() override
+    {
+        ring = std::make_unique<OrderRing>();
+        ring->initialize();
+    }
+
+    std::unique_ptr<OrderRing> ring;
+};
+
+TEST_F(OrderRingTest, PopsInPushOrder)
+{
+    EXPECT_TRUE(ring->try_push("first"));
+    EXPECT_TRUE(ring->try_push("second"));
+    EXPECT_EQ(ring->try_pop().value(), "first");
+    EXPECT_EQ(ring->try_pop().value(), "second");
+    EXPECT_FALSE(ring->try_pop().has_value());
+}
+
+TEST_F(OrderRingTest, RejectsWhenFull)
+{
+    for (uint64_t i = 0; i < OrderRing::CAPACITY; i++)
+        EXPECT_TRUE(ring->try_push("order"));
+    EXPECT_FALSE(ring->try_push("order"));
+
+    EXPECT_TRUE(ring->try_pop().has_value());
+    EXPECT_TRUE(ring->try_push("order"));
+}
+
+TEST_F(OrderRingTest, RejectsOversizedMessage)
+{
+    std::string message(SHM_ORDER_SLOT_PAYLOAD + 1, 'x');
+    EXPECT_FALSE(ring->try_push(message));
+    EXPECT_FALSE(ring->try_pop().has_value());
+}
+
+TEST_F(OrderRingTest, DropsSlotWithOversizedLength)
+{
+    EXPECT_TRUE(ring->try_push("bad"));
+    EXPECT_TRUE(ring->try_push("good"));
+    // Written by a misbehaving client after the push
+    ring->slots[0].length = SHM_ORDER_SLOT_PAYLOAD + 1000;
+
+    EXPECT_EQ(ring->try_pop().value(), "");
+    EXPECT_EQ(ring->try_pop().value(), "good");
+    EXPECT_FALSE(ring->try_pop().has_value());
+}
+
+TEST_F(OrderRingTest, ConcurrentProducersLoseNothing)
+{
+    constexpr int num_producers = 4;
+    constexpr int per_producer = 5000;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < num_producers; p++) {
+        producers.emplace_back([this, p] {
+            for (int i = 0; i < per_producer; i++) {
+                std::string message = std::to_string(p) + ":" + std::to_string(i);
+                while (!ring->try_push(message))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    std::set<std::string> received;
+    while (received.size() < num_producers * per_producer) {
+        auto message = ring->try_pop();
+        if (message.has_value())
+            received.insert(message.value());
+    }
+    for (auto& producer : producers)
+        producer.join();
+
+    EXPECT_EQ(received.size(), num_producers * per_producer);
+    EXPECT_FALSE(ring->try_pop().has_value());
+}
+
+TEST(ShmOrderIngressTest, ReceivesFromMappedRing)
+{
+    ShmOrderIngress ingress;
+    ASSERT_TRUE(ingress.addClient("ring_test_client"));
+
+    auto region = SharedMemoryRegion::open(
+        ShmOrderIngress::regionName("ring_test_client"), sizeof(OrderRing)
+    );
+    ASSERT_TRUE(region.has_value());
+    auto* client_ring = static_cast<OrderRing*>(region->data());
+    ASSERT_TRUE(client_ring->is_initialized());
+
+    EXPECT_FALSE(ingress.receive(std::chrono::microseconds(0)).has_value());
+    EXPECT_TRUE(client_ring->try_push(R"({"client_uid":"ring_test_client"})"));
+    EXPECT_EQ(
+        ingress.receive(std::chrono::microseconds(0)).value(),
+        R"({"client_uid":"ring_test_client"})"
+    );
+}
+
+TEST(ShmOrderIngressTest, AttachedOnlyAfterFirstMessage)
+{
+    ShmOrderIngress ingress;
+    ASSERT_TRUE(ingress.addClient("attach_test_client"));
+    EXPECT_FALSE(ingress.isAttached("attach_test_client"));
+
+    auto region = SharedMemoryRegion::open(
+        ShmOrderIngress::regionName("attach_test_client"), sizeof(OrderRing)
+    );
+    ASSERT_TRUE(region.has_value());
+    auto* client_ring = static_cast<OrderRing*>(region->data());
+    EXPECT_TRUE(client_ring->try_push(R"({"client_uid":"attach_test_client"})"));
+
+    EXPECT_TRUE(ingress.receive(std::chrono::microseconds(0)).has_value());
+    EXPECT_TRUE(ingress.isAttached("attach_test_client"));
+}
@@ -0,0 +1,169 @@
+#include "client_manager/client_manager.hpp"
+#include "matching/manager/engine_manager.hpp"
+#include "networking/rabbitmq/consumer/RabbitMQConsumer.hpp"
+#include "networking/transport/TransportManager.hpp"
+#include "networking/transport/loopback/LoopbackTransport.hpp"
+#include "pipeline/pipeline.hpp"
+#include "rate_limiting/order_throttle.hpp"
+#include "utils/concurrency/spsc_ring.hpp"
+#include "utils/messages.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+using nutc::messages::SIDE::BUY;
+using nutc::messages::SIDE::SELL;
+using LoopbackTransport = nutc::transport::LoopbackTransport;
+using TransportManager = nutc::transport::TransportManager;
+using Pipeline = nutc::pipeline::Pipeline;
+using Stage = nutc::pipeline::Stage;
+using ClientManager = nutc::manager::ClientManager;
+using OrderThrottle = nutc::rate_limiting::OrderThrottle;
+using RabbitMQConsumer = nutc::rabbitmq::RabbitMQConsumer;
+
+TEST(SpscRingTest, TransfersInOrderAcrossThreads)
+{
+    constexpr int num_items = 20000;
+    nutc::concurrency::SpscRing<int, 64> ring;
+
+    std::thread producer([&ring] {
+        for (int i = 0; i < num_items; i++) {
+            int item = i;
+            while (!ring.try_push(item))
+                std::this_thread::yield();
+        }
+    });
+
+    for (int expected = 0; expected < num_items;) {
+        auto item = ring.try_pop();
+        if (!item.has_value()) {
+            std::this_thread::yield();
+            continue;
+        }
+        ASSERT_EQ(item.value(), expected);
+        expected++;
+    }
+    producer.join();
+    EXPECT_EQ(ring.size(), 0);
+}
+
+TEST(SpscRingTest, RejectsWhenFull)
+{
+    nutc::concurrency::SpscRing<int, 4> ring;
+    for (int i = 0; i < 4; i++)
+        EXPECT_TRUE(ring.try_push(i));
+    int extra = 4;
+    EXPECT_FALSE(ring.try_push(extra));
+    EXPECT_EQ(ring.try_pop().value(), 0);
+    EXPECT_TRUE(ring.try_push(extra));
+}
+
+class PipelineTest : public ::testing::Test {
+protected:
+    void
+    SetUp() override
+    {
+        auto& transports = TransportManager::getInstance();
+        transports.reset();
+        loopback = std::make_shared<LoopbackTransport>();
+        transports.addIngress(loopback);
+        transports.setEgress(loopback);
+
+        clients.add_client("ABC", STARTING_CAPITAL, true);
+        clients.add_client("DEF", STARTING_CAPITAL, true);
+        clients.modify_holdings("DEF", "A", 1000);
+        engine_manager.add_engine("A", clients);
+    }
+
+    void
+    TearDown() override
+    {
+        TransportManager::getInstance().reset();
+        OrderThrottle::getInstance().reset();
+    }
+
+    // Waits until the publish stage has handled the given number of items
+    static bool
+    wait_for_published(const Pipeline& pipeline, uint64_t count)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (pipeline.get_stats(Stage::PUBLISH).processed.load() >= count)
+                return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+
+    std::shared_ptr<LoopbackTransport> loopback;
+    ClientManager clients;
+    nutc::engine_manager::Manager engine_manager;
+};
+
+TEST_F(PipelineTest, MatchesOrdersEndToEnd)
+{
+    constexpr int num_orders = 1000;
+    Pipeline pipeline(clients, engine_manager);
+    pipeline.start();
+
+    for (int i = 0; i < num_orders; i++) {
+        loopback->submit(glz::write_json(MarketOrder{"DEF", SELL, "A", 1, 1}));
+        loopback->submit(glz::write_json(MarketOrder{"ABC", BUY, "A", 1, 1}));
+    }
+    ASSERT_TRUE(wait_for_published(pipeline, 2 * num_orders));
+    pipeline.stop();
+
+    EXPECT_FLOAT_EQ(clients.get_holdings("ABC", "A"), num_orders);
+    EXPECT_FLOAT_EQ(clients.get_capital("DEF"), STARTING_CAPITAL + num_orders);
+
+    // Per pair: the resting ask, an account update, the match and the level totals
+    // for the ask ABC's bid consumed
+    EXPECT_EQ(loopback->drain("ABC").size(), 4 * num_orders);
+    EXPECT_EQ(pipeline.get_stats(Stage::MATCH).processed.load(), 2 * num_orders);
+}
+
+TEST_F(PipelineTest, RiskStageRejectsInvalidOrders)
+{
+    Pipeline pipeline(clients, engine_manager);
+    pipeline.start();
+
+    loopback->submit(glz::write_json(MarketOrder{"XYZ", BUY, "A", 1, 1}));
+    loopback->submit(glz::write_json(MarketOrder{"ABC", BUY, "Z", 1, 1}));
+    loopback->submit(glz::write_json(MarketOrder{"ABC", BUY, "A", -1, 1}));
+    loopback->submit(glz::write_json(MarketOrder{"ABC", BUY, "A", 1, 1}));
+    ASSERT_TRUE(wait_for_published(pipeline, 1));
+    pipeline.stop();
+
+    EXPECT_EQ(pipeline.get_stats(Stage::RISK).processed.load(), 4);
+    EXPECT_EQ(pipeline.get_stats(Stage::MATCH).processed.load(), 1);
+}
+
+TEST_F(PipelineTest, ThrottledOrdersReachPublishAsRejections)
+{
+    OrderThrottle::getInstance().configure({0.001, 1}, {1000, 1000}, {"ABC"}, {"A"});
+    auto& metrics = RabbitMQConsumer::getMetrics();
+    uint64_t received = metrics.received.value();
+    uint64_t throttled = metrics.throttled.value();
+    Pipeline pipeline(clients, engine_manager);
+    pipeline.start();
+
+    loopback->submit(glz::write_json(MarketOrder{"ABC", BUY, "A", 1, 1}));
+    loopback->submit(glz::write_json(MarketOrder{"ABC", BUY, "A", 1, 1}));
+    ASSERT_TRUE(wait_for_published(pipeline, 2));
+    pipeline.stop();
+
+    EXPECT_EQ(pipeline.get_stats(Stage::MATCH).processed.load(), 2);
+    // The level totals for the first bid, then the rejection of the second
+    auto messages = loopback->drain("ABC");
+    ASSERT_EQ(messages.size(), 2);
+    EXPECT_NE(messages.at(0).find("level_totals"), std::string::npos);
+    EXPECT_NE(messages.at(1).find("reject_reason"), std::string::npos);
+
+    // Counted like the legacy consumer counts them
+    EXPECT_EQ(metrics.received.value() - received, 2);
+    EXPECT_EQ(metrics.throttled.value() - throttled, 1);
+}
@@ -0,0 +1,183 @@
+#include "config.h"
+#include "rate_limiting/order_throttle.hpp"
+#include "rate_limiting/token_bucket.hpp"
+#include "utils/messages.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+
+using nutc::messages::SIDE::BUY;
+using MarketOrder = nutc::messages::MarketOrder;
+using InitMessage = nutc::messages::InitMessage;
+using SnapshotRequest = nutc::messages::SnapshotRequest;
+using OrderThrottle = nutc::rate_limiting::OrderThrottle;
+using TokenBucket = nutc::rate_limiting::TokenBucket;
+using nutc::rate_limiting::peek_string_field;
+
+namespace {
+const auto START = std::chrono::steady_clock::time_point{} + std::chrono::hours(1);
+
+std::string
+order(const std::string& uid, const std::string& ticker)
+{
+    return glz::write_json(MarketOrder{uid, BUY, ticker, 1, 1});
+}
+} // namespace
+
+TEST(TokenBucketTest, AllowsBurstThenRefills)
+{
+    TokenBucket bucket({2, 3}, START);
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(bucket.has_token(START));
+        bucket.consume();
+    }
+    EXPECT_FALSE(bucket.has_token(START));
+    EXPECT_FALSE(bucket.has_token(START + std::chrono::milliseconds(400)));
+    EXPECT_TRUE(bucket.has_token(START + std::chrono::milliseconds(500)));
+}
+
+TEST(TokenBucketTest, NeverExceedsBurst)
+{
+    TokenBucket bucket({100, 2}, START);
+    auto later = START + std::chrono::seconds(60);
+    for (int i = 0; i < 2; i++) {
+        ASSERT_TRUE(bucket.has_token(later));
+        bucket.consume();
+    }
+    EXPECT_FALSE(bucket.has_token(later));
+}
+
+TEST(PeekStringFieldTest, FindsFieldsOfSerializedOrder)
+{
+    std::string raw = order("ABC", "A");
+    EXPECT_EQ(peek_string_field(raw, "\"client_uid\""), "ABC");
+    EXPECT_EQ(peek_string_field(raw, "\"ticker\""), "A");
+    EXPECT_FALSE(peek_string_field(raw, "\"requester_uid\"").has_value());
+}
+
+TEST(PeekStringFieldTest, SkipsKeyTextInValuesAndWhitespace)
+{
+    std::string raw = R"({"client_uid": "ticker", "ticker" : "B"})";
+    EXPECT_EQ(peek_string_field(raw, "\"ticker\""), "B");
+    EXPECT_FALSE(peek_string_field(R"({"ticker":5})", "\"ticker\"").has_value());
+}
+
+TEST(PeekStringFieldTest, RefusesRepeatedAndEscapedFields)
+{
+    EXPECT_FALSE(
+        peek_string_field(R"({"ticker":"A","ticker":"B"})", "\"ticker\"").has_value()
+    );
+    EXPECT_FALSE(peek_string_field(R"({"ticker":"\u0041"})", "\"ticker\"").has_value());
+}
+
+class OrderThrottleTest : public ::testing::Test {
+protected:
+    void
+    TearDown() override
+    {
+        OrderThrottle::getInstance().reset();
+    }
+
+    OrderThrottle& throttle = OrderThrottle::getInstance();
+};
+
+TEST_F(OrderThrottleTest, DisabledUntilConfigured)
+{
+    for (int i = 0; i < 100; i++)
+        EXPECT_FALSE(throttle.check(order("ABC", "A"), START).has_value());
+}
+
+TEST_F(OrderThrottleTest, ThrottlesClientOverLimit)
+{
+    throttle.configure({1, 2}, {100, 100}, {"ABC", "DEF"}, {"A"}, START);
+    EXPECT_FALSE(throttle.check(order("ABC", "A"), START).has_value());
+    EXPECT_FALSE(throttle.check(order("ABC", "A"), START).has_value());
+
+    auto rejection = throttle.check(order("ABC", "A"), START);
+    ASSERT_TRUE(rejection.has_value());
+    EXPECT_EQ(rejection->client_uid, "ABC");
+    EXPECT_EQ(rejection->message.ticker, "A");
+
+    // Other clients keep their own budget
+    EXPECT_FALSE(throttle.check(order("DEF", "A"), START).has_value());
+    EXPECT_FALSE(
+        throttle.check(order("ABC", "A"), START + std::chrono::seconds(1)).has_value()
+    );
+
+    EXPECT_EQ(throttle.get_throttled_total(), 1);
+    EXPECT_EQ(throttle.get_throttled_for_client("ABC"), 1);
+    EXPECT_EQ(throttle.get_throttled_for_client("DEF"), 0);
+}
+
+TEST_F(OrderThrottleTest, ThrottlesTickerAcrossClients)
+{
+    throttle.configure({100, 100}, {1, 2}, {"ABC", "DEF"}, {"A", "B"}, START);
+    EXPECT_FALSE(throttle.check(order("ABC", "A"), START).has_value());
+    EXPECT_FALSE(throttle.check(order("DEF", "A"), START).has_value());
+    EXPECT_TRUE(throttle.check(order("ABC", "A"), START).has_value());
+    EXPECT_FALSE(throttle.check(order("ABC", "B"), START).has_value());
+
+    EXPECT_EQ(throttle.get_throttled_for_ticker("A"), 1);
+    EXPECT_EQ(throttle.get_throttled_for_client("ABC"), 0);
+}
+
+TEST_F(OrderThrottleTest, RejectsUnknownSendersAndIgnoresOtherMessages)
+{
+    throttle.configure({1, 1}, {1, 1}, {"ABC"}, {"A"}, START);
+    EXPECT_FALSE(throttle.check(order("ABC", "A"), START).has_value());
+
+    // Tracked nowhere but the total
+    auto rejection = throttle.check(order("XYZ", "Z"), START);
+    ASSERT_TRUE(rejection.has_value());
+    EXPECT_EQ(rejection->client_uid, "XYZ");
+    EXPECT_TRUE(
+        throttle.check(glz::write_json(SnapshotRequest{"XYZ"}), START).has_value()
+    );
+    EXPECT_EQ(throttle.get_throttled_for_client("XYZ"), 0);
+
+    EXPECT_FALSE(
+        throttle.check(glz::write_json(InitMessage{"ABC", true}), START).has_value()
+    );
+    EXPECT_FALSE(
+        throttle.check(glz::write_json(SnapshotRequest{"ABC"}), START).has_value()
+    );
+    EXPECT_EQ(throttle.get_throttled_total(), 2);
+}
+
+TEST_F(OrderThrottleTest, RejectsOrdersItCannotReadLikeTheDecoder)
+{
+    throttle.configure({100, 100}, {100, 100}, {"ABC"}, {"A"}, START);
+    std::string escaped = order("ABC", "A");
+    escaped.replace(escaped.find("ABC"), 3, "\\u0041BC");
+    EXPECT_TRUE(throttle.check(escaped, START).has_value());
+
+    std::string repeated = order("ABC", "A");
+    repeated.insert(1, R"("client_uid":"XYZ",)");
+    EXPECT_TRUE(throttle.check(repeated, START).has_value());
+    EXPECT_FALSE(throttle.check(order("ABC", "A"), START).has_value());
+}
+
+TEST_F(OrderThrottleTest, ThrottlesSnapshotRequestsPerClient)
+{
+    throttle.configure({100, 100}, {100, 100}, {"ABC", "DEF"}, {"A"}, START);
+    std::string request = glz::write_json(SnapshotRequest{"ABC"});
+    for (int i = 0; i < SNAPSHOT_REQUEST_BURST; i++)
+        EXPECT_FALSE(throttle.check(request, START).has_value());
+
+    auto rejection = throttle.check(request, START);
+    ASSERT_TRUE(rejection.has_value());
+    EXPECT_EQ(rejection->client_uid, "ABC");
+    EXPECT_FALSE(
+        throttle.check(glz::write_json(SnapshotRequest{"DEF"}), START).has_value()
+    );
+
+    // Orders have their own budget
+    EXPECT_FALSE(throttle.check(order("ABC", "A"), START).has_value());
+    auto refilled = START
+                    + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double>(1 / SNAPSHOT_REQUEST_RATE)
+                    );
+    EXPECT_FALSE(throttle.check(request, refilled).has_value());
+}
@@ -0,0 +1,124 @@
+#include "process_spawning/spawning.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <sys/prctl.h>
+
+namespace client = nutc::client;
+
+// Puts a stand-in NUTC-client on the PATH: as a zygote it "forks" a sleep per request
+// and reports it; as a client it saves its arguments and exits immediately
+class SpawningTest : public ::testing::Test {
+protected:
+    void
+    SetUp() override
+    {
+        directory = std::filesystem::temp_directory_path()
+                    / ("nutc_spawning_" + std::to_string(getpid()));
+        std::filesystem::create_directories(directory);
+        std::filesystem::path script = directory / "NUTC-client";
+        std::ofstream(script) << "#!/bin/sh\n"
+                                 "[ \"$1\" = \"--zygote\" ] || "
+                                 "{ echo \"$@\" > \"$0.args\"; exit 0; }\n"
+                                 "while IFS=\"$(printf '\\t')\" read -r uid shm; do\n"
+                                 "  sleep 0 &\n"
+                                 "  printf '%s\\t%s\\n' \"$uid\" \"$!\" >&3\n"
+                                 "done\n";
+        std::filesystem::permissions(script, std::filesystem::perms::owner_all);
+
+        const char* path = std::getenv("PATH");
+        original_path = path == nullptr ? "" : path;
+        setenv("PATH", (directory.string() + ":" + original_path).c_str(), 1);
+
+        // spawn_with_zygote makes the test process a subreaper
+        prctl(PR_GET_CHILD_SUBREAPER, &subreaper);
+    }
+
+    void
+    TearDown() override
+    {
+        prctl(PR_SET_CHILD_SUBREAPER, subreaper);
+        setenv("PATH", original_path.c_str(), 1);
+        std::filesystem::remove_all(directory);
+    }
+
+    static void
+    reap(const std::vector<client::SpawnedClient>& spawned)
+    {
+        for (const auto& child : spawned)
+            waitpid(child.pid, nullptr, 0);
+    }
+
+    std::filesystem::path directory;
+    std::string original_path;
+    int subreaper = 0;
+};
+
+TEST_F(SpawningTest, ExecModeStartsEveryClient)
+{
+    nutc::manager::ClientManager users;
+    for (int i = 0; i < 20; i++)
+        users.add_client("client-" + std::to_string(i));
+
+    auto spawned = client::spawn_all_clients(users, false);
+    EXPECT_EQ(spawned.size(), 20);
+    reap(spawned);
+}
+
+TEST_F(SpawningTest, ZygoteReportsEveryForkedClient)
+{
+    std::vector<client::ClientLaunch> launches{
+        {"abc", false},
+        {"def", true}
+    };
+    auto spawned = client::spawn_with_zygote(launches, false);
+
+    ASSERT_EQ(spawned.size(), 2);
+    EXPECT_EQ(spawned[0].uid, "abc");
+    EXPECT_EQ(spawned[1].uid, "def");
+    EXPECT_GT(spawned[0].pid, 0);
+    reap(spawned);
+}
+
+TEST_F(SpawningTest, ZygoteExchangeOutgrowsPipeBuffers)
+{
+    // Reports its own pid for every request, more than a pipe holds either way
+    std::ofstream(directory / "NUTC-client") << "#!/bin/sh\n"
+                                                "while read -r uid shm; do\n"
+                                                "  printf '%s\\t%s\\n' \"$uid\" $$ >&3\n"
+                                                "done\n";
+    std::vector<client::ClientLaunch> launches;
+    for (int i = 0; i < 2000; i++)
+        launches.push_back({std::string(64, 'a') + std::to_string(i), false});
+
+    auto spawned = client::spawn_with_zygote(launches, false);
+    ASSERT_EQ(spawned.size(), launches.size());
+    EXPECT_EQ(spawned.back().uid, launches.back().uid);
+}
+
+TEST_F(SpawningTest, HostTakesEveryClientsUid)
+{
+    std::vector<client::ClientLaunch> launches{
+        {"abc-1", true},
+        {"def",   false}
+    };
+    auto pid = client::launch_host(launches, false);
+    ASSERT_TRUE(pid.has_value());
+    waitpid(pid.value(), nullptr, 0);
+
+    // Not every client has an order ring, so none of them uses shared memory
+    std::string args;
+    std::getline(std::ifstream(directory / "NUTC-client.args"), args);
+    EXPECT_EQ(args, "--uid abc 1 def");
+}
+
+TEST_F(SpawningTest, MissingBinaryIsNotFatal)
+{
+    setenv("PATH", "/nonexistent", 1);
+    EXPECT_FALSE(client::spawn_client("abc", false).has_value());
+}
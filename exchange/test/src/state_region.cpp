@@ -0,0 +1,95 @@
+#include "client_manager/client_manager.hpp"
+#include "matching/manager/engine_manager.hpp"
+#include "monitoring/state_publisher.hpp"
+#include "monitoring/state_region.hpp"
+#include "utils/shared_memory/shared_memory.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+using nutc::messages::SIDE::BUY;
+using nutc::messages::SIDE::SELL;
+using nutc::monitoring::read_name;
+using ClientManager = nutc::manager::ClientManager;
+using MarketOrder = nutc::messages::MarketOrder;
+using SharedMemoryRegion = nutc::shared_memory::SharedMemoryRegion;
+using StatePublisher = nutc::monitoring::StatePublisher;
+using StateRegion = nutc::monitoring::StateRegion;
+
+namespace {
+constexpr const char* REGION_NAME = "/nutc_state_test";
+} // namespace
+
+TEST(StateRegionTest, MonitorSeesPublishedState)
+{
+    ClientManager clients;
+    nutc::engine_manager::Manager engine_manager;
+    clients.add_client("ABC", STARTING_CAPITAL, true);
+    clients.add_client("DEF", STARTING_CAPITAL, true);
+    clients.modify_holdings("DEF", "A", 10);
+    engine_manager.add_engine("A", clients);
+    engine_manager.add_engine("B", clients);
+
+    auto& engine = engine_manager.get_engine("A").value().get();
+    MarketOrder sell{"DEF", SELL, "A", 5, 2};
+    MarketOrder buy{"ABC", BUY, "A", 1, 2};
+    MarketOrder bid{"ABC", BUY, "A", 3, 1};
+    engine.match_order(sell, clients);
+    engine.match_order(buy, clients);
+    engine.match_order(bid, clients);
+
+    auto publisher = StatePublisher::create(REGION_NAME);
+    ASSERT_TRUE(publisher.has_value());
+    publisher->publish(clients, engine_manager);
+
+    auto region = SharedMemoryRegion::open(REGION_NAME, sizeof(StateRegion), false);
+    ASSERT_TRUE(region.has_value());
+    const auto* state = static_cast<const StateRegion*>(region->data());
+    ASSERT_TRUE(state->is_initialized());
+
+    auto copy = std::make_unique<StateRegion>();
+    ASSERT_TRUE(state->try_read([&copy](const StateRegion& live) {
+        std::memcpy(static_cast<void*>(copy.get()), &live, sizeof(StateRegion));
+    }));
+
+    EXPECT_EQ(copy->num_clients, 2);
+    EXPECT_EQ(copy->num_tickers, 2);
+    EXPECT_EQ(copy->counters.publishes, 1);
+    EXPECT_EQ(copy->counters.active_clients, 2);
+
+    const auto& book = copy->tickers[0];
+    EXPECT_EQ(read_name(book.ticker), "A");
+    EXPECT_FLOAT_EQ(book.best_bid, 1);
+    EXPECT_FLOAT_EQ(book.best_bid_quantity, 3);
+    EXPECT_FLOAT_EQ(book.best_ask, 2);
+    EXPECT_FLOAT_EQ(book.best_ask_quantity, 4);
+    EXPECT_EQ(book.bid_levels, 1);
+    EXPECT_EQ(book.ask_levels, 1);
+    EXPECT_FLOAT_EQ(book.last_trade, 2);
+
+    auto abc = clients.get_client_id("ABC").value();
+    EXPECT_EQ(read_name(copy->clients[abc].uid), "ABC");
+    EXPECT_FLOAT_EQ(copy->clients[abc].capital_remaining, STARTING_CAPITAL - 2);
+    EXPECT_FLOAT_EQ(copy->holdings[abc][0], 1);
+    EXPECT_FLOAT_EQ(copy->holdings[abc][1], 0);
+}
+
+TEST(StateRegionTest, ReadDuringWriteIsRejected)
+{
+    auto state = std::make_unique<StateRegion>();
+    state->initialize();
+
+    state->begin_write();
+    EXPECT_FALSE(state->try_read([](const StateRegion&) {}));
+    state->end_write();
+    EXPECT_TRUE(state->try_read([](const StateRegion&) {}));
+
+    // A write that lands while the reader is copying invalidates the copy
+    EXPECT_FALSE(state->try_read([&state](const StateRegion&) {
+        state->begin_write();
+        state->end_write();
+    }));
+}
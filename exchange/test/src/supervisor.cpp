@@ -0,0 +1,189 @@
+#include "client_manager/client_manager.hpp"
+#include "matching/manager/engine_manager.hpp"
+#include "networking/transport/TransportManager.hpp"
+#include "networking/transport/loopback/LoopbackTransport.hpp"
+#include "pipeline/pipeline.hpp"
+#include "process_spawning/supervisor.hpp"
+#include "utils/messages.hpp"
+
+#include <gtest/gtest.h>
+
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+using nutc::messages::SIDE::SELL;
+using Supervisor = nutc::client::Supervisor;
+using RestartPolicy = nutc::client::RestartPolicy;
+using ClientLaunch = nutc::client::ClientLaunch;
+using std::chrono::milliseconds;
+
+namespace {
+pid_t
+fork_child(int exit_code)
+{
+    pid_t pid = fork();
+    if (pid == 0)
+        _exit(exit_code);
+    return pid;
+}
+
+template <typename Predicate>
+bool
+wait_until(Predicate predicate)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (predicate())
+            return true;
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    return false;
+}
+} // namespace
+
+class SupervisorTest : public ::testing::Test {
+protected:
+    void
+    TearDown() override
+    {
+        Supervisor::getInstance().stop();
+    }
+
+    Supervisor& supervisor = Supervisor::getInstance();
+};
+
+TEST_F(SupervisorTest, BackoffDoublesUpToMax)
+{
+    RestartPolicy policy{5, milliseconds(100), milliseconds(350)};
+    EXPECT_EQ(nutc::client::restart_backoff(policy, 0), milliseconds(100));
+    EXPECT_EQ(nutc::client::restart_backoff(policy, 1), milliseconds(200));
+    EXPECT_EQ(nutc::client::restart_backoff(policy, 2), milliseconds(350));
+    EXPECT_EQ(nutc::client::restart_backoff(policy, 10), milliseconds(350));
+}
+
+TEST_F(SupervisorTest, ReapsExitedClientAndRecordsReason)
+{
+    ASSERT_TRUE(supervisor.start({0, milliseconds(0), milliseconds(0)}));
+    pid_t pid = fork_child(3);
+    supervisor.watch({"ABC", false}, pid);
+
+    ASSERT_TRUE(wait_until([&] { return supervisor.has_exited(); }));
+    EXPECT_EQ(supervisor.take_exited(), std::vector<std::string>{"ABC"});
+    EXPECT_FALSE(supervisor.has_exited());
+
+    auto records = supervisor.get_exit_records();
+    ASSERT_EQ(records.size(), 1);
+    EXPECT_EQ(records[0].pid, pid);
+    EXPECT_FALSE(records[0].restarting);
+    EXPECT_EQ(nutc::client::describe_exit(records[0].status), "exited with status 3");
+    // Reaped, so no longer a zombie
+    EXPECT_EQ(waitpid(pid, nullptr, WNOHANG), -1);
+}
+
+TEST_F(SupervisorTest, RecordsKillingSignal)
+{
+    ASSERT_TRUE(supervisor.start({0, milliseconds(0), milliseconds(0)}));
+    pid_t pid = fork();
+    if (pid == 0) {
+        pause();
+        _exit(0);
+    }
+    supervisor.watch({"ABC", false}, pid);
+    kill(pid, SIGKILL);
+
+    ASSERT_TRUE(wait_until([&] { return supervisor.has_exited(); }));
+    auto records = supervisor.get_exit_records();
+    ASSERT_EQ(records.size(), 1);
+    EXPECT_TRUE(WIFSIGNALED(records[0].status));
+    EXPECT_EQ(WTERMSIG(records[0].status), SIGKILL);
+}
+
+TEST_F(SupervisorTest, RestartsUpToLimit)
+{
+    int respawns = 0;
+    ASSERT_TRUE(supervisor.start(
+        {2, milliseconds(1), milliseconds(4)},
+        [&respawns](const ClientLaunch& launch) {
+            EXPECT_EQ(launch.uid, "ABC");
+            EXPECT_TRUE(launch.use_shm);
+            respawns++;
+            return std::optional<pid_t>(fork_child(1));
+        }
+    ));
+    supervisor.watch({"ABC", true}, fork_child(1));
+
+    ASSERT_TRUE(wait_until([&] { return supervisor.get_exit_records().size() == 3; }));
+    EXPECT_EQ(supervisor.get_restarts("ABC"), 2);
+    EXPECT_EQ(respawns, 2);
+    auto records = supervisor.get_exit_records();
+    EXPECT_TRUE(records[0].restarting);
+    EXPECT_TRUE(records[1].restarting);
+    EXPECT_FALSE(records[2].restarting);
+    EXPECT_EQ(supervisor.take_exited().size(), 3);
+}
+
+TEST_F(SupervisorTest, RecordsEveryClientOfSharedProcess)
+{
+    ASSERT_TRUE(supervisor.start({0, milliseconds(0), milliseconds(0)}));
+    // Exits once both clients are watched
+    std::array<int, 2> release{};
+    ASSERT_EQ(pipe(release.data()), 0);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(release[1]);
+        char byte = 0;
+        [[maybe_unused]] ssize_t bytes = read(release[0], &byte, 1);
+        _exit(2);
+    }
+    supervisor.watch({"ABC", false}, pid);
+    supervisor.watch({"DEF", false}, pid);
+    close(release[1]);
+    close(release[0]);
+
+    ASSERT_TRUE(wait_until([&] { return supervisor.get_exit_records().size() == 2; }));
+    auto exited = supervisor.take_exited();
+    EXPECT_EQ(exited, (std::vector<std::string>{"ABC", "DEF"}));
+    for (const auto& record : supervisor.get_exit_records()) {
+        EXPECT_EQ(record.pid, pid);
+        EXPECT_EQ(nutc::client::describe_exit(record.status), "exited with status 2");
+    }
+}
+
+TEST_F(SupervisorTest, PipelineStopsFanoutToExitedClient)
+{
+    auto& transports = nutc::transport::TransportManager::getInstance();
+    transports.reset();
+    auto loopback = std::make_shared<nutc::transport::LoopbackTransport>();
+    transports.addIngress(loopback);
+    transports.setEgress(loopback);
+
+    nutc::manager::ClientManager clients;
+    clients.add_client("ABC", STARTING_CAPITAL, true);
+    clients.add_client("DEF", STARTING_CAPITAL, true);
+    clients.add_client("GHI", STARTING_CAPITAL, true);
+    clients.modify_holdings("DEF", "A", 1000);
+    nutc::engine_manager::Manager engine_manager;
+    engine_manager.add_engine("A", clients);
+
+    ASSERT_TRUE(supervisor.start({0, milliseconds(0), milliseconds(0)}));
+    nutc::pipeline::Pipeline pipeline(clients, engine_manager);
+    pipeline.start();
+    supervisor.watch({"GHI", false}, fork_child(0));
+    ASSERT_TRUE(wait_until([&] {
+        return !supervisor.get_exit_records().empty() && !supervisor.has_exited();
+    }));
+
+    loopback->submit(glz::write_json(MarketOrder{"DEF", SELL, "A", 1, 1}));
+    ASSERT_TRUE(wait_until([&] { return loopback->drain("ABC").size() == 1; }));
+    pipeline.stop();
+    transports.reset();
+
+    EXPECT_TRUE(loopback->drain("GHI").empty());
+}
@@ -0,0 +1,53 @@
+#include "tracing/trace.hpp"
+
+#include <gtest/gtest.h>
+
+#include <glaze/glaze.hpp>
+
+#include <string>
+#include <thread>
+
+using TraceRing = nutc::tracing::TraceRing;
+using TraceEvent = nutc::tracing::TraceEvent;
+using Tracer = nutc::tracing::Tracer;
+
+TEST(TraceRingTest, KeepsTheMostRecentEvents)
+{
+    TraceRing ring(1, 4);
+    for (uint64_t i = 0; i < 6; i++)
+        ring.record(TraceEvent{"span", i, i + 1, static_cast<int64_t>(i)});
+
+    // The oldest slot is the one the next record overwrites, so it is left out
+    auto events = ring.snapshot();
+    ASSERT_EQ(events.size(), 3);
+    EXPECT_EQ(events.front().arg, 3);
+    EXPECT_EQ(events.back().arg, 5);
+
+    ring.clear();
+    EXPECT_TRUE(ring.snapshot().empty());
+}
+
+TEST(TracerTest, ExportsEveryThreadAsChromeTraceJson)
+{
+    auto& tracer = Tracer::getInstance();
+    tracer.reset();
+
+    std::thread worker([&tracer] {
+        tracer.set_thread_name("worker");
+        nutc::tracing::Span span("match", 42);
+    });
+    worker.join();
+    {
+        nutc::tracing::Span span("decode");
+    }
+
+    std::string json = tracer.to_chrome_json();
+    glz::json_t parsed{};
+    ASSERT_FALSE(glz::read_json(parsed, json));
+
+    EXPECT_NE(json.find(R"("name":"worker")"), std::string::npos);
+    EXPECT_NE(json.find(R"("name":"match","ph":"X")"), std::string::npos);
+    EXPECT_NE(json.find(R"("args":{"order":42})"), std::string::npos);
+    EXPECT_NE(json.find(R"("name":"decode","ph":"X")"), std::string::npos);
+    tracer.reset();
+}
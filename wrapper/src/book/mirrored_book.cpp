@@ -0,0 +1,104 @@
+#include "mirrored_book.hpp"
+
+#include <algorithm>
+
+namespace nutc {
+namespace book {
+
+MirroredBook::MirroredBook()
+{
+    bid_levels.reserve(BOOK_MAX_LEVELS);
+    ask_levels.reserve(BOOK_MAX_LEVELS);
+}
+
+void
+MirroredBook::set_level(messages::SIDE side, float price, float quantity)
+{
+    std::vector<Level>& levels = side == messages::SIDE::BUY ? bid_levels : ask_levels;
+    auto better = [side](const Level& level, float other_price) {
+        return side == messages::SIDE::BUY ? level.price > other_price
+                                           : level.price < other_price;
+    };
+    auto level = std::lower_bound(levels.begin(), levels.end(), price, better);
+    bool exists =
+        level != levels.end() && messages::is_close_to_zero(level->price - price);
+
+    if (quantity <= 0 || messages::is_close_to_zero(quantity)) {
+        if (exists)
+            levels.erase(level);
+        return;
+    }
+    if (exists) {
+        level->quantity = quantity;
+        return;
+    }
+
+    // Never grow past the reserved storage, views point into it
+    if (levels.size() == BOOK_MAX_LEVELS) {
+        if (level == levels.end())
+            return;
+        levels.pop_back();
+    }
+    levels.insert(level, Level{price, quantity});
+}
+
+void
+MirroredBook::clear()
+{
+    bid_levels.clear();
+    ask_levels.clear();
+}
+
+std::optional<Level>
+MirroredBook::best_bid() const
+{
+    if (bid_levels.empty())
+        return std::nullopt;
+    return bid_levels.front();
+}
+
+std::optional<Level>
+MirroredBook::best_ask() const
+{
+    if (ask_levels.empty())
+        return std::nullopt;
+    return ask_levels.front();
+}
+
+void
+OrderBooks::apply(const messages::ObUpdate& update)
+{
+    get(update.security).set_level(update.side, update.price, update.level_quantity);
+}
+
+void
+OrderBooks::reset(const std::vector<messages::ObUpdate>& levels)
+{
+    // Cleared rather than erased, Python may hold views of them
+    for (auto& [ticker, book] : books)
+        book.clear();
+    for (const auto& level : levels)
+        apply(level);
+}
+
+std::vector<messages::ObUpdate>
+OrderBooks::clearing_updates() const
+{
+    std::vector<messages::ObUpdate> updates;
+    for (const auto& [ticker, book] : books) {
+        for (const Level& level : book.bids())
+            updates.push_back({ticker, messages::SIDE::BUY, level.price, 0, 0});
+        for (const Level& level : book.asks())
+            updates.push_back({ticker, messages::SIDE::SELL, level.price, 0, 0});
+    }
+    return updates;
+}
+
+MirroredBook&
+OrderBooks::get(const std::string& ticker)
+{
+    return books.try_emplace(ticker).first->second;
+}
+
+} // namespace book
+} // namespace nutc
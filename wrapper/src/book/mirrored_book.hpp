@@ -0,0 +1,114 @@
+#pragma once
+
+#include "config.h"
+#include "util/messages.hpp"
+
+#include <cstddef>
+
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nutc {
+/**
+ * @brief Order books mirrored from the exchange's market data
+ */
+namespace book {
+
+/**
+ * @brief One price level; laid out so a run of levels is an (n, 2) float32 array
+ */
+struct Level {
+    float price;
+    float quantity;
+};
+
+static_assert(sizeof(Level) == 2 * sizeof(float), "levels must pack into an array");
+
+/**
+ * @class MirroredBook
+ * @brief L2 book for one ticker, built from the level totals in each ObUpdate
+ *
+ * Each side keeps at most BOOK_MAX_LEVELS levels, best first, in storage that is
+ * allocated once and never moves, so Python can view it without copying. A view sees
+ * updates as they are applied, but its length is fixed when it is taken. Once a side
+ * is full, levels worse than all of those kept are dropped.
+ */
+class MirroredBook {
+public:
+    MirroredBook();
+
+    MirroredBook(const MirroredBook&) = delete;
+    MirroredBook& operator=(const MirroredBook&) = delete;
+    MirroredBook(MirroredBook&&) = default;
+    MirroredBook& operator=(MirroredBook&&) = default;
+    ~MirroredBook() = default;
+
+    /**
+     * @brief Sets the quantity resting at a price; 0 removes the level
+     */
+    void set_level(messages::SIDE side, float price, float quantity);
+
+    void clear();
+
+    [[nodiscard]] std::optional<Level> best_bid() const;
+    [[nodiscard]] std::optional<Level> best_ask() const;
+
+    /**
+     * @brief Bids from highest price to lowest
+     */
+    [[nodiscard]] std::span<const Level>
+    bids() const
+    {
+        return bid_levels;
+    }
+
+    /**
+     * @brief Asks from lowest price to highest
+     */
+    [[nodiscard]] std::span<const Level>
+    asks() const
+    {
+        return ask_levels;
+    }
+
+private:
+    std::vector<Level> bid_levels;
+    std::vector<Level> ask_levels;
+};
+
+/**
+ * @class OrderBooks
+ * @brief Every ticker's MirroredBook, as seen by one client
+ *
+ * Books are created on first use and live as long as this object, so references to
+ * them stay valid.
+ */
+class OrderBooks {
+public:
+    /**
+     * @brief Applies an orderbook update from the exchange
+     */
+    void apply(const messages::ObUpdate& update);
+
+    /**
+     * @brief Replaces every book with the levels of a snapshot
+     */
+    void reset(const std::vector<messages::ObUpdate>& levels);
+
+    /**
+     * @brief A zero quantity update for every level currently held, which an algo
+     * mirroring the same books applies to empty them
+     */
+    [[nodiscard]] std::vector<messages::ObUpdate> clearing_updates() const;
+
+    MirroredBook& get(const std::string& ticker);
+
+private:
+    std::unordered_map<std::string, MirroredBook> books;
+};
+
+} // namespace book
+} // namespace nutc
@@ -0,0 +1,24 @@
+#include "update_conflator.hpp"
+
+#include <utility>
+
+namespace nutc {
+namespace book {
+
+void
+UpdateConflator::add(const messages::ObUpdate& update)
+{
+    Key key{update.security, update.side, update.price};
+    auto [index, inserted] = held_index.try_emplace(std::move(key), held.size());
+    if (inserted) {
+        held.push_back(update);
+        return;
+    }
+
+    // Quantities are per order, so only the latest update still means anything
+    held[index->second] = update;
+    conflated_count++;
+}
+
+} // namespace book
+} // namespace nutc
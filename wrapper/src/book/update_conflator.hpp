@@ -0,0 +1,76 @@
+#pragma once
+
+#include "util/messages.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nutc {
+namespace book {
+
+/**
+ * @class UpdateConflator
+ * @brief Holds orderbook updates back, keeping one per ticker, side and price
+ *
+ * An update for a level that already has one held replaces it, so each level is
+ * described by its latest update and level total. Held updates keep the order in which
+ * their levels first changed.
+ */
+class UpdateConflator {
+public:
+    void add(const messages::ObUpdate& update);
+
+    /**
+     * @brief Calls deliver with every held update, then forgets them
+     */
+    template <typename Deliver>
+    void
+    drain(Deliver&& deliver)
+    {
+        for (const auto& update : held)
+            deliver(update);
+        held.clear();
+        held_index.clear();
+    }
+
+    /**
+     * @brief Updates replaced by a later one for the same level so far
+     */
+    [[nodiscard]] uint64_t
+    conflated() const
+    {
+        return conflated_count;
+    }
+
+private:
+    struct Key {
+        std::string ticker;
+        messages::SIDE side;
+        float price;
+
+        bool operator==(const Key& other) const = default;
+    };
+
+    struct KeyHash {
+        size_t
+        operator()(const Key& key) const
+        {
+            size_t hash = std::hash<std::string>{}(key.ticker);
+            size_t price = std::hash<float>{}(key.price);
+            hash ^= price + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            return hash ^ static_cast<size_t>(key.side);
+        }
+    };
+
+    std::vector<messages::ObUpdate> held;
+    std::unordered_map<Key, size_t, KeyHash> held_index;
+    uint64_t conflated_count = 0;
+};
+
+} // namespace book
+} // namespace nutc
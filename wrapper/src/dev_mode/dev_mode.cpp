@@ -12,7 +12,7 @@ file_exists(const std::string& filename) noexcept
 std::string
 read_file_content(const std::string& filename)
 {
-    std::ifstream file(filename);
+    std::ifstream file(filename, std::ios::binary);
     std::stringstream buffer;
     buffer << file.rdbuf();
     return buffer.str();
@@ -21,6 +21,12 @@ read_file_content(const std::string& filename)
 std::string
 get_algo_from_file(const std::string& uid)
 {
+    // A native strategy, if built, takes precedence
+    std::string native_filename = fmt::format("./algos/{}.so", uid);
+    if (file_exists(native_filename)) {
+        return read_file_content(native_filename);
+    }
+
     std::string filename = fmt::format("./algos/{}.py", uid);
     if (!file_exists(filename)) {
         throw std::invalid_argument("File not found");
@@ -97,6 +97,8 @@ CREATE_LOG_CATEGORY(web);
 CREATE_LOG_CATEGORY(libcurl);
 CREATE_LOG_CATEGORY(rabbitmq);
 CREATE_LOG_CATEGORY(firebase);
+CREATE_LOG_CATEGORY(shm);
+CREATE_LOG_CATEGORY(native);
 
 #undef CREATE_LOG_CATEGORY
 // NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
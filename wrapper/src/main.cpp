@@ -2,8 +2,10 @@
 #include "dev_mode/dev_mode.hpp"
 #include "firebase/firebase.hpp"
 #include "git.h"
+#include "native/native_strategy.hpp"
 #include "pywrapper/pywrapper.hpp"
 #include "rabbitmq/rabbitmq.hpp"
+#include "zygote/zygote.hpp"
 
 #include <argparse/argparse.hpp>
 #include <pybind11/pybind11.h>
@@ -13,8 +15,10 @@
 #include <optional>
 #include <string>
 #include <tuple>
+#include <utility>
+#include <vector>
 
-static std::tuple<uint8_t, std::string, bool>
+static std::tuple<uint8_t, std::vector<std::string>, bool, bool, bool, bool, bool>
 process_arguments(int argc, const char** argv)
 {
     argparse::ArgumentParser program(
@@ -28,14 +32,43 @@ process_arguments(int argc, const char** argv)
         .implicit_value(true)
         .nargs(0);
 
+    program.add_argument("-S", "--shm")
+        .help("Exchange orders and market data with the exchange over shared memory")
+        .action([](const auto& /* unused */) {})
+        .default_value(false)
+        .implicit_value(true)
+        .nargs(0);
+
+    program.add_argument("-C", "--conflate")
+        .help("Deliver only the latest orderbook update per price level to slow algos")
+        .action([](const auto& /* unused */) {})
+        .default_value(false)
+        .implicit_value(true)
+        .nargs(0);
+
+    program.add_argument("-N", "--native")
+        .help("Load algos that are shared objects as native strategies, in this process")
+        .action([](const auto& /* unused */) {})
+        .default_value(false)
+        .implicit_value(true)
+        .nargs(0);
+
+    program.add_argument("-Z", "--zygote")
+        .help("Preload Python once, then fork a client for every uid read from stdin")
+        .action([](const auto& /* unused */) {})
+        .default_value(false)
+        .implicit_value(true)
+        .nargs(0);
+
     program.add_argument("-U", "--uid")
-        .help("set the user ID")
+        .help("set the user IDs to host in this process (required unless --zygote)")
         .action([](const auto& value) {
             std::string uid = std::string(value);
             std::replace(uid.begin(), uid.end(), ' ', '-');
             return uid;
         })
-        .required();
+        .nargs(argparse::nargs_pattern::at_least_one)
+        .default_value(std::vector<std::string>{});
 
     program.add_argument("-V", "--version")
         .help("prints version information and exits")
@@ -58,6 +91,9 @@ process_arguments(int argc, const char** argv)
 
     try {
         program.parse_args(argc, argv);
+        if (!program.get<bool>("--zygote")
+            && program.get<std::vector<std::string>>("--uid").empty())
+            throw std::runtime_error("--uid is required");
     } catch (const std::runtime_error& err) {
         std::cerr << err.what() << std::endl;
         std::cerr << program;
@@ -65,7 +101,13 @@ process_arguments(int argc, const char** argv)
     }
 
     return std::make_tuple(
-        verbosity, program.get<std::string>("--uid"), program.get<bool>("--dev")
+        verbosity,
+        program.get<std::vector<std::string>>("--uid"),
+        program.get<bool>("--dev"),
+        program.get<bool>("--shm"),
+        program.get<bool>("--zygote"),
+        program.get<bool>("--conflate"),
+        program.get<bool>("--native")
     );
 }
 
@@ -87,39 +129,100 @@ int
 main(int argc, const char** argv)
 {
     // Parse args
-    auto [verbosity, uid, development_mode] = process_arguments(argc, argv);
+    auto [verbosity, uids, development_mode, use_shm, zygote_mode, conflate, native] =
+        process_arguments(argc, argv);
     pybind11::scoped_interpreter guard{};
 
+    // The zygote returns here only in the children it forks, as the client it assigned
+    if (zygote_mode) {
+        nutc::zygote::preload(ZYGOTE_PRELOAD_MODULES);
+        std::optional<nutc::zygote::Assignment> assignment = nutc::zygote::serve();
+        if (!assignment.has_value())
+            return 0;
+        uids = {assignment->uid};
+        use_shm = assignment->use_shm;
+    }
+
     // Start logging and print build info
-    nutc::logging::init(verbosity, uid);
+    nutc::logging::init(verbosity, uids.front());
     log_build_info();
-    log_i(main, "Starting NUTC Client for UID {}", uid);
+    for (const auto& uid : uids)
+        log_i(main, "Starting NUTC Client for UID {}", uid);
 
     // Initialize the RMQ connection to the exchange
-    nutc::rabbitmq::RabbitMQ conn(uid);
+    nutc::rabbitmq::RabbitMQ conn(uids);
 
-    std::optional<std::string> algo;
-    if (development_mode) {
-        algo = nutc::dev_mode::get_algo_from_file(uid);
-    }
-    else {
-        algo = nutc::firebase::get_most_recent_algo(uid);
+    // Co-located clients use shared memory, falling back to the broker
+    if (use_shm && !conn.attachSharedMemory()) {
+        log_w(main, "Failed to attach shared memory rings, using RabbitMQ");
     }
-
-    // Send message to exchange to let it know we successfully initialized
-    bool published_init = conn.publishInit(uid, algo.has_value());
-    if (!published_init) {
-        log_e(main, "Failed to publish init message");
-        return 1;
+    if (conflate)
+        conn.enableConflation();
+
+    std::vector<std::pair<std::string, std::string>> algos;
+    for (const auto& uid : uids) {
+        std::optional<std::string> algo;
+        if (development_mode) {
+            algo = nutc::dev_mode::get_algo_from_file(uid);
+        }
+        else {
+            algo = nutc::firebase::get_most_recent_algo(uid);
+        }
+
+        // Native code runs unsandboxed in this process, so it has to be asked for
+        if (algo.has_value() && nutc::native::is_shared_object(algo.value())
+            && !native) {
+            log_e(main, "Algo for {} is a shared object, but --native isn't set", uid);
+            algo.reset();
+        }
+
+        // Send message to exchange to let it know we successfully initialized
+        bool published_init = conn.publishInit(uid, algo.has_value());
+        if (!published_init) {
+            log_e(main, "Failed to publish init message");
+            return 1;
+        }
+        if (algo.has_value())
+            algos.emplace_back(uid, std::move(algo.value()));
     }
-    if (!algo.has_value()) {
+    if (algos.empty()) {
         return 0;
     }
     conn.waitForStartTime();
 
-    // Initialize the algorithm. For now, only designed for py
-    nutc::pywrapper::create_api_module(conn.getMarketFunc(uid));
-    nutc::pywrapper::run_code_init(algo.value());
+    // Initialize the algorithms: shared objects are native strategies, anything else
+    // is Python
+    auto publish_market_order = conn.getMarketFunc();
+    auto get_orderbook = conn.getBookFunc();
+    nutc::pywrapper::create_api_module(
+        publish_market_order, get_orderbook, conn.getConflatedFunc()
+    );
+    for (const auto& [uid, algo] : algos) {
+        if (nutc::native::is_shared_object(algo)) {
+            auto place_order = [publish_market_order, client_uid = uid](
+                                   nutc::messages::SIDE side, const std::string& ticker,
+                                   float quantity, float price
+                               ) {
+                std::string side_name =
+                    side == nutc::messages::SIDE::BUY ? "BUY" : "SELL";
+                return publish_market_order(
+                    client_uid, side_name, ticker, quantity, price
+                );
+            };
+            auto get_book = [get_orderbook, client_uid = uid](const std::string& ticker) {
+                return get_orderbook(client_uid, ticker);
+            };
+            auto strategy =
+                nutc::native::NativeStrategy::load(algo, uid, place_order, get_book);
+            if (strategy.has_value())
+                conn.addStrategy(std::move(strategy.value()));
+            continue;
+        }
+
+        auto strategy = nutc::pywrapper::run_code_init(algo, uid);
+        if (strategy.has_value())
+            conn.addStrategy(std::move(strategy.value()));
+    }
 
     // Main event loop
     conn.handleIncomingMessages();
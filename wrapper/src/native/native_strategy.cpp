@@ -0,0 +1,224 @@
+#include "native_strategy.hpp"
+
+#include "logging.hpp"
+
+#include <dlfcn.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <algorithm>
+#include <span>
+#include <utility>
+
+namespace nutc {
+namespace native {
+
+namespace {
+nutc_side
+to_abi(messages::SIDE side)
+{
+    return side == messages::SIDE::BUY ? NUTC_SIDE_BUY : NUTC_SIDE_SELL;
+}
+
+// Looks up one of the functions declared in nutc_strategy.h, typed as declared
+#define NUTC_RESOLVE(library, function)                                                \
+    reinterpret_cast<decltype(&function)>(dlsym(library, #function))
+
+// dlopen needs a path; the object only exists in memory. On success fd is the memfd,
+// which stays open as long as the library is loaded
+void*
+open_in_memory(const std::string& shared_object, const std::string& uid, int& fd)
+{
+    std::string name = "nutc_strategy_" + uid;
+    fd = memfd_create(name.c_str(), MFD_CLOEXEC);
+    if (fd < 0) {
+        log_e(native, "Failed to create memfd: {}", std::strerror(errno));
+        return nullptr;
+    }
+
+    size_t written = 0;
+    while (written < shared_object.size()) {
+        ssize_t res = write(
+            fd, shared_object.data() + written, shared_object.size() - written
+        );
+        if (res < 0) {
+            log_e(native, "Failed to write strategy: {}", std::strerror(errno));
+            close(std::exchange(fd, -1));
+            return nullptr;
+        }
+        written += static_cast<size_t>(res);
+    }
+
+    std::string path = "/proc/self/fd/" + std::to_string(fd);
+    void* library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (library == nullptr) {
+        log_e(native, "Failed to load strategy for {}: {}", uid, dlerror());
+        close(std::exchange(fd, -1));
+    }
+    return library;
+}
+} // namespace
+
+bool
+is_shared_object(const std::string& algo)
+{
+    return algo.size() >= 4 && algo.compare(0, 4, "\x7f" "ELF") == 0;
+}
+
+std::optional<NativeStrategy>
+NativeStrategy::load(
+    const std::string& shared_object,
+    const std::string& uid,
+    PlaceOrder place_order,
+    GetBook get_book
+)
+{
+    NativeStrategy loaded;
+    loaded.library = open_in_memory(shared_object, uid, loaded.memfd);
+    if (loaded.library == nullptr)
+        return std::nullopt;
+
+    void* library = loaded.library;
+    auto abi_version = NUTC_RESOLVE(library, nutc_strategy_abi_version);
+    auto init = NUTC_RESOLVE(library, nutc_strategy_init);
+    loaded.orderbook_update = NUTC_RESOLVE(library, nutc_strategy_on_orderbook_update);
+    loaded.trade_update = NUTC_RESOLVE(library, nutc_strategy_on_trade_update);
+    loaded.account_update = NUTC_RESOLVE(library, nutc_strategy_on_account_update);
+    loaded.destroy = NUTC_RESOLVE(library, nutc_strategy_destroy);
+    loaded.level_update = NUTC_RESOLVE(library, nutc_strategy_on_level_update);
+
+    bool has_orderbook_update =
+        loaded.orderbook_update != nullptr || loaded.level_update != nullptr;
+    if (abi_version == nullptr || init == nullptr || !has_orderbook_update
+        || loaded.trade_update == nullptr || loaded.account_update == nullptr) {
+        log_e(native, "Strategy for {} is missing a required function", uid);
+        return std::nullopt;
+    }
+    // Older strategies only use a prefix of what this version provides
+    uint32_t version = abi_version();
+    if (version == 0 || version > NUTC_STRATEGY_ABI_VERSION) {
+        log_e(
+            native, "Strategy for {} was built for ABI version {}, expected at most {}",
+            uid, version, NUTC_STRATEGY_ABI_VERSION
+        );
+        return std::nullopt;
+    }
+
+    loaded.host = std::make_unique<Host>(
+        Host{uid, std::move(place_order), std::move(get_book), {}}
+    );
+    loaded.host->abi = nutc_host{
+        NUTC_STRATEGY_ABI_VERSION, loaded.host->uid.c_str(), loaded.host.get(),
+        &NativeStrategy::place_order_trampoline, &NativeStrategy::get_levels_trampoline
+    };
+    loaded.strategy = init(&loaded.host->abi);
+    if (loaded.strategy == nullptr) {
+        log_e(native, "Strategy for {} failed to initialize", uid);
+        return std::nullopt;
+    }
+    log_i(native, "Loaded native strategy for {}", uid);
+    return loaded;
+}
+
+NativeStrategy::NativeStrategy(NativeStrategy&& other) noexcept :
+    memfd(std::exchange(other.memfd, -1)), library(std::exchange(other.library, nullptr)),
+    strategy(std::exchange(other.strategy, nullptr)), host(std::move(other.host)),
+    orderbook_update(other.orderbook_update), trade_update(other.trade_update),
+    account_update(other.account_update), destroy(other.destroy),
+    level_update(other.level_update)
+{}
+
+NativeStrategy&
+NativeStrategy::operator=(NativeStrategy&& other) noexcept
+{
+    std::swap(memfd, other.memfd);
+    std::swap(library, other.library);
+    std::swap(strategy, other.strategy);
+    std::swap(host, other.host);
+    std::swap(orderbook_update, other.orderbook_update);
+    std::swap(trade_update, other.trade_update);
+    std::swap(account_update, other.account_update);
+    std::swap(destroy, other.destroy);
+    std::swap(level_update, other.level_update);
+    return *this;
+}
+
+NativeStrategy::~NativeStrategy()
+{
+    if (strategy != nullptr && destroy != nullptr)
+        destroy(strategy);
+    if (library != nullptr)
+        dlclose(library);
+    if (memfd >= 0)
+        close(memfd);
+}
+
+void
+NativeStrategy::on_orderbook_update(const messages::ObUpdate& update)
+{
+    if (level_update != nullptr) {
+        level_update(
+            strategy, update.security.c_str(), to_abi(update.side), update.price,
+            update.quantity, update.level_quantity
+        );
+        return;
+    }
+    orderbook_update(
+        strategy, update.security.c_str(), to_abi(update.side), update.price,
+        update.quantity
+    );
+}
+
+void
+NativeStrategy::on_trade_update(const messages::Match& match)
+{
+    trade_update(
+        strategy, match.ticker.c_str(), to_abi(match.side), match.price, match.quantity
+    );
+}
+
+void
+NativeStrategy::on_account_update(const messages::AccountUpdate& update)
+{
+    account_update(
+        strategy, update.ticker.c_str(), to_abi(update.side), update.price,
+        update.quantity, update.capital_remaining
+    );
+}
+
+uint64_t
+NativeStrategy::place_order_trampoline(
+    void* host_context, nutc_side side, const char* ticker, float quantity, float price
+)
+{
+    auto* host = static_cast<Host*>(host_context);
+    messages::SIDE order_side =
+        side == NUTC_SIDE_BUY ? messages::SIDE::BUY : messages::SIDE::SELL;
+    return host->place_order(order_side, ticker, quantity, price);
+}
+
+uint32_t
+NativeStrategy::get_levels_trampoline(
+    void* host_context, const char* ticker, nutc_side side, nutc_level* levels,
+    uint32_t max_levels
+)
+{
+    auto* host = static_cast<Host*>(host_context);
+    book::MirroredBook* book = host->get_book(ticker);
+    if (book == nullptr)
+        return 0;
+    std::span<const book::Level> held =
+        side == NUTC_SIDE_BUY ? book->bids() : book->asks();
+    size_t count = std::min<size_t>(held.size(), max_levels);
+    for (size_t i = 0; i < count; i++)
+        levels[i] = nutc_level{held[i].price, held[i].quantity};
+    return static_cast<uint32_t>(count);
+}
+
+#undef NUTC_RESOLVE
+
+} // namespace native
+} // namespace nutc
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "book/mirrored_book.hpp"
+#include "native/nutc_strategy.h"
+#include "util/messages.hpp"
+
+#include <cstdint>
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace nutc {
+/**
+ * @brief Strategies compiled to shared objects against nutc_strategy.h
+ */
+namespace native {
+
+/**
+ * @brief Places an order for the strategy's client, returning its id (0 if dropped)
+ */
+using PlaceOrder = std::function<uint64_t(
+    messages::SIDE side, const std::string& ticker, float quantity, float price
+)>;
+
+/**
+ * @brief Returns the strategy's client's mirrored book for a ticker
+ */
+using GetBook = std::function<book::MirroredBook*(const std::string& ticker)>;
+
+/**
+ * @brief Whether an algo is a shared object (an ELF file) rather than Python source
+ */
+bool is_shared_object(const std::string& algo);
+
+/**
+ * @class NativeStrategy
+ * @brief A loaded native strategy, called directly on the event loop thread
+ *
+ * Owns the library, the memfd it was loaded from and the strategy created from it: the
+ * strategy is destroyed and the library unloaded along with this object.
+ */
+class NativeStrategy {
+public:
+    /**
+     * @brief Loads a strategy from the contents of a shared object and creates it
+     *
+     * @param shared_object The shared object's bytes, as fetched for the client
+     * @param uid The client the strategy trades as
+     * @param place_order Called when the strategy places an order
+     * @param get_book Called when the strategy reads its mirrored book
+     * @returns nullopt if the object can't be loaded, lacks a required function, was
+     * built against a newer ABI version or failed to initialize
+     */
+    static std::optional<NativeStrategy> load(
+        const std::string& shared_object,
+        const std::string& uid,
+        PlaceOrder place_order,
+        GetBook get_book
+    );
+
+    NativeStrategy(const NativeStrategy&) = delete;
+    NativeStrategy& operator=(const NativeStrategy&) = delete;
+    NativeStrategy(NativeStrategy&& other) noexcept;
+    NativeStrategy& operator=(NativeStrategy&& other) noexcept;
+    ~NativeStrategy();
+
+    [[nodiscard]] const std::string&
+    get_uid() const
+    {
+        return host->uid;
+    }
+
+    void on_orderbook_update(const messages::ObUpdate& update);
+    void on_trade_update(const messages::Match& match);
+    void on_account_update(const messages::AccountUpdate& update);
+
+private:
+    NativeStrategy() = default;
+
+    // Kept on the heap, the strategy holds on to its address
+    struct Host {
+        std::string uid;
+        PlaceOrder place_order;
+        GetBook get_book;
+        nutc_host abi;
+    };
+
+    static uint64_t place_order_trampoline(
+        void* host_context, nutc_side side, const char* ticker, float quantity,
+        float price
+    );
+    static uint32_t get_levels_trampoline(
+        void* host_context, const char* ticker, nutc_side side, nutc_level* levels,
+        uint32_t max_levels
+    );
+
+    // Kept open while the library is loaded, dlopen found it through this
+    int memfd = -1;
+    void* library = nullptr;
+    void* strategy = nullptr;
+    std::unique_ptr<Host> host;
+
+    decltype(&nutc_strategy_on_orderbook_update) orderbook_update = nullptr;
+    decltype(&nutc_strategy_on_trade_update) trade_update = nullptr;
+    decltype(&nutc_strategy_on_account_update) account_update = nullptr;
+    // Optional
+    decltype(&nutc_strategy_destroy) destroy = nullptr;
+    decltype(&nutc_strategy_on_level_update) level_update = nullptr;
+};
+
+} // namespace native
+} // namespace nutc
@@ -0,0 +1,122 @@
+#pragma once
+
+/**
+ * @file nutc_strategy.h
+ * @brief C ABI for native strategies, loaded by the wrapper from a shared object
+ *
+ * A native strategy is a shared object exporting the nutc_strategy_* functions below
+ * with C linkage. The wrapper calls them on its event loop thread, with the same
+ * messages a Python strategy's callbacks receive, and never concurrently. Strings are
+ * only valid for the duration of a call.
+ *
+ * Only ever extended by appending, and every extension bumps
+ * NUTC_STRATEGY_ABI_VERSION. The wrapper loads strategies built against any version up
+ * to its own; something added in version N is only there when nutc_host's abi_version
+ * is at least N.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NUTC_STRATEGY_ABI_VERSION 2
+
+typedef enum { NUTC_SIDE_BUY = 0, NUTC_SIDE_SELL = 1 } nutc_side;
+
+/**
+ * @brief Places an order for the strategy's client
+ * @returns The order's id, or 0 if it was dropped (rate limited or too many queued)
+ */
+typedef uint64_t (*nutc_place_order_fn)(
+    void* host_context, nutc_side side, const char* ticker, float quantity, float price
+);
+
+/**
+ * @brief One price level of a mirrored book
+ */
+typedef struct {
+    float price;
+    float quantity;
+} nutc_level;
+
+/**
+ * @brief Copies up to max_levels levels of one side of the client's mirrored book for
+ * a ticker, best first
+ * @returns How many levels were copied
+ * @since ABI version 2
+ */
+typedef uint32_t (*nutc_get_levels_fn)(
+    void* host_context, const char* ticker, nutc_side side, nutc_level* levels,
+    uint32_t max_levels
+);
+
+/**
+ * @brief What the wrapper hands a strategy when it is created; valid until it is
+ * destroyed
+ */
+typedef struct {
+    // The wrapper's NUTC_STRATEGY_ABI_VERSION
+    uint32_t abi_version;
+    // The client uid the strategy trades as
+    const char* uid;
+    // Passed back as the first argument of place_order and get_levels
+    void* host_context;
+    nutc_place_order_fn place_order;
+    // Since ABI version 2
+    nutc_get_levels_fn get_levels;
+} nutc_host;
+
+/**
+ * Exported by the strategy. Must return NUTC_STRATEGY_ABI_VERSION as compiled in.
+ */
+uint32_t nutc_strategy_abi_version(void);
+
+/**
+ * Exported by the strategy. Creates it, returning a pointer passed back to every
+ * other call, or NULL on failure.
+ */
+void* nutc_strategy_init(const nutc_host* host);
+
+/**
+ * quantity is what the order that changed now has resting. Required unless the
+ * strategy exports nutc_strategy_on_level_update.
+ */
+void nutc_strategy_on_orderbook_update(
+    void* strategy, const char* ticker, nutc_side side, float price, float quantity
+);
+void nutc_strategy_on_trade_update(
+    void* strategy, const char* ticker, nutc_side side, float price, float quantity
+);
+void nutc_strategy_on_account_update(
+    void* strategy,
+    const char* ticker,
+    nutc_side side,
+    float price,
+    float quantity,
+    float capital_remaining
+);
+
+/**
+ * Optional. Called once the wrapper is done with the strategy.
+ */
+void nutc_strategy_destroy(void* strategy);
+
+/**
+ * Optional, since ABI version 2. Called in place of nutc_strategy_on_orderbook_update,
+ * with level_quantity, the total now resting at price. The mirrored book already
+ * reflects the update.
+ */
+void nutc_strategy_on_level_update(
+    void* strategy,
+    const char* ticker,
+    nutc_side side,
+    float price,
+    float quantity,
+    float level_quantity
+);
+
+#ifdef __cplusplus
+}
+#endif
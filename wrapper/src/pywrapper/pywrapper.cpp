@@ -1,53 +1,310 @@
 #include "pywrapper.hpp"
 
+#include <pybind11/numpy.h>
+
+#include <span>
+#include <unordered_map>
+
 namespace nutc {
 namespace pywrapper {
 
+namespace {
+// Set once by create_api_module; strategies only reach them through closures bound
+// to their own uid
+struct Api {
+    std::function<uint64_t(
+        const std::string&, const std::string&, const std::string&, float, float
+    )>
+        publish_market_order;
+    std::function<book::MirroredBook*(const std::string&, const std::string&)>
+        get_orderbook;
+    std::function<uint64_t(const std::string&)> conflated_updates;
+};
+
+Api api;
+
+// One side of a book, read as it is when used: len() and each buffer taken from it
+// cover the levels held at that moment. Only valid as long as the book
+struct LevelView {
+    const book::MirroredBook* book;
+    messages::SIDE side;
+
+    [[nodiscard]] std::span<const book::Level>
+    levels() const
+    {
+        return side == messages::SIDE::BUY ? book->bids() : book->asks();
+    }
+};
+
+py::object
+level_tuple(const std::optional<book::Level>& level)
+{
+    if (!level.has_value())
+        return py::none();
+    return py::make_tuple(level->price, level->quantity);
+}
+
+// Never freed: they would otherwise be released after the interpreter is finalized
+const py::str&
+side_str(messages::SIDE side)
+{
+    static const auto* buy = new py::str("BUY");
+    static const auto* sell = new py::str("SELL");
+    return side == messages::SIDE::BUY ? *buy : *sell;
+}
+
+const py::str&
+ticker_str(const std::string& ticker)
+{
+    static auto* tickers = new std::unordered_map<std::string, py::str>();
+    auto found = tickers->find(ticker);
+    if (found == tickers->end())
+        found = tickers->emplace(ticker, py::str(ticker)).first;
+    return found->second;
+}
+
+void
+add_to_columns(
+    Batch::Columns& columns,
+    const std::string& ticker,
+    messages::SIDE side,
+    float price,
+    float quantity
+)
+{
+    columns.tickers.push_back(ticker);
+    columns.sides.push_back(side);
+    columns.prices.push_back(price);
+    columns.quantities.push_back(quantity);
+}
+
+py::array_t<float>
+to_array(const std::vector<float>& column)
+{
+    return py::array_t<float>(static_cast<py::ssize_t>(column.size()), column.data());
+}
+
+py::dict
+to_dict(const Batch::Columns& columns)
+{
+    py::list tickers;
+    py::list sides;
+    for (size_t i = 0; i < columns.tickers.size(); i++) {
+        tickers.append(ticker_str(columns.tickers[i]));
+        sides.append(side_str(columns.sides[i]));
+    }
+
+    py::dict dict;
+    dict["ticker"] = tickers;
+    dict["side"] = sides;
+    dict["price"] = to_array(columns.prices);
+    dict["quantity"] = to_array(columns.quantities);
+    return dict;
+}
+
+void
+clear_columns(Batch::Columns& columns)
+{
+    columns.tickers.clear();
+    columns.sides.clear();
+    columns.prices.clear();
+    columns.quantities.clear();
+}
+} // namespace
+
 void
 create_api_module(
-    std::function<bool(const std::string&, const std::string&, float, float)>
-        publish_market_order
+    std::function<uint64_t(
+        const std::string&, const std::string&, const std::string&, float, float
+    )>
+        publish_market_order,
+    std::function<book::MirroredBook*(const std::string&, const std::string&)>
+        get_orderbook,
+    std::function<uint64_t(const std::string&)> conflated_updates
 )
 {
+    api = {
+        std::move(publish_market_order), std::move(get_orderbook),
+        std::move(conflated_updates)
+    };
     py::module m = py::module::create_extension_module(
         "nutc_api", "NUTC Exchange API", new py::module::module_def
     );
-    m.def("publish_market_order", publish_market_order);
+
+    py::class_<LevelView>(m, "Levels", py::buffer_protocol())
+        .def_buffer([](LevelView& view) {
+            std::span<const book::Level> levels = view.levels();
+            return py::buffer_info(
+                const_cast<book::Level*>(levels.data()), sizeof(float),
+                py::format_descriptor<float>::format(), 2,
+                {static_cast<py::ssize_t>(levels.size()), py::ssize_t{2}},
+                {static_cast<py::ssize_t>(sizeof(book::Level)),
+                 static_cast<py::ssize_t>(sizeof(float))},
+                true
+            );
+        })
+        .def("__len__", [](const LevelView& view) { return view.levels().size(); });
+
+    py::class_<book::MirroredBook>(m, "OrderBook")
+        .def(
+            "best_bid",
+            [](const book::MirroredBook& book) { return level_tuple(book.best_bid()); }
+        )
+        .def(
+            "best_ask",
+            [](const book::MirroredBook& book) { return level_tuple(book.best_ask()); }
+        )
+        .def_property_readonly(
+            "bids",
+            [](const book::MirroredBook& book) {
+                return LevelView{&book, messages::SIDE::BUY};
+            }
+        )
+        .def_property_readonly(
+            "asks",
+            [](const book::MirroredBook& book) {
+                return LevelView{&book, messages::SIDE::SELL};
+            }
+        );
 
     py::module_ sys = py::module_::import("sys");
     py::dict sys_modules = sys.attr("modules").cast<py::dict>();
     sys_modules["nutc_api"] = m;
+}
+
+std::optional<Strategy>
+run_code_init(const std::string& py_code, const std::string& uid)
+{
+    py::dict scope;
+    scope["__builtins__"] = py::module_::import("builtins");
+    scope["__name__"] = "__main__";
+    scope["nutc_api"] = py::module_::import("nutc_api");
+
+    try {
+        py::exec(py_code, scope);
+
+        // Bound to this strategy's uid in C++, so no strategy can act as another. Bound
+        // after the algo runs, so the template's stubs can't shadow them
+        scope["place_market_order"] = py::cpp_function(
+            [uid](
+                const std::string& side,
+                const std::string& ticker,
+                float quantity,
+                float price
+            ) {
+                return api.publish_market_order(uid, side, ticker, quantity, price);
+            },
+            py::arg("side"), py::arg("ticker"), py::arg("quantity"), py::arg("price")
+        );
+        // Books are owned by the wrapper and outlive the interpreter's use of them
+        scope["get_orderbook"] = py::cpp_function(
+            [uid](const std::string& ticker) { return api.get_orderbook(uid, ticker); },
+            py::arg("ticker"), py::return_value_policy::reference
+        );
+        scope["conflated_updates"] =
+            py::cpp_function([uid] { return api.conflated_updates(uid); });
+
+        py::exec("strat = Strategy()", scope);
 
-    py::exec(R"(import nutc_api)");
+        py::object strat = scope["strat"];
+        return Strategy{
+            uid,
+            scope,
+            strat.attr("on_orderbook_update"),
+            strat.attr("on_trade_update"),
+            strat.attr("on_account_update"),
+            py::getattr(strat, "on_batch", py::none()),
+            py::getattr(strat, "on_order_ack", py::none()),
+            py::getattr(strat, "on_tick", py::none()),
+            {}
+        };
+    } catch (const py::error_already_set& err) {
+        log_e(py_runtime, "Failed to initialize algorithm for {}: {}", uid, err.what());
+        return std::nullopt;
+    }
 }
 
-const py::object
-get_ob_update_function()
+void
+deliver(Strategy& strategy, const messages::ObUpdate& update)
 {
-    return py::globals()["strat"].attr("on_orderbook_update");
+    if (!strategy.on_batch.is_none()) {
+        add_to_columns(
+            strategy.batch.orderbook_updates, update.security, update.side, update.price,
+            update.quantity
+        );
+        return;
+    }
+    strategy.on_orderbook_update(
+        ticker_str(update.security), side_str(update.side), update.price,
+        update.quantity
+    );
 }
 
-const py::object
-get_trade_update_function()
+void
+deliver(Strategy& strategy, const messages::Match& match)
 {
-    return py::globals()["strat"].attr("on_trade_update");
+    if (!strategy.on_batch.is_none()) {
+        add_to_columns(
+            strategy.batch.trades, match.ticker, match.side, match.price, match.quantity
+        );
+        return;
+    }
+    strategy.on_trade_update(
+        ticker_str(match.ticker), side_str(match.side), match.price, match.quantity
+    );
 }
 
-const py::object
-get_account_update_function()
+void
+deliver(Strategy& strategy, const messages::AccountUpdate& update)
+{
+    if (!strategy.on_batch.is_none()) {
+        add_to_columns(
+            strategy.batch.account_updates, update.ticker, update.side, update.price,
+            update.quantity
+        );
+        strategy.batch.capital_remaining.push_back(update.capital_remaining);
+        return;
+    }
+    strategy.on_account_update(
+        ticker_str(update.ticker), side_str(update.side), update.price, update.quantity,
+        update.capital_remaining
+    );
+}
+
+void
+flush_batch(Strategy& strategy)
+{
+    Batch& batch = strategy.batch;
+    if (batch.orderbook_updates.prices.empty() && batch.trades.prices.empty()
+        && batch.account_updates.prices.empty()) {
+        return;
+    }
+
+    py::dict account_updates = to_dict(batch.account_updates);
+    account_updates["capital_remaining"] = to_array(batch.capital_remaining);
+    py::dict orderbook_updates = to_dict(batch.orderbook_updates);
+    py::dict trades = to_dict(batch.trades);
+
+    // Cleared first, so a callback that raises doesn't get the same batch again
+    clear_columns(batch.orderbook_updates);
+    clear_columns(batch.trades);
+    clear_columns(batch.account_updates);
+    batch.capital_remaining.clear();
+    strategy.on_batch(orderbook_updates, trades, account_updates);
+}
+
+void
+acknowledge(Strategy& strategy, uint64_t order_id, bool sent)
 {
-    return py::globals()["strat"].attr("on_account_update");
+    if (!strategy.on_order_ack.is_none())
+        strategy.on_order_ack(order_id, sent);
 }
 
 void
-run_code_init(const std::string& py_code)
+tick(Strategy& strategy)
 {
-    py::exec(py_code);
-    py::exec(R"(
-        def place_market_order(side, ticker, quantity, price):
-            nutc_api.publish_market_order(side, ticker, quantity, price)
-    )");
-    py::exec("strat = Strategy()");
+    if (!strategy.on_tick.is_none())
+        strategy.on_tick();
 }
 
 } // namespace pywrapper
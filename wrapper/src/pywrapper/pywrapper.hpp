@@ -1,11 +1,18 @@
 #pragma once
 
+#include "book/mirrored_book.hpp"
 #include "logging.hpp"
 #include "util/messages.hpp"
 
 #include <pybind11/embed.h>
 #include <pybind11/pybind11.h>
 
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
 namespace py = pybind11;
 
 namespace nutc {
@@ -16,45 +23,123 @@ namespace nutc {
  * Contains functions to create the Python API module and run the client algorithm
  */
 namespace pywrapper {
-/**
- * @brief Gets the callback function for orderbook orderbook_update
- *
- * Designed to be triggered by the rabbitmq class when an orderbook update is received
- */
-const py::object get_ob_update_function();
 
 /**
- * @brief Gets the callback function for trade updates
- *
- * Designed to be triggered by the rabbitmq class when a trade update is received
+ * @brief Messages held back for a strategy's on_batch, one column per field
  */
-const py::object get_trade_update_function();
+struct Batch {
+    struct Columns {
+        std::vector<std::string> tickers;
+        std::vector<messages::SIDE> sides;
+        std::vector<float> prices;
+        std::vector<float> quantities;
+    };
+
+    Columns orderbook_updates;
+    Columns trades;
+    Columns account_updates;
+    // One per account update
+    std::vector<float> capital_remaining;
+};
 
 /**
- * @brief Gets the callback function for account updates
+ * @brief A client algorithm, run in a module namespace of its own
  *
- * Designed to be triggered by the rabbitmq class when an account update is received
+ * Strategies hosted by one process share the interpreter, and so sys.modules and
+ * anything imported modules keep globally, but not their globals. The callbacks are
+ * looked up once, when the strategy is created.
+ *
+ * A strategy that defines on_batch(orderbook_updates, trades, account_updates) is
+ * called once per batch of messages instead of once per message. Each argument is a
+ * dict of columns: "ticker" and "side" are lists of str, "price" and "quantity" are
+ * float32 numpy arrays, and account updates also have "capital_remaining". Messages
+ * of each kind keep their order, and the mirrored books already reflect the whole
+ * batch.
+ *
+ * place_market_order returns as soon as the order is queued, with an id for it (0 if
+ * the order was dropped). A strategy that defines on_order_ack(order_id, sent) is told
+ * once the order has gone out to the exchange, or failed to.
+ *
+ * A strategy that defines on_tick() is also called every STRATEGY_TICK_MS, whether or
+ * not anything arrived.
  */
-const py::object get_account_update_function();
+struct Strategy {
+    std::string uid;
+    // The algorithm's globals
+    py::dict scope;
+    py::object on_orderbook_update;
+    py::object on_trade_update;
+    py::object on_account_update;
+    // None unless the algorithm defines them
+    py::object on_batch;
+    py::object on_order_ack;
+    py::object on_tick;
+    Batch batch;
+};
 
 /**
  * @brief Creates the Python API module
  *
- * Creates the Python API module and adds the publish_market_order function to it
- * This allows the client algorithm to place orders with the global function
- * "place_market_order" which is a callback to the rabbitmq class
+ * Creates the Python API module and keeps the callbacks it is given. Every strategy's
+ * globals get "place_market_order", "get_orderbook" and "conflated_updates"
+ * functions bound to the strategy's uid in C++, so orders are attributed to the
+ * strategy that placed them and no strategy can act as another
  *
- * @param publish_market_order The callback function to place market orders
+ * Also exposes each client's mirrored order books: "get_orderbook(ticker)" returns an
+ * OrderBook with best_bid() and best_ask() (a (price, quantity) tuple, or None) and
+ * read-only bids and asks views. The views support the buffer protocol, so
+ * numpy.asarray(book.bids) is an (n, 2) float32 array over the book itself, best
+ * level first. Such an array sees quantities change in place, but keeps the number
+ * of rows the book had when it was made, and rows may shift as levels come and go;
+ * take a fresh one after the book changes, or copy it with numpy.array.
+ *
+ * @param publish_market_order The callback to place market orders, taking the uid,
+ * side, ticker, quantity and price and returning the order's id
+ * @param get_orderbook Returns a client's book for a ticker, taking the uid and ticker
+ * @param conflated_updates Returns how many of a client's orderbook updates were
+ * conflated away, taking the uid; strategies call it as "conflated_updates()"
  */
 void create_api_module(
-    std::function<
-        bool(const std::string&, const std::string&, float, float)>
-        publish_market_order
+    std::function<uint64_t(
+        const std::string&, const std::string&, const std::string&, float, float
+    )>
+        publish_market_order,
+    std::function<book::MirroredBook*(const std::string&, const std::string&)>
+        get_orderbook,
+    std::function<uint64_t(const std::string&)> conflated_updates
 );
 
 /**
- * @brief Runs the initialize() function in the client algorithm
+ * @brief Runs the client algorithm in a fresh namespace and constructs its Strategy
+ *
+ * @param uid The client the algorithm trades as
+ * @returns The strategy, or nullopt if the code or its Strategy() raised
+ */
+std::optional<Strategy> run_code_init(const std::string& py_code, const std::string& uid);
+
+/**
+ * @brief Hands a message to the strategy: adds it to the batch if the strategy has
+ * on_batch, otherwise calls the matching callback right away
+ *
+ * Tickers and sides are passed as str objects created once per value, not per call.
+ */
+void deliver(Strategy& strategy, const messages::ObUpdate& update);
+void deliver(Strategy& strategy, const messages::Match& match);
+void deliver(Strategy& strategy, const messages::AccountUpdate& update);
+
+/**
+ * @brief Calls on_batch with every message batched since the last flush, if any
+ */
+void flush_batch(Strategy& strategy);
+
+/**
+ * @brief Calls on_order_ack, if the strategy has it
+ */
+void acknowledge(Strategy& strategy, uint64_t order_id, bool sent);
+
+/**
+ * @brief Calls on_tick, if the strategy has it
  */
-void run_code_init(const std::string& py_code);
+void tick(Strategy& strategy);
 } // namespace pywrapper
 } // namespace nutc
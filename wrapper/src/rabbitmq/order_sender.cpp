@@ -0,0 +1,82 @@
+#include "order_sender.hpp"
+
+#include "logging.hpp"
+
+namespace nutc {
+namespace rabbitmq {
+
+OrderSender::~OrderSender()
+{
+    if (!running.load())
+        return;
+    running = false;
+    wakeups.fetch_add(1, std::memory_order_release);
+    wakeups.notify_one();
+    thread.join();
+
+    amqp_channel_close(conn, 1, AMQP_REPLY_SUCCESS);
+    amqp_connection_close(conn, AMQP_REPLY_SUCCESS);
+    amqp_destroy_connection(conn);
+}
+
+void
+OrderSender::start(amqp_connection_state_t connection)
+{
+    conn = connection;
+    running = true;
+    thread = std::thread(&OrderSender::run, this);
+}
+
+bool
+OrderSender::enqueue(Order order)
+{
+    if (!running.load(std::memory_order_relaxed) || in_flight == ORDER_QUEUE_SIZE)
+        return false;
+    // Can't fail: the queue never holds more than in_flight
+    orders.try_push(std::move(order));
+    in_flight++;
+    wakeups.fetch_add(1, std::memory_order_release);
+    wakeups.notify_one();
+    return true;
+}
+
+std::optional<OrderSender::Ack>
+OrderSender::pop_ack()
+{
+    std::optional<Ack> ack = acks.try_pop();
+    if (ack.has_value())
+        in_flight--;
+    return ack;
+}
+
+void
+OrderSender::run()
+{
+    while (true) {
+        uint64_t seen = wakeups.load(std::memory_order_acquire);
+        bool stopping = !running.load(std::memory_order_acquire);
+
+        // Everything queued so far goes out back to back
+        while (std::optional<Order> order = orders.try_pop()) {
+            int status = amqp_basic_publish(
+                conn, 1, amqp_cstring_bytes(""), amqp_cstring_bytes("market_order"), 0, 0,
+                nullptr, amqp_cstring_bytes(order->message.c_str())
+            );
+            bool sent = status == AMQP_STATUS_OK;
+            if (!sent) {
+                log_e(
+                    rabbitmq, "Failed to publish order {}: {}", order->order_id,
+                    amqp_error_string2(status)
+                );
+            }
+            acks.try_push(Ack{std::move(order->client_uid), order->order_id, sent});
+        }
+
+        if (stopping)
+            return;
+        wakeups.wait(seen, std::memory_order_acquire);
+    }
+}
+
+} // namespace rabbitmq
+} // namespace nutc
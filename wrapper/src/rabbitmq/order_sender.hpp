@@ -0,0 +1,92 @@
+#pragma once
+
+#include "config.h"
+#include "util/spsc_queue.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include <rabbitmq-c/amqp.h>
+
+namespace nutc {
+namespace rabbitmq {
+
+/**
+ * @class OrderSender
+ * @brief Publishes orders to the exchange's market_order queue from an I/O thread
+ *
+ * The algo's thread only queues an order and returns; the I/O thread publishes
+ * everything queued since it last woke back to back, over a connection of its own
+ * (rabbitmq-c connections can't be shared between threads), then acknowledges each
+ * order. Acknowledgements are read back on the algo's thread.
+ *
+ * Orders are queued and acknowledgements read from one thread only.
+ */
+class OrderSender {
+public:
+    struct Order {
+        std::string client_uid;
+        uint64_t order_id;
+        std::string message;
+    };
+
+    struct Ack {
+        std::string client_uid;
+        uint64_t order_id;
+        // Whether the order was handed to the broker
+        bool sent;
+    };
+
+    OrderSender() = default;
+    OrderSender(const OrderSender&) = delete;
+    OrderSender& operator=(const OrderSender&) = delete;
+
+    /**
+     * @brief Publishes what is still queued, then closes the connection
+     */
+    ~OrderSender();
+
+    /**
+     * @brief Starts the I/O thread
+     *
+     * @param connection An open connection with channel 1 open; the sender closes it
+     */
+    void start(amqp_connection_state_t connection);
+
+    /**
+     * @returns False if ORDER_QUEUE_SIZE orders are already awaiting acknowledgement
+     */
+    [[nodiscard]] bool enqueue(Order order);
+
+    std::optional<Ack> pop_ack();
+
+    /**
+     * @brief Whether orders were queued that have not been acknowledged yet
+     */
+    [[nodiscard]] bool
+    has_pending() const
+    {
+        return in_flight > 0;
+    }
+
+private:
+    void run();
+
+    amqp_connection_state_t conn = nullptr;
+    util::SpscQueue<Order, ORDER_QUEUE_SIZE> orders;
+    // As large as the order queue, and never holds more than in_flight
+    util::SpscQueue<Ack, ORDER_QUEUE_SIZE> acks;
+    // Only touched by the queueing thread
+    size_t in_flight = 0;
+
+    // Bumped on every enqueue and on stop, the I/O thread waits for it to change
+    std::atomic<uint64_t> wakeups{0};
+    std::atomic<bool> running{false};
+    std::thread thread;
+};
+
+} // namespace rabbitmq
+} // namespace nutc
@@ -2,21 +2,40 @@
 
 #include "logging.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <thread>
+#include <unordered_set>
 
 namespace nutc {
 namespace rabbitmq {
 
+namespace {
+// Strategies hosted together share the event loop; one raising is logged and the
+// rest carry on
+template <typename Callback>
+void
+guard_strategy(const std::string& uid, Callback&& callback)
+{
+    try {
+        callback();
+    } catch (const py::error_already_set& err) {
+        log_e(py_runtime, "Algorithm for {} raised: {}", uid, err.what());
+    }
+}
+} // namespace
+
 bool
 RabbitMQ::connectToRabbitMQ(
+    amqp_connection_state_t& connection,
     const std::string& hostname,
     int port,
     const std::string& username,
     const std::string& password
 )
 {
-    conn = amqp_new_connection();
-    amqp_socket_t* socket = amqp_tcp_socket_new(conn);
+    connection = amqp_new_connection();
+    amqp_socket_t* socket = amqp_tcp_socket_new(connection);
 
     if (!socket) {
         log_e(rabbitmq, "Cannot create TCP socket");
@@ -30,7 +49,7 @@ RabbitMQ::connectToRabbitMQ(
     }
 
     amqp_rpc_reply_t reply = amqp_login(
-        conn,
+        connection,
         "/",
         0,
         131072,
@@ -50,77 +69,376 @@ RabbitMQ::connectToRabbitMQ(
 std::variant<ShutdownMessage, RMQError>
 RabbitMQ::handleIncomingMessages()
 {
+    // Only now can the algos receive them
+    for (auto& client : hosted) {
+        if (client.late_snapshot.has_value()) {
+            applySnapshot(client.late_snapshot.value(), client);
+            client.late_snapshot.reset();
+        }
+    }
+    for (auto& [queue, data] : std::exchange(early_messages, {})) {
+        auto stop = dispatchMessage(data, findHosted(queue));
+        if (stop.has_value())
+            return stop.value();
+    }
+    flushBatches();
+
+    // From here on only the network thread uses the connection
+    network_running = true;
+    network_thread = std::thread(&RabbitMQ::runNetworkThread, this);
+
+    auto tick_interval = std::chrono::milliseconds(STRATEGY_TICK_MS);
+    auto next_tick = std::chrono::steady_clock::now() + tick_interval;
     while (true) {
-        std::variant<
-            StartTime,
-            ShutdownMessage,
-            RMQError,
-            ObUpdate,
-            Match,
-            AccountUpdate>
-            data = consumeMessage();
-        if (std::holds_alternative<ShutdownMessage>(data)) {
-            log_w(
-                rabbitmq,
-                "Received shutdown message: {}",
-                std::get<ShutdownMessage>(data).shutdown_reason
-            );
-            return std::get<ShutdownMessage>(data);
+        bool ring_busy = market_data_ring != nullptr && pollMarketData() > 0;
+
+        // Conflating algos get the whole backlog folded into one pass, so they catch up
+        // to the current book instead of working through it. Only what was queued
+        // when the pass began, so a busy network thread can't hold off acks and ticks
+        size_t pass_limit = conflate ? incoming.size() : DISPATCH_BATCH_MAX;
+        size_t drained = 0;
+        while (drained < pass_limit) {
+            std::optional<Incoming> next = incoming.try_pop();
+            if (!next.has_value())
+                break;
+            drained++;
+            auto stop = dispatchMessage(next->message, findHosted(next->queue));
+            if (stop.has_value())
+                return stop.value();
         }
-        else if (std::holds_alternative<RMQError>(data)) {
-            log_e(
-                rabbitmq,
-                "Failed to consume message: {}",
-                std::get<RMQError>(data).message
-            );
-            return std::get<RMQError>(data);
+        flushBatches();
+        deliverOrderAcks();
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= next_tick) {
+            tickStrategies();
+            next_tick = std::max(next_tick + tick_interval, now);
         }
-        else if (std::holds_alternative<ObUpdate>(data)) {
-            log_i(
-                rabbitmq,
-                "Received order book update: {}",
-                glz::write_json(std::get<ObUpdate>(data))
-            );
-            ObUpdate update = std::get<ObUpdate>(data);
-            std::string side = update.side == messages::SIDE::BUY ? "BUY" : "SELL";
-            nutc::pywrapper::get_ob_update_function()(
-                update.security, side, update.price, update.quantity
-            );
+        if (ring_busy || drained > 0)
+            continue;
+
+        // Idle until the network thread has something, the next tick, the next ring
+        // check or, with orders in flight, the next chance to acknowledge them
+        auto wait =
+            std::chrono::duration_cast<std::chrono::microseconds>(next_tick - now);
+        if (market_data_ring != nullptr)
+            wait = std::min(wait, std::chrono::microseconds(SHM_MARKET_DATA_POLL_US));
+        if (order_sender.has_pending())
+            wait = std::min(wait, std::chrono::microseconds(ORDER_ACK_POLL_US));
+
+        // Lets any threads the algos started run meanwhile
+        py::gil_scoped_release release;
+        std::unique_lock lock(incoming_mutex);
+        incoming_ready.wait_for(lock, wait, [this] { return !incoming.empty(); });
+    }
+}
+
+void
+RabbitMQ::runNetworkThread()
+{
+    std::string queue;
+    while (network_running.load(std::memory_order_relaxed)) {
+        // Bounded, so the thread notices when it should stop
+        timeval timeout{0, NETWORK_POLL_US};
+        std::optional<std::string> buf = consumeMessageAsString(&timeout, &queue);
+        if (!buf.has_value())
+            continue;
+
+        IncomingMessage message = decodeMessage(buf.value());
+        bool last = std::holds_alternative<ShutdownMessage>(message)
+                    || std::holds_alternative<RMQError>(message);
+
+        Incoming next{queue, std::move(message)};
+        while (!incoming.try_push(std::move(next))) {
+            // The algos are a full queue behind; nothing to do but wait for them
+            if (!network_running.load(std::memory_order_relaxed))
+                return;
+            std::this_thread::yield();
         }
-        else if (std::holds_alternative<Match>(data)) {
-            log_i(
-                rabbitmq, "Received match: {}", glz::write_json(std::get<Match>(data))
-            );
-            Match match = std::get<Match>(data);
-            std::string side = match.side == messages::SIDE::BUY ? "BUY" : "SELL";
-            nutc::pywrapper::get_trade_update_function()(
-                match.ticker, side, match.price, match.quantity
-            );
+        {
+            std::lock_guard lock(incoming_mutex);
         }
-        else if (std::holds_alternative<AccountUpdate>(data)) {
-            AccountUpdate update = std::get<AccountUpdate>(data);
-            log_i(
-                rabbitmq,
-                "Received account update with capital remaining: {}",
-                update.capital_remaining
+        incoming_ready.notify_one();
+
+        if (last)
+            return;
+    }
+}
+
+RabbitMQ::Hosted*
+RabbitMQ::findHosted(std::string_view uid)
+{
+    auto client = std::find_if(hosted.begin(), hosted.end(), [uid](const Hosted& h) {
+        return h.uid == uid;
+    });
+    return client == hosted.end() ? nullptr : &*client;
+}
+
+std::optional<std::variant<ShutdownMessage, RMQError>>
+RabbitMQ::dispatchMessage(const IncomingMessage& data, Hosted* target)
+{
+    if (std::holds_alternative<ShutdownMessage>(data)) {
+        log_w(
+            rabbitmq,
+            "Received shutdown message: {}",
+            std::get<ShutdownMessage>(data).shutdown_reason
+        );
+        return std::get<ShutdownMessage>(data);
+    }
+    else if (std::holds_alternative<RMQError>(data)) {
+        log_e(
+            rabbitmq, "Failed to consume message: {}", std::get<RMQError>(data).message
+        );
+        return std::get<RMQError>(data);
+    }
+    else if (std::holds_alternative<BookSnapshot>(data)) {
+        const BookSnapshot& snapshot = std::get<BookSnapshot>(data);
+        log_i(
+            rabbitmq,
+            "Received book snapshot with {} levels at sequence {}",
+            snapshot.levels.size(),
+            snapshot.sequence
+        );
+        // An overrun starves every ring reader, so whichever client asked, the
+        // snapshot is for all of them
+        if (awaiting_snapshot || target == nullptr) {
+            for (auto& client : hosted)
+                applySnapshot(snapshot, client);
+            market_data_cursor = snapshot.sequence;
+            awaiting_snapshot = false;
+        }
+        else {
+            applySnapshot(snapshot, *target);
+        }
+    }
+    else if (std::holds_alternative<OrderRejected>(data)) {
+        const OrderRejected& rejected = std::get<OrderRejected>(data);
+        log_w(
+            rabbitmq,
+            "Exchange rejected order from {} for {}: {}",
+            target == nullptr ? "" : target->uid,
+            rejected.ticker,
+            rejected.reject_reason
+        );
+    }
+    else if (std::holds_alternative<LevelTotals>(data)) {
+        // What this client's own order did to the book; only the mirror hears of it
+        if (target != nullptr) {
+            for (const auto& level : std::get<LevelTotals>(data).level_totals)
+                target->books.apply(level);
+        }
+    }
+    else if (std::holds_alternative<StartTime>(data)) {
+        log_w(rabbitmq, "Received start time after starting, ignoring");
+    }
+    else if (target != nullptr) {
+        dispatchToStrategy(data, *target);
+    }
+    return std::nullopt;
+}
+
+void
+RabbitMQ::dispatchToStrategy(const IncomingMessage& data, Hosted& client)
+{
+    // The book is up to date by the time the algo hears of the change
+    if (std::holds_alternative<ObUpdate>(data))
+        client.books.apply(std::get<ObUpdate>(data));
+    if (client.native_strategy.has_value()) {
+        dispatchToNative(data, client.native_strategy.value());
+        return;
+    }
+    if (!client.strategy.has_value())
+        return;
+    pywrapper::Strategy& strategy = client.strategy.value();
+    guard_strategy(strategy.uid, [&] { dispatchToPython(data, strategy, client); });
+}
+
+void
+RabbitMQ::dispatchToPython(
+    const IncomingMessage& data,
+    pywrapper::Strategy& strategy,
+    Hosted& client
+)
+{
+    if (std::holds_alternative<ObUpdate>(data)) {
+        log_i(
+            rabbitmq,
+            "Received order book update: {}",
+            glz::write_json(std::get<ObUpdate>(data))
+        );
+        if (conflate)
+            client.conflator.add(std::get<ObUpdate>(data));
+        else
+            pywrapper::deliver(strategy, std::get<ObUpdate>(data));
+    }
+    else if (std::holds_alternative<Match>(data)) {
+        log_i(rabbitmq, "Received match: {}", glz::write_json(std::get<Match>(data)));
+        pywrapper::deliver(strategy, std::get<Match>(data));
+    }
+    else if (std::holds_alternative<AccountUpdate>(data)) {
+        const AccountUpdate& update = std::get<AccountUpdate>(data);
+        log_i(
+            rabbitmq,
+            "Received account update with capital remaining: {}",
+            update.capital_remaining
+        );
+        pywrapper::deliver(strategy, update);
+    }
+}
+
+void
+RabbitMQ::dispatchToNative(const IncomingMessage& data, native::NativeStrategy& strategy)
+{
+    // Neither logged nor conflated nor batched, these are for latency
+    if (std::holds_alternative<ObUpdate>(data))
+        strategy.on_orderbook_update(std::get<ObUpdate>(data));
+    else if (std::holds_alternative<Match>(data))
+        strategy.on_trade_update(std::get<Match>(data));
+    else if (std::holds_alternative<AccountUpdate>(data))
+        strategy.on_account_update(std::get<AccountUpdate>(data));
+}
+
+void
+RabbitMQ::applySnapshot(const BookSnapshot& snapshot, Hosted& client)
+{
+    client.resume_sequence = snapshot.sequence;
+    // Levels gone since the algo last heard of them are cleared before the replay
+    std::vector<ObUpdate> stale = client.books.clearing_updates();
+    client.books.reset(snapshot.levels);
+    if (client.native_strategy.has_value()) {
+        for (const auto& level : stale)
+            client.native_strategy->on_orderbook_update(level);
+        for (const auto& level : snapshot.levels)
+            client.native_strategy->on_orderbook_update(level);
+        return;
+    }
+    if (!client.strategy.has_value())
+        return;
+    // Replay every level as an orderbook update so the algo can rebuild its book
+    pywrapper::Strategy& strategy = client.strategy.value();
+    guard_strategy(strategy.uid, [&] {
+        for (const auto& level : stale)
+            pywrapper::deliver(strategy, level);
+        for (const auto& level : snapshot.levels)
+            pywrapper::deliver(strategy, level);
+    });
+}
+
+void
+RabbitMQ::deliverOrderAcks()
+{
+    auto deliver = [this](const OrderSender::Ack& ack) {
+        Hosted* client = findHosted(ack.client_uid);
+        if (client == nullptr || !client->strategy.has_value())
+            return;
+        pywrapper::Strategy& strategy = client->strategy.value();
+        guard_strategy(strategy.uid, [&] {
+            pywrapper::acknowledge(strategy, ack.order_id, ack.sent);
+        });
+    };
+    // Acks may place further orders, which are acknowledged next time
+    for (const auto& ack : std::exchange(ring_acks, {}))
+        deliver(ack);
+    while (std::optional<OrderSender::Ack> ack = order_sender.pop_ack())
+        deliver(ack.value());
+}
+
+void
+RabbitMQ::tickStrategies()
+{
+    for (auto& client : hosted) {
+        if (!client.strategy.has_value())
+            continue;
+        pywrapper::Strategy& strategy = client.strategy.value();
+        guard_strategy(strategy.uid, [&strategy] { pywrapper::tick(strategy); });
+    }
+}
+
+void
+RabbitMQ::flushBatches()
+{
+    for (auto& client : hosted) {
+        if (!client.strategy.has_value())
+            continue;
+        pywrapper::Strategy& strategy = client.strategy.value();
+        client.conflator.drain([&strategy](const ObUpdate& update) {
+            guard_strategy(strategy.uid, [&] { pywrapper::deliver(strategy, update); });
+        });
+        guard_strategy(strategy.uid, [&strategy] { pywrapper::flush_batch(strategy); });
+    }
+}
+
+size_t
+RabbitMQ::pollMarketData()
+{
+    if (awaiting_snapshot) {
+        // The request or its reply may have been lost (or throttled by the exchange)
+        auto waited = std::chrono::steady_clock::now() - snapshot_requested_at;
+        if (waited >= std::chrono::milliseconds(SNAPSHOT_TIMEOUT_MS)) {
+            log_w(
+                shm,
+                "No book snapshot after {} ms, requesting again",
+                SNAPSHOT_TIMEOUT_MS
             );
-            std::string side = update.side == messages::SIDE::BUY ? "BUY" : "SELL";
-            nutc::pywrapper::get_account_update_function()(
-                update.ticker,
-                side,
-                update.price,
-                update.quantity,
-                update.capital_remaining
+            requestSnapshot();
+        }
+        return 0;
+    }
+
+    std::string buf;
+    std::string exclude_uid;
+    size_t consumed = 0;
+    // Conflating, the pass takes what had been published when it began
+    uint64_t pass_end = market_data_ring->next_sequence();
+    while (conflate ? market_data_cursor < pass_end : consumed < SHM_MARKET_DATA_BATCH) {
+        shm::ReadStatus status =
+            market_data_ring->read(market_data_cursor, buf, exclude_uid);
+        if (status == shm::ReadStatus::EMPTY)
+            break;
+        if (status == shm::ReadStatus::OVERRUN) [[unlikely]] {
+            log_w(
+                shm,
+                "Overrun on market data ring at sequence {}, requesting snapshot",
+                market_data_cursor
             );
+            requestSnapshot();
+            break;
         }
-        else {
-            log_e(rabbitmq, "Unknown message type");
-            return RMQError{"Unknown message type"};
+
+        uint64_t sequence = market_data_cursor++;
+        consumed++;
+        IncomingMessage data = decodeMessage(buf);
+        for (auto& client : hosted) {
+            // Already part of a snapshot it was sent
+            if (sequence < client.resume_sequence)
+                continue;
+            // Withheld from this client's algo (e.g. the update for its own order), but
+            // its mirrored book still has to reflect it
+            if (client.uid == exclude_uid) {
+                if (std::holds_alternative<ObUpdate>(data))
+                    client.books.apply(std::get<ObUpdate>(data));
+                continue;
+            }
+            dispatchToStrategy(data, client);
         }
     }
+    return consumed;
 }
 
-bool
+void
+RabbitMQ::requestSnapshot()
+{
+    std::string message = glz::write_json(SnapshotRequest{hosted.front().uid});
+    if (!publishToExchange(hosted.front(), message)) {
+        log_e(shm, "Failed to request book snapshot, skipping to latest market data");
+        market_data_cursor = market_data_ring->next_sequence();
+        return;
+    }
+    awaiting_snapshot = true;
+    snapshot_requested_at = std::chrono::steady_clock::now();
+}
+
+uint64_t
 RabbitMQ::publishMarketOrder(
     const std::string& client_uid,
     const std::string& side,
@@ -129,8 +447,9 @@ RabbitMQ::publishMarketOrder(
     float price
 )
 {
-    if (limiter.should_rate_limit()) {
-        return false;
+    Hosted* client = findHosted(client_uid);
+    if (client == nullptr || client->limiter.should_rate_limit()) {
+        return 0;
     }
     MarketOrder order{
         client_uid,
@@ -142,7 +461,20 @@ RabbitMQ::publishMarketOrder(
     std::string message = glz::write_json(order);
 
     log_i(rabbitmq, "Publishing order: {}", message);
-    return publishMessage("market_order", message);
+    uint64_t order_id = ++last_order_id;
+
+    // The order ring never blocks, so those orders are acknowledged right away
+    if (client->order_ring != nullptr) {
+        if (!publishToExchange(*client, message))
+            return 0;
+        ring_acks.push_back({client_uid, order_id, true});
+        return order_id;
+    }
+    if (!order_sender.enqueue({client_uid, order_id, std::move(message)})) {
+        log_w(rabbitmq, "Too many orders awaiting publication, dropping order");
+        return 0;
+    }
+    return order_id;
 }
 
 bool
@@ -168,16 +500,14 @@ RabbitMQ::publishMessage(const std::string& queueName, const std::string& messag
     return true;
 }
 
-std::variant<StartTime, ShutdownMessage, RMQError, ObUpdate, Match, AccountUpdate>
-RabbitMQ::consumeMessage()
+RabbitMQ::IncomingMessage
+RabbitMQ::decodeMessage(const std::string& buf)
 {
-    std::string buf = consumeMessageAsString();
     if (buf == "") {
         return RMQError{"Failed to consume message."};
     }
 
-    std::variant<StartTime, ShutdownMessage, RMQError, ObUpdate, Match, AccountUpdate>
-        data{};
+    IncomingMessage data{};
     auto err = glz::read_json(data, buf);
     if (err) {
         std::string error = glz::format_error(err, buf);
@@ -186,14 +516,23 @@ RabbitMQ::consumeMessage()
     return data;
 }
 
-// Blocking
-std::string
-RabbitMQ::consumeMessageAsString()
+RabbitMQ::IncomingMessage
+RabbitMQ::consumeMessage(std::string* queue)
+{
+    return decodeMessage(consumeMessageAsString(nullptr, queue).value_or(""));
+}
+
+std::optional<std::string>
+RabbitMQ::consumeMessageAsString(struct timeval* timeout, std::string* queue)
 {
     amqp_envelope_t envelope;
     amqp_maybe_release_buffers(conn);
-    amqp_rpc_reply_t res = amqp_consume_message(conn, &envelope, NULL, 0);
+    amqp_rpc_reply_t res = amqp_consume_message(conn, &envelope, timeout, 0);
 
+    if (res.reply_type == AMQP_RESPONSE_LIBRARY_EXCEPTION
+        && res.library_error == AMQP_STATUS_TIMEOUT) {
+        return std::nullopt;
+    }
     if (res.reply_type != AMQP_RESPONSE_NORMAL) {
         log_e(rabbitmq, "Failed to consume message.");
         return "";
@@ -202,37 +541,60 @@ RabbitMQ::consumeMessageAsString()
     std::string message(
         reinterpret_cast<char*>(envelope.message.body.bytes), envelope.message.body.len
     );
+    // Published through the default exchange, so the routing key is the queue
+    if (queue != nullptr) {
+        queue->assign(
+            reinterpret_cast<char*>(envelope.routing_key.bytes), envelope.routing_key.len
+        );
+    }
     amqp_destroy_envelope(&envelope);
     return message;
 }
 
 bool
-RabbitMQ::initializeConnection(const std::string& queueName)
+RabbitMQ::initializeConnection(const std::vector<std::string>& queueNames)
 {
-    if (!connectToRabbitMQ("localhost", 5672, "NUFT", "ADMIN")) {
-        log_c(rabbitmq, "Failed to connect to RabbitMQ");
-        return false;
-    }
-    amqp_channel_open(conn, 1);
-    amqp_rpc_reply_t res = amqp_get_rpc_reply(conn);
-    if (res.reply_type != AMQP_RESPONSE_NORMAL) {
-        log_e(rabbitmq, "Failed to open channel.");
+    if (!openConnection(conn)) {
         return false;
     }
 
-    if (!initializeQueue(queueName)) {
-        return false;
+    for (const auto& queueName : queueNames) {
+        if (!initializeQueue(queueName)) {
+            return false;
+        }
+
+        if (!initializeConsume(queueName)) {
+            return false;
+        }
     }
 
-    if (!initializeConsume(queueName)) {
+    amqp_connection_state_t order_conn = nullptr;
+    if (!openConnection(order_conn)) {
         return false;
     }
+    order_sender.start(order_conn);
 
     log_i(rabbitmq, "Connection established");
 
     return true;
 }
 
+bool
+RabbitMQ::openConnection(amqp_connection_state_t& connection)
+{
+    if (!connectToRabbitMQ(connection, "localhost", 5672, "NUFT", "ADMIN")) {
+        log_c(rabbitmq, "Failed to connect to RabbitMQ");
+        return false;
+    }
+    amqp_channel_open(connection, 1);
+    amqp_rpc_reply_t res = amqp_get_rpc_reply(connection);
+    if (res.reply_type != AMQP_RESPONSE_NORMAL) {
+        log_e(rabbitmq, "Failed to open channel.");
+        return false;
+    }
+    return true;
+}
+
 bool
 RabbitMQ::initializeConsume(const std::string& queueName)
 {
@@ -256,57 +618,236 @@ RabbitMQ::initializeConsume(const std::string& queueName)
     return true;
 }
 
-RabbitMQ::RabbitMQ(const std::string& uid)
+RabbitMQ::RabbitMQ(const std::vector<std::string>& uids)
 {
-    if (!initializeConnection(uid)) {
+    hosted.reserve(uids.size());
+    for (const auto& uid : uids) {
+        hosted.emplace_back();
+        hosted.back().uid = uid;
+    }
+
+    if (!initializeConnection(uids)) {
         log_c(rabbitmq, "Failed to initialize connection to RabbitMQ");
         // attempt to say we didn't init correctly
-        bool published_init = publishInit(uid, false);
-        if (!published_init) {
-            log_e(rabbitmq, "Failed to publish init message");
+        for (const auto& uid : uids) {
+            bool published_init = publishInit(uid, false);
+            if (!published_init) {
+                log_e(rabbitmq, "Failed to publish init message");
+            }
         }
 
         exit(1);
     }
 }
 
-std::function<bool(const std::string&, const std::string&, float, float)>
-RabbitMQ::getMarketFunc(const std::string& uid)
+std::function<
+    uint64_t(const std::string&, const std::string&, const std::string&, float, float)>
+RabbitMQ::getMarketFunc()
 {
     return std::bind(
         &RabbitMQ::publishMarketOrder,
         this,
-        uid,
         std::placeholders::_1,
         std::placeholders::_2,
         std::placeholders::_3,
-        std::placeholders::_4
+        std::placeholders::_4,
+        std::placeholders::_5
     );
 }
 
+std::function<uint64_t(const std::string&)>
+RabbitMQ::getConflatedFunc()
+{
+    return [this](const std::string& uid) -> uint64_t {
+        Hosted* client = findHosted(uid);
+        return client == nullptr ? 0 : client->conflator.conflated();
+    };
+}
+
+void
+RabbitMQ::enableConflation()
+{
+    conflate = true;
+}
+
+std::function<book::MirroredBook*(const std::string&, const std::string&)>
+RabbitMQ::getBookFunc()
+{
+    return [this](const std::string& uid, const std::string& ticker) {
+        Hosted* client = findHosted(uid);
+        return client == nullptr ? nullptr : &client->books.get(ticker);
+    };
+}
+
+void
+RabbitMQ::addStrategy(pywrapper::Strategy strategy)
+{
+    Hosted* client = findHosted(strategy.uid);
+    if (client != nullptr)
+        client->strategy = std::move(strategy);
+}
+
+void
+RabbitMQ::addStrategy(native::NativeStrategy strategy)
+{
+    Hosted* client = findHosted(strategy.get_uid());
+    if (client != nullptr)
+        client->native_strategy = std::move(strategy);
+}
+
 bool
 RabbitMQ::publishInit(const std::string& uid, bool ready)
 {
     std::string message = glz::write_json(InitMessage{uid, ready});
     log_i(rabbitmq, "Publishing init message: {}", message);
-    bool rVal = publishMessage("market_order", message);
+    Hosted* client = findHosted(uid);
+    if (client == nullptr) {
+        return publishMessage("market_order", message);
+    }
+    client->ready = ready;
+    bool rVal = publishToExchange(*client, message);
     return rVal;
 }
 
+bool
+RabbitMQ::attachSharedMemory()
+{
+    if (!attachMarketDataRing()) {
+        return false;
+    }
+    for (auto& client : hosted) {
+        if (attachOrderRing(client))
+            continue;
+        for (auto& attached : hosted) {
+            attached.order_ring = nullptr;
+            attached.order_region.reset();
+        }
+        market_data_ring = nullptr;
+        market_data_region.reset();
+        return false;
+    }
+    return true;
+}
+
+bool
+RabbitMQ::attachOrderRing(Hosted& client)
+{
+    std::string name = SHM_ORDER_RING_PREFIX + client.uid;
+    auto region = shm::SharedMemoryRegion::open(name, sizeof(shm::OrderRing));
+    if (!region.has_value()) {
+        return false;
+    }
+
+    auto* ring = static_cast<shm::OrderRing*>(region->data());
+    if (!ring->is_initialized()) {
+        log_e(shm, "Order ring {} has an incompatible layout", name);
+        return false;
+    }
+
+    client.order_region = std::move(region);
+    client.order_ring = ring;
+    log_i(shm, "Attached to shared memory order ring {}", name);
+    return true;
+}
+
+bool
+RabbitMQ::attachMarketDataRing()
+{
+    auto region = shm::SharedMemoryRegion::open(
+        SHM_MARKET_DATA_RING, sizeof(shm::MarketDataRing), false
+    );
+    if (!region.has_value()) {
+        return false;
+    }
+
+    auto* ring = static_cast<const shm::MarketDataRing*>(region->data());
+    if (!ring->is_initialized()) {
+        log_e(shm, "Market data ring {} has an incompatible layout", SHM_MARKET_DATA_RING);
+        return false;
+    }
+
+    market_data_region = std::move(region);
+    market_data_ring = ring;
+    // Nothing is published before the exchange starts, so begin with the live stream
+    market_data_cursor = ring->next_sequence();
+    log_i(shm, "Attached to shared memory market data ring {}", SHM_MARKET_DATA_RING);
+    return true;
+}
+
+bool
+RabbitMQ::publishToExchange(Hosted& client, const std::string& message)
+{
+    if (client.order_ring == nullptr) {
+        return publishMessage("market_order", message);
+    }
+
+    if (!client.order_ring->try_push(message)) {
+        log_w(shm, "Order ring full or message too large, dropping message");
+        return false;
+    }
+    return true;
+}
+
 void
 RabbitMQ::waitForStartTime()
 {
-    auto message = consumeMessage();
-    if (std::holds_alternative<StartTime>(message)) {
-        StartTime start = std::get<StartTime>(message);
-        std::chrono::high_resolution_clock::time_point wait_until =
-            std::chrono::high_resolution_clock::time_point(
-                std::chrono::nanoseconds(start.start_time_ns)
+    size_t num_ready = std::count_if(hosted.begin(), hosted.end(), [](const Hosted& h) {
+        return h.ready;
+    });
+    std::unordered_set<std::string> started;
+    long long start_time_ns = 0;
+    std::string queue;
+    while (started.size() < num_ready) {
+        auto message = consumeMessage(&queue);
+        if (std::holds_alternative<RMQError>(message)) {
+            log_e(rabbitmq, "Failed to wait for start time");
+            return;
+        }
+        Hosted* client = findHosted(queue);
+        if (client == nullptr || !client->ready) {
+            continue;
+        }
+        // Clients that join after trading started get the current books first
+        if (std::holds_alternative<BookSnapshot>(message)) {
+            client->late_snapshot = std::get<BookSnapshot>(message);
+            log_i(
+                rabbitmq,
+                "{} joining late at sequence {}",
+                client->uid,
+                client->late_snapshot->sequence
             );
-        std::this_thread::sleep_until(wait_until);
-        log_i(rabbitmq, "Received start time: {}", start.start_time_ns);
-        return;
+        }
+        else if (std::holds_alternative<StartTime>(message)) {
+            StartTime start = std::get<StartTime>(message);
+            start_time_ns = std::max(start_time_ns, start.start_time_ns);
+            started.insert(client->uid);
+            log_i(
+                rabbitmq, "Received start time for {}: {}", client->uid,
+                start.start_time_ns
+            );
+        }
+        else {
+            // Market data for a client that already started, while another is still
+            // waiting for its start time
+            early_messages.emplace_back(queue, std::move(message));
+        }
+    }
+
+    // Read the ring from the oldest point any client still needs; each client skips
+    // what it has already seen
+    uint64_t attached_at = market_data_cursor;
+    for (auto& client : hosted) {
+        client.resume_sequence = client.late_snapshot.has_value()
+                                     ? client.late_snapshot->sequence
+                                     : attached_at;
+        market_data_cursor = std::min(market_data_cursor, client.resume_sequence);
     }
+
+    std::chrono::high_resolution_clock::time_point wait_until =
+        std::chrono::high_resolution_clock::time_point(
+            std::chrono::nanoseconds(start_time_ns)
+        );
+    std::this_thread::sleep_until(wait_until);
 }
 
 bool
@@ -328,6 +869,18 @@ RabbitMQ::initializeQueue(const std::string& queueName)
 
 RabbitMQ::~RabbitMQ()
 {
+    if (network_thread.joinable()) {
+        network_running = false;
+        network_thread.join();
+    }
+    if (conflate) {
+        for (const auto& client : hosted) {
+            log_i(
+                rabbitmq, "Conflated {} orderbook updates for {}",
+                client.conflator.conflated(), client.uid
+            );
+        }
+    }
     amqp_channel_close(conn, 1, AMQP_REPLY_SUCCESS);
     amqp_connection_close(conn, AMQP_REPLY_SUCCESS);
     amqp_destroy_connection(conn);
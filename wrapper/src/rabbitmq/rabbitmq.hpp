@@ -1,15 +1,33 @@
 #pragma once
 
+#include "book/mirrored_book.hpp"
+#include "book/update_conflator.hpp"
+#include "native/native_strategy.hpp"
 #include "pywrapper/pywrapper.hpp"
 #include "pywrapper/rate_limiter.hpp"
+#include "rabbitmq/order_sender.hpp"
+#include "shm/market_data_ring.hpp"
+#include "shm/order_ring.hpp"
+#include "shm/shared_memory.hpp"
 #include "util/messages.hpp"
+#include "util/spsc_queue.hpp"
 
+#include <sys/time.h>
 #include <unistd.h>
 
 #include <chrono>
 
+#include <atomic>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
 
 #include <rabbitmq-c/amqp.h>
 #include <rabbitmq-c/tcp_socket.h>
@@ -22,6 +40,10 @@ using ShutdownMessage = nutc::messages::ShutdownMessage;
 using Match = nutc::messages::Match;
 using AccountUpdate = nutc::messages::AccountUpdate;
 using StartTime = nutc::messages::StartTime;
+using BookSnapshot = nutc::messages::BookSnapshot;
+using SnapshotRequest = nutc::messages::SnapshotRequest;
+using OrderRejected = nutc::messages::OrderRejected;
+using LevelTotals = nutc::messages::LevelTotals;
 
 /**
  * @brief The namespace for the NUTC client
@@ -39,22 +61,35 @@ namespace rabbitmq {
  * Main event loop (i.e., program loops on this class)
  * Handles initialization and closure of the RMQ connection
  * Handles incoming messages from exchange (i.e., order book updates, matches, etc.)
- * Handles outgoing messages to exchange (i.e., market orders)
+ * Handles outgoing messages to exchange (i.e., market orders); orders bound for the
+ * broker are published from a separate thread, see OrderSender
  * Provides a callback for the market order function (so it can be triggered by algo)
  * Calls the algo's callbacks when receiving a message from the exchange (order book
  * update, account update, etc)
+ * Mirrors every ticker's order book from the updates, for the algo to read
+ *
+ * Once trading starts, a network thread consumes and decodes everything the broker
+ * delivers into a queue, so reading never waits on the algos. The algos' (Python)
+ * thread drains that queue and the market data ring, and calls each algo's on_tick
+ * every STRATEGY_TICK_MS; it releases the GIL while idle.
+ *
+ * One process may host several clients' algorithms (strategies). They share the
+ * connection, which consumes every client's queue, and the shared memory market data
+ * feed, but each has its own order ring and rate limit. Messages from a client's queue
+ * go only to that client's strategy; market data read from the ring goes to all of
+ * them, except what the exchange withheld from a particular client.
  */
 class RabbitMQ {
 public:
     /**
      * @brief Constructor for RabbitMQ (RAII)
      *
-     * Initialzies the RMQ connection and creates a queue to receive messages under the
-     * given UID
+     * Initialzies the RMQ connection and creates a queue to receive messages under
+     * each given UID
      *
-     * @param uid The unique identifier for the client
+     * @param uids The clients hosted by this process
      */
-    RabbitMQ(const std::string& uid);
+    RabbitMQ(const std::vector<std::string>& uids);
 
     /**
      * @brief Destructor for RabbitMQ (RAII)
@@ -77,18 +112,73 @@ public:
      */
     [[nodiscard]] bool publishInit(const std::string& uid, bool ready);
 
+    /**
+     * @brief Maps the shared memory rings the exchange created for co-located clients
+     *
+     * Once attached, each client's init message and market orders are pushed into its
+     * order ring, and orderbook and trade updates are read from the shared market data
+     * ring. Account updates and other messages still arrive over RabbitMQ. The
+     * exchange treats any client using its order ring as a market data ring reader, so
+     * either every ring is attached or none is.
+     *
+     * @returns True if every ring was mapped and is ready for use
+     */
+    [[nodiscard]] bool attachSharedMemory();
+
     /**
      * @brief Callback for the market order function
      *
      * Used by the wrapper to trigger an order from the py/cpp client
-     * Bound to the publishMarketOrder function, but will the client_uid prefilled
+     * Bound to the publishMarketOrder function
+     *
+     * @returns A function that takes the placing client's uid and the order parameters
+     * and queues the order, returning its id (0 if it was dropped). Once the order has
+     * gone out, the event loop acknowledges it to the algo
+     */
+    std::function<
+        uint64_t(const std::string&, const std::string&, const std::string&, float, float)>
+    getMarketFunc();
+
+    /**
+     * @brief Callback for the algos to look up their mirrored order books
+     *
+     * @returns A function that takes a hosted client's uid and a ticker and returns
+     * that client's book for the ticker (nullptr for an unknown uid)
+     */
+    std::function<book::MirroredBook*(const std::string&, const std::string&)>
+    getBookFunc();
+
+    /**
+     * @brief Holds orderbook updates back until the end of each pass of the event
+     * loop, delivering only the latest for each ticker, side and price
      *
-     * @param uid The unique identifier for the client
-     * @returns A function that takes the order parameters and publishes the order
+     * Keeps algos that are slower than the market data near the current book instead
+     * of working through a backlog: each pass takes everything that had arrived when
+     * it began, not just DISPATCH_BATCH_MAX messages. Trades and account updates are all delivered,
+     * as they arrive, so they reach the algo ahead of the pass's orderbook updates.
      */
-    std::function<bool(const std::string&, const std::string&, float, float)>
-    getMarketFunc(const std::string& uid);
+    void enableConflation();
 
+    /**
+     * @returns A function that takes a hosted client's uid and returns how many of its
+     * orderbook updates were conflated away
+     */
+    std::function<uint64_t(const std::string&)> getConflatedFunc();
+
+    /**
+     * @brief Delivers a hosted client's messages to its algorithm from now on
+     */
+    void addStrategy(pywrapper::Strategy strategy);
+    void addStrategy(native::NativeStrategy strategy);
+
+    /**
+     * @brief Blocks until the exchange has sent every ready client its start time,
+     * then until the latest of them
+     *
+     * A client that reports ready after trading started is sent a book snapshot
+     * first; it is replayed to the algo once handleIncomingMessages starts, as is
+     * anything that arrives for clients that already started
+     */
     void waitForStartTime();
 
     /**
@@ -96,28 +186,91 @@ public:
      *
      * This is the main event loop of the client. Until given a shutdown message or
      * SIGINT, it will continually receive messages from the exchange (orderbook update,
-     * account update, or trade update)
+     * account update, or trade update). Starts the network thread; the connection must
+     * not be used from this thread afterwards
      *
      * @returns A shutdown or error message
      */
     std::variant<ShutdownMessage, RMQError> handleIncomingMessages();
 
 private:
-    rate_limiter::RateLimiter limiter;
-    [[nodiscard]] bool initializeConnection(const std::string& queueName);
+    /**
+     * @brief Everything kept per hosted client
+     */
+    struct Hosted {
+        std::string uid;
+        rate_limiter::RateLimiter limiter;
+        std::optional<shm::SharedMemoryRegion> order_region;
+        shm::OrderRing* order_ring = nullptr;
+        // Ring messages before this are already reflected in a snapshot it was sent
+        uint64_t resume_sequence = 0;
+        std::optional<BookSnapshot> late_snapshot;
+        // Mirrored from the orderbook updates and snapshots this client receives
+        book::OrderBooks books;
+        // Orderbook updates held back for the algo, with enableConflation()
+        book::UpdateConflator conflator;
+        // Whether it told the exchange it is ready, i.e. will be sent a start time
+        bool ready = false;
+        std::optional<pywrapper::Strategy> strategy;
+        // Instead of strategy, for algos compiled to a shared object
+        std::optional<native::NativeStrategy> native_strategy;
+    };
+
+    Hosted* findHosted(std::string_view uid);
+
+    [[nodiscard]] bool initializeConnection(const std::vector<std::string>& queueNames);
     [[nodiscard]] bool initializeConsume(const std::string& queueName);
-    [[nodiscard]] bool connectToRabbitMQ(
+    // Connects to the broker and opens channel 1
+    [[nodiscard]] static bool openConnection(amqp_connection_state_t& connection);
+    [[nodiscard]] static bool connectToRabbitMQ(
+        amqp_connection_state_t& connection,
         const std::string& hostname,
         int port,
         const std::string& username,
         const std::string& password
     );
 
+    using IncomingMessage = std::variant<
+        StartTime,
+        ShutdownMessage,
+        RMQError,
+        ObUpdate,
+        Match,
+        AccountUpdate,
+        BookSnapshot,
+        OrderRejected,
+        LevelTotals>;
+
+    [[nodiscard]] bool attachOrderRing(Hosted& client);
+
+    /**
+     * @brief Maps the exchange's market data ring; if this client later falls so far
+     * behind that unread messages are overwritten, it requests a book snapshot and
+     * resumes from the snapshot's position
+     */
+    [[nodiscard]] bool attachMarketDataRing();
+
     amqp_connection_state_t conn;
+    OrderSender order_sender;
+    uint64_t last_order_id = 0;
+    // Orders pushed into an order ring, acknowledged on the next pass of the event loop
+    std::vector<OrderSender::Ack> ring_acks;
+    // Sized once, so pointers into it stay valid
+    std::vector<Hosted> hosted;
+    // Delivered before every hosted client had started, with the queue they came from
+    std::vector<std::pair<std::string, IncomingMessage>> early_messages;
+
+    std::optional<shm::SharedMemoryRegion> market_data_region;
+    const shm::MarketDataRing* market_data_ring = nullptr;
+    uint64_t market_data_cursor = 0;
+    bool awaiting_snapshot = false;
+    std::chrono::steady_clock::time_point snapshot_requested_at;
+    bool conflate = false;
     [[nodiscard]] bool
     publishMessage(const std::string& queueName, const std::string& message);
+    [[nodiscard]] bool publishToExchange(Hosted& client, const std::string& message);
     [[nodiscard]] bool initializeQueue(const std::string& queueName);
-    [[nodiscard]] bool publishMarketOrder(
+    [[nodiscard]] uint64_t publishMarketOrder(
         const std::string& client_uid,
         const std::string& side,
         const std::string& ticker,
@@ -125,9 +278,77 @@ private:
         float price
     );
 
-    std::string consumeMessageAsString();
-    std::variant<StartTime, ShutdownMessage, RMQError, ObUpdate, Match, AccountUpdate>
-    consumeMessage();
+    /**
+     * @brief Receives the next message from the broker
+     *
+     * @param timeout Maximum time to wait, or nullptr to block
+     * @param queue If set, receives the name of the queue (client uid) the message was
+     * delivered to
+     * @returns The message (empty on failure), or nullopt if the timeout expired
+     */
+    std::optional<std::string>
+    consumeMessageAsString(struct timeval* timeout, std::string* queue = nullptr);
+    IncomingMessage consumeMessage(std::string* queue = nullptr);
+    static IncomingMessage decodeMessage(const std::string& buf);
+
+    /**
+     * @brief Dispatches a message to the algos' callbacks
+     * @param target The client whose queue the message came from; algo callbacks are
+     * skipped if nullptr
+     * @returns A shutdown or error message if the event loop should stop
+     */
+    std::optional<std::variant<ShutdownMessage, RMQError>>
+    dispatchMessage(const IncomingMessage& data, Hosted* target);
+
+    void dispatchToStrategy(const IncomingMessage& data, Hosted& client);
+    void dispatchToPython(
+        const IncomingMessage& data,
+        pywrapper::Strategy& strategy,
+        Hosted& client
+    );
+    static void
+    dispatchToNative(const IncomingMessage& data, native::NativeStrategy& strategy);
+    void applySnapshot(const BookSnapshot& snapshot, Hosted& client);
+
+    /**
+     * @brief Hands each algo the orderbook updates conflation held back, and algos that
+     * take batches everything dispatched since the last call
+     */
+    void flushBatches();
+    void tickStrategies();
+
+    /**
+     * @brief Tells each algo which of its orders have gone out since the last call
+     */
+    void deliverOrderAcks();
+
+    /**
+     * @brief Dispatches up to SHM_MARKET_DATA_BATCH messages from the market data ring
+     * @returns The number of ring messages consumed
+     */
+    size_t pollMarketData();
+    void requestSnapshot();
+
+    /**
+     * @brief A decoded message and the queue (client uid) it was delivered to
+     */
+    struct Incoming {
+        std::string queue;
+        IncomingMessage message;
+    };
+
+    /**
+     * @brief Consumes from the broker into incoming until stopped, or until it has
+     * queued a shutdown or error message
+     */
+    void runNetworkThread();
+
+    util::SpscQueue<Incoming, INCOMING_QUEUE_SIZE> incoming;
+    // Only for waiting on incoming while idle; the queue itself is lock free
+    std::mutex incoming_mutex;
+    std::condition_variable incoming_ready;
+    std::atomic<bool> network_running{false};
+    std::thread network_thread;
 };
 
 } // namespace rabbitmq
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace nutc {
+namespace shm {
+
+/**
+ * @brief A single fixed-size slot of the MarketDataRing
+ *
+ * sequence is a seqlock: odd while a message is being written, 2 * (n + 1) once
+ * message n is complete.
+ */
+struct alignas(64) MarketDataSlot {
+    std::atomic<uint64_t> sequence;
+    uint32_t length;
+    uint32_t exclude_length;
+    char exclude_uid[SHM_MARKET_DATA_UID_SIZE];
+    char payload[SHM_MARKET_DATA_SLOT_PAYLOAD];
+};
+
+enum class ReadStatus { OK, EMPTY, OVERRUN };
+
+/**
+ * @brief Reader side of the exchange's market data broadcast ring
+ *
+ * The exchange writes every orderbook update and match once; each wrapper keeps its
+ * own cursor. The layout must stay byte-compatible with
+ * exchange/src/networking/shm/market_data_ring/MarketDataRing.hpp.
+ */
+struct MarketDataRing {
+    static constexpr uint64_t MAGIC = 0x544b524d4354554e; // "NUTCMRKT"
+    static constexpr uint32_t LAYOUT_VERSION = 1;
+    static constexpr uint64_t CAPACITY = SHM_MARKET_DATA_SLOTS;
+
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+    static_assert(sizeof(MarketDataSlot) == 256, "slot layout changed");
+
+    std::atomic<uint64_t> magic;
+    uint32_t version;
+    uint32_t capacity;
+
+    alignas(64) std::atomic<uint64_t> write_index;
+    alignas(64) MarketDataSlot slots[CAPACITY];
+
+    [[nodiscard]] bool
+    is_initialized() const
+    {
+        return magic.load(std::memory_order_acquire) == MAGIC
+               && version == LAYOUT_VERSION && capacity == CAPACITY;
+    }
+
+    /**
+     * @brief Sequence number the next message will be written at
+     */
+    [[nodiscard]] uint64_t
+    next_sequence() const
+    {
+        return write_index.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Copies message number index out of the ring
+     *
+     * @param message Receives the payload on ReadStatus::OK
+     * @param exclude_uid Receives the uid the exchange withheld the message from (e.g.
+     * the placer of the order it describes); empty if none
+     * @returns ReadStatus::OVERRUN if the writer has already reused the slot
+     */
+    ReadStatus
+    read(uint64_t index, std::string& message, std::string& exclude_uid) const
+    {
+        if (index >= write_index.load(std::memory_order_acquire))
+            return ReadStatus::EMPTY;
+
+        const MarketDataSlot& slot = slots[index & (CAPACITY - 1)];
+        uint64_t expected = 2 * (index + 1);
+        if (slot.sequence.load(std::memory_order_acquire) != expected)
+            return ReadStatus::OVERRUN;
+
+        uint32_t length = std::min<uint32_t>(slot.length, SHM_MARKET_DATA_SLOT_PAYLOAD);
+        uint32_t exclude_length =
+            std::min<uint32_t>(slot.exclude_length, SHM_MARKET_DATA_UID_SIZE);
+        exclude_uid.assign(slot.exclude_uid, exclude_length);
+        message.assign(slot.payload, length);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != expected)
+            return ReadStatus::OVERRUN;
+        return ReadStatus::OK;
+    }
+};
+
+} // namespace shm
+} // namespace nutc
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "config.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace nutc {
+namespace shm {
+
+/**
+ * @brief A single fixed-size slot of an OrderRing
+ *
+ * sequence follows Vyukov's bounded queue: a slot at position p is free for a producer
+ * when sequence == p and holds a message for the consumer when sequence == p + 1.
+ */
+struct alignas(64) OrderRingSlot {
+    std::atomic<uint64_t> sequence;
+    uint32_t length;
+    char payload[SHM_ORDER_SLOT_PAYLOAD];
+};
+
+/**
+ * @brief Producer side of the exchange's per-client order ring
+ *
+ * The exchange creates and drains the ring; the wrapper pushes its init message and
+ * orders into it. The layout must stay byte-compatible with
+ * exchange/src/networking/shm/order_ring/OrderRing.hpp.
+ */
+struct OrderRing {
+    static constexpr uint64_t MAGIC = 0x5244524f4354554e; // "NUTCORDR"
+    static constexpr uint32_t LAYOUT_VERSION = 1;
+    static constexpr uint64_t CAPACITY = SHM_ORDER_RING_SLOTS;
+
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+    static_assert(
+        std::atomic<uint64_t>::is_always_lock_free,
+        "cross-process atomics must be lock free"
+    );
+
+    std::atomic<uint64_t> magic;
+    uint32_t version;
+    uint32_t capacity;
+
+    alignas(64) std::atomic<uint64_t> enqueue_pos;
+    alignas(64) std::atomic<uint64_t> dequeue_pos;
+    alignas(64) OrderRingSlot slots[CAPACITY];
+
+    [[nodiscard]] bool
+    is_initialized() const
+    {
+        return magic.load(std::memory_order_acquire) == MAGIC
+               && version == LAYOUT_VERSION && capacity == CAPACITY;
+    }
+
+    /**
+     * @brief Pushes a message; safe to call from several threads at once
+     *
+     * @returns False if the ring is full or the message does not fit in a slot
+     */
+    bool
+    try_push(std::string_view message)
+    {
+        if (message.size() > SHM_ORDER_SLOT_PAYLOAD) [[unlikely]]
+            return false;
+
+        uint64_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        OrderRingSlot* slot;
+        while (true) {
+            slot = &slots[pos & (CAPACITY - 1)];
+            uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed
+                    ))
+                    break;
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->length = static_cast<uint32_t>(message.size());
+        std::memcpy(slot->payload, message.data(), message.size());
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+} // namespace shm
+} // namespace nutc
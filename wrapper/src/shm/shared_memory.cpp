@@ -0,0 +1,63 @@
+#include "shared_memory.hpp"
+
+#include "logging.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace nutc {
+namespace shm {
+
+std::optional<SharedMemoryRegion>
+SharedMemoryRegion::open(const std::string& name, size_t size, bool writable)
+{
+    int fd = shm_open(name.c_str(), writable ? O_RDWR : O_RDONLY, 0600);
+    if (fd < 0) {
+        log_e(shm, "shm_open({}) failed: {}", name, std::strerror(errno));
+        return std::nullopt;
+    }
+
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* data = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        log_e(shm, "mmap({}) failed: {}", name, std::strerror(errno));
+        return std::nullopt;
+    }
+
+    return SharedMemoryRegion{data, size};
+}
+
+SharedMemoryRegion::SharedMemoryRegion(SharedMemoryRegion&& other) noexcept :
+    data_(other.data_),
+    size_(other.size_)
+{
+    other.data_ = nullptr;
+}
+
+SharedMemoryRegion&
+SharedMemoryRegion::operator=(SharedMemoryRegion&& other) noexcept
+{
+    if (this == &other)
+        return *this;
+
+    if (data_ != nullptr)
+        munmap(data_, size_);
+    data_ = other.data_;
+    size_ = other.size_;
+    other.data_ = nullptr;
+    return *this;
+}
+
+SharedMemoryRegion::~SharedMemoryRegion()
+{
+    if (data_ != nullptr)
+        munmap(data_, size_);
+}
+
+} // namespace shm
+} // namespace nutc
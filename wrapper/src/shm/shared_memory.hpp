@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace nutc {
+/**
+ * @brief Shared memory transports to an exchange running on the same host
+ */
+namespace shm {
+
+/**
+ * @class SharedMemoryRegion
+ * @brief RAII view of a named POSIX shared memory object created by the exchange
+ *
+ * The exchange owns (creates and unlinks) every region; the wrapper only maps and
+ * unmaps them.
+ */
+class SharedMemoryRegion {
+public:
+    /**
+     * @brief Maps an existing region by name
+     *
+     * @param name Name of the shared memory object, including the leading slash
+     * @param size Number of bytes to map
+     * @param writable Whether the mapping should allow writes
+     *
+     * @returns The mapped region, or nullopt if it could not be opened
+     */
+    static std::optional<SharedMemoryRegion>
+    open(const std::string& name, size_t size, bool writable = true);
+
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+    SharedMemoryRegion(SharedMemoryRegion&& other) noexcept;
+    SharedMemoryRegion& operator=(SharedMemoryRegion&& other) noexcept;
+
+    ~SharedMemoryRegion();
+
+    [[nodiscard]] void*
+    data() const
+    {
+        return data_;
+    }
+
+    [[nodiscard]] size_t
+    size() const
+    {
+        return size_;
+    }
+
+private:
+    SharedMemoryRegion(void* data, size_t size) : data_(data), size_(size) {}
+
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace shm
+} // namespace nutc
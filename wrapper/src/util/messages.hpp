@@ -3,7 +3,9 @@
 #include <fmt/format.h>
 #include <glaze/glaze.hpp>
 
+#include <cstdint>
 #include <iostream>
+#include <vector>
 
 namespace nutc {
 
@@ -183,12 +185,16 @@ struct MarketOrder {
 
 /**
  * @brief Sent by exchange to clients to indicate an orderbook update
+ *
+ * quantity is what the order that changed now has resting; level_quantity is the
+ * total resting at its price afterwards
  */
 struct ObUpdate {
     std::string security;
     SIDE side;
     float price;
     float quantity;
+    float level_quantity = 0;
 };
 
 /**
@@ -203,6 +209,41 @@ struct AccountUpdate {
     float quantity;
 };
 
+/**
+ * @brief Sent by clients that lost track of the orderbook to ask the exchange for the
+ * current state of every book
+ */
+struct SnapshotRequest {
+    std::string requester_uid;
+};
+
+/**
+ * @brief Sent by exchange in response to a SnapshotRequest
+ * levels holds every resting price level of every book; sequence is the market data
+ * ring position to resume reading from
+ */
+struct BookSnapshot {
+    uint64_t sequence;
+    std::vector<ObUpdate> levels;
+};
+
+/**
+ * @brief Sent by exchange to a client whose order was dropped before matching, e.g.
+ * because the client exceeded its order rate limit
+ */
+struct OrderRejected {
+    std::string reject_reason;
+    std::string ticker;
+};
+
+/**
+ * @brief Sent by exchange to the client whose order changed the book, in place of the
+ * ObUpdates withheld from it, so the client's mirrored book stays current
+ */
+struct LevelTotals {
+    std::vector<ObUpdate> level_totals;
+};
+
 } // namespace messages
 } // namespace nutc
 
@@ -218,7 +259,9 @@ struct glz::meta<nutc::messages::ObUpdate> {
         "price",
         &T::price,
         "quantity",
-        &T::quantity
+        &T::quantity,
+        "level_quantity",
+        &T::level_quantity
     );
 };
 
@@ -299,3 +342,33 @@ struct glz::meta<nutc::messages::InitMessage> {
     static constexpr auto value =
         object("client_uid", &T::client_uid, "ready", &T::ready);
 };
+
+/// \cond
+template <>
+struct glz::meta<nutc::messages::SnapshotRequest> {
+    using T = nutc::messages::SnapshotRequest;
+    static constexpr auto value = object("requester_uid", &T::requester_uid);
+};
+
+/// \cond
+template <>
+struct glz::meta<nutc::messages::BookSnapshot> {
+    using T = nutc::messages::BookSnapshot;
+    static constexpr auto value =
+        object("sequence", &T::sequence, "levels", &T::levels);
+};
+
+/// \cond
+template <>
+struct glz::meta<nutc::messages::OrderRejected> {
+    using T = nutc::messages::OrderRejected;
+    static constexpr auto value =
+        object("reject_reason", &T::reject_reason, "ticker", &T::ticker);
+};
+
+/// \cond
+template <>
+struct glz::meta<nutc::messages::LevelTotals> {
+    using T = nutc::messages::LevelTotals;
+    static constexpr auto value = object("level_totals", &T::level_totals);
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace nutc {
+namespace util {
+
+/**
+ * @class SpscQueue
+ * @brief Bounded lock-free queue between exactly one producer and one consumer thread
+ *
+ * Slots are allocated once, up front; pushing fails instead of waiting when the queue
+ * is full.
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    SpscQueue() : slots(Capacity) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /**
+     * @brief Producer only
+     * @returns False if the queue is full
+     */
+    bool
+    try_push(T&& value)
+    {
+        size_t tail = tail_pos.load(std::memory_order_relaxed);
+        if (tail - head_pos.load(std::memory_order_acquire) == Capacity)
+            return false;
+        slots[tail & (Capacity - 1)] = std::move(value);
+        tail_pos.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer only
+     */
+    std::optional<T>
+    try_pop()
+    {
+        size_t head = head_pos.load(std::memory_order_relaxed);
+        if (head == tail_pos.load(std::memory_order_acquire))
+            return std::nullopt;
+        T value = std::move(slots[head & (Capacity - 1)]);
+        head_pos.store(head + 1, std::memory_order_release);
+        return value;
+    }
+
+    /**
+     * @brief Consumer only; items pushed meanwhile may or may not be counted
+     */
+    [[nodiscard]] size_t
+    size() const
+    {
+        return tail_pos.load(std::memory_order_acquire)
+               - head_pos.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] bool
+    empty() const
+    {
+        return head_pos.load(std::memory_order_acquire)
+               == tail_pos.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> slots;
+    alignas(64) std::atomic<size_t> head_pos{0};
+    alignas(64) std::atomic<size_t> tail_pos{0};
+};
+
+} // namespace util
+} // namespace nutc
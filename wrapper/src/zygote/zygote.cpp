@@ -0,0 +1,113 @@
+#include "zygote.hpp"
+
+#include "config.h"
+
+#include <fmt/format.h>
+#include <pybind11/embed.h>
+#include <pybind11/pybind11.h>
+
+#include <cstdlib>
+
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace py = pybind11;
+
+// Logging isn't initialized in the zygote: it is per uid, and quill's backend thread
+// would not survive the fork. Progress goes to stderr instead.
+
+namespace nutc {
+namespace zygote {
+
+namespace {
+std::optional<Assignment>
+parse_request(const std::string& line)
+{
+    size_t tab = line.find('\t');
+    if (tab == std::string::npos || tab == 0)
+        return std::nullopt;
+    return Assignment{line.substr(0, tab), line.substr(tab + 1) == "1"};
+}
+
+void
+report(const std::string& line)
+{
+    size_t written = 0;
+    while (written < line.size()) {
+        ssize_t result =
+            write(ZYGOTE_REPORT_FD, line.data() + written, line.size() - written);
+        if (result <= 0)
+            return;
+        written += static_cast<size_t>(result);
+    }
+}
+
+// The child keeps the exchange's stdout/stderr but not the zygote's control channels
+void
+detach_child()
+{
+    close(ZYGOTE_REPORT_FD);
+    int null_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    if (null_fd >= 0) {
+        dup2(null_fd, STDIN_FILENO);
+        close(null_fd);
+    }
+}
+} // namespace
+
+void
+preload(const std::vector<std::string>& modules)
+{
+    // Read by the libraries when they load, so the interpreter having started is fine
+    for (const char* variable : ZYGOTE_THREAD_LIMIT_VARS)
+        setenv(variable, "1", 1);
+
+    for (const auto& module : modules) {
+        try {
+            py::module_::import(module.c_str());
+        } catch (const py::error_already_set& err) {
+            fmt::print(
+                stderr, "Zygote failed to preload {}: {}\n", module, err.what()
+            );
+        }
+    }
+}
+
+std::optional<Assignment>
+serve()
+{
+    std::string line;
+    size_t forked = 0;
+    while (std::getline(std::cin, line)) {
+        std::optional<Assignment> assignment = parse_request(line);
+        if (!assignment.has_value()) {
+            fmt::print(stderr, "Zygote ignoring malformed request \"{}\"\n", line);
+            continue;
+        }
+
+        PyOS_BeforeFork();
+        pid_t pid = fork();
+        if (pid == 0) {
+            PyOS_AfterFork_Child();
+            detach_child();
+            return assignment;
+        }
+        PyOS_AfterFork_Parent();
+
+        if (pid < 0) {
+            fmt::print(stderr, "Zygote failed to fork {}\n", assignment->uid);
+            report(fmt::format("{}\t-1\n", assignment->uid));
+            continue;
+        }
+        report(fmt::format("{}\t{}\n", assignment->uid, pid));
+        forked++;
+    }
+
+    fmt::print(stderr, "Zygote forked {} clients, exiting\n", forked);
+    return std::nullopt;
+}
+
+} // namespace zygote
+} // namespace nutc
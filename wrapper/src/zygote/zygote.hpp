@@ -0,0 +1,41 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace nutc {
+
+/**
+ * @brief Forks clients from one warm interpreter instead of starting one per client
+ *
+ * The exchange starts a single "NUTC-client --zygote" and writes one line per client to
+ * its stdin: the uid, a tab, and 1 or 0 for whether the client uses shared memory. The
+ * zygote imports the heavy modules strategies share once, then forks a child per line
+ * and reports "<uid>\t<pid>" on ZYGOTE_REPORT_FD. Children inherit the imported modules
+ * copy-on-write, so each only has to connect and load its own strategy.
+ */
+namespace zygote {
+
+struct Assignment {
+    std::string uid;
+    bool use_shm;
+};
+
+/**
+ * @brief Imports each module, warning about (but skipping) any that fail
+ * @details Must run with the interpreter initialized and before any threads start.
+ * Limits numerical libraries to one thread first (ZYGOTE_THREAD_LIMIT_VARS), so the
+ * imports start no threads the fork would lose
+ */
+void preload(const std::vector<std::string>& modules);
+
+/**
+ * @brief Forks a child for every client requested on stdin
+ * @return In each child, the client it should become. In the zygote, nullopt once
+ * stdin is closed and every client has been forked
+ */
+std::optional<Assignment> serve();
+
+} // namespace zygote
+} // namespace nutc
@@ -1,4 +1,30 @@
+#include "book/mirrored_book.hpp"
+#include "book/update_conflator.hpp"
+#include "config.h"
+#include "native/native_strategy.hpp"
+#include "pywrapper/pywrapper.hpp"
+
 #include <gtest/gtest.h>
+#include <pybind11/embed.h>
+
+#include <cstdint>
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using nutc::book::Level;
+using nutc::book::MirroredBook;
+using nutc::book::OrderBooks;
+using nutc::book::UpdateConflator;
+using nutc::messages::AccountUpdate;
+using nutc::messages::Match;
+using nutc::messages::ObUpdate;
+using nutc::native::NativeStrategy;
+using nutc::messages::SIDE;
 
 // Demonstrate some basic assertions.
 TEST(HelloTest, BasicAssertions)
@@ -9,3 +35,295 @@ TEST(HelloTest, BasicAssertions)
     // Expect equality.
     EXPECT_EQ(7 * 6, 42);
 }
+
+TEST(MirroredBookTest, KeepsLevelsBestFirst)
+{
+    MirroredBook book;
+    book.set_level(SIDE::BUY, 99, 1);
+    book.set_level(SIDE::BUY, 101, 2);
+    book.set_level(SIDE::BUY, 100, 3);
+    book.set_level(SIDE::SELL, 103, 4);
+    book.set_level(SIDE::SELL, 102, 5);
+
+    ASSERT_EQ(book.bids().size(), 3);
+    EXPECT_FLOAT_EQ(book.bids()[0].price, 101);
+    EXPECT_FLOAT_EQ(book.bids()[1].price, 100);
+    EXPECT_FLOAT_EQ(book.bids()[2].price, 99);
+    ASSERT_EQ(book.asks().size(), 2);
+    EXPECT_FLOAT_EQ(book.asks()[0].price, 102);
+    EXPECT_FLOAT_EQ(book.best_ask()->quantity, 5);
+    EXPECT_FLOAT_EQ(book.best_bid()->quantity, 2);
+}
+
+TEST(MirroredBookTest, ReplacesAndRemovesLevels)
+{
+    MirroredBook book;
+    book.set_level(SIDE::BUY, 100, 3);
+    book.set_level(SIDE::BUY, 100, 7);
+    ASSERT_EQ(book.bids().size(), 1);
+    EXPECT_FLOAT_EQ(book.bids()[0].quantity, 7);
+
+    book.set_level(SIDE::BUY, 100, 0);
+    EXPECT_TRUE(book.bids().empty());
+    EXPECT_FALSE(book.best_bid().has_value());
+    // Removing a level that isn't held changes nothing
+    book.set_level(SIDE::SELL, 100, 0);
+    EXPECT_TRUE(book.asks().empty());
+}
+
+TEST(MirroredBookTest, DropsWorstLevelsWhenFull)
+{
+    MirroredBook book;
+    const Level* storage = book.asks().data();
+    for (int i = 0; i < BOOK_MAX_LEVELS; i++)
+        book.set_level(SIDE::SELL, static_cast<float>(100 + i), 1);
+
+    // Worse than every level kept
+    book.set_level(SIDE::SELL, static_cast<float>(100 + BOOK_MAX_LEVELS), 1);
+    ASSERT_EQ(book.asks().size(), BOOK_MAX_LEVELS);
+    EXPECT_FLOAT_EQ(book.asks().back().price, 100 + BOOK_MAX_LEVELS - 1);
+
+    // Better than the worst, which makes way
+    book.set_level(SIDE::SELL, 50, 1);
+    ASSERT_EQ(book.asks().size(), BOOK_MAX_LEVELS);
+    EXPECT_FLOAT_EQ(book.asks().front().price, 50);
+    EXPECT_FLOAT_EQ(book.asks().back().price, 100 + BOOK_MAX_LEVELS - 2);
+
+    // Views point into storage that never moves
+    EXPECT_EQ(book.asks().data(), storage);
+}
+
+TEST(OrderBooksTest, AppliesLevelTotals)
+{
+    OrderBooks books;
+    books.apply(ObUpdate{"A", SIDE::BUY, 100, 1, 5});
+    books.apply(ObUpdate{"A", SIDE::BUY, 100, 2, 7});
+    books.apply(ObUpdate{"B", SIDE::SELL, 200, 3, 3});
+
+    ASSERT_EQ(books.get("A").bids().size(), 1);
+    EXPECT_FLOAT_EQ(books.get("A").bids()[0].quantity, 7);
+    EXPECT_FLOAT_EQ(books.get("B").best_ask()->quantity, 3);
+
+    books.apply(ObUpdate{"A", SIDE::BUY, 100, 0, 0});
+    EXPECT_TRUE(books.get("A").bids().empty());
+}
+
+TEST(OrderBooksTest, SnapshotReplacesEveryBook)
+{
+    OrderBooks books;
+    books.apply(ObUpdate{"A", SIDE::BUY, 100, 1, 1});
+    books.apply(ObUpdate{"B", SIDE::SELL, 200, 1, 1});
+    const MirroredBook* book_a = &books.get("A");
+
+    std::vector<ObUpdate> stale = books.clearing_updates();
+    ASSERT_EQ(stale.size(), 2);
+    for (const auto& update : stale)
+        EXPECT_FLOAT_EQ(update.level_quantity, 0);
+
+    books.reset({ObUpdate{"A", SIDE::SELL, 101, 4, 4}});
+    // Books Python may hold are kept, only emptied
+    EXPECT_EQ(&books.get("A"), book_a);
+    EXPECT_TRUE(books.get("A").bids().empty());
+    EXPECT_FLOAT_EQ(books.get("A").best_ask()->quantity, 4);
+    EXPECT_TRUE(books.get("B").asks().empty());
+}
+
+TEST(UpdateConflatorTest, KeepsLatestUpdatePerLevel)
+{
+    UpdateConflator conflator;
+    conflator.add(ObUpdate{"A", SIDE::BUY, 100, 5, 5});
+    conflator.add(ObUpdate{"A", SIDE::SELL, 100, 1, 1});
+    conflator.add(ObUpdate{"A", SIDE::BUY, 100, 2, 7});
+    conflator.add(ObUpdate{"B", SIDE::BUY, 100, 3, 3});
+    conflator.add(ObUpdate{"A", SIDE::BUY, 100, 0, 2});
+
+    std::vector<ObUpdate> delivered;
+    conflator.drain([&delivered](const ObUpdate& update) {
+        delivered.push_back(update);
+    });
+    // In the order the levels first changed, each as last sent
+    ASSERT_EQ(delivered.size(), 3);
+    EXPECT_EQ(delivered[0].security, "A");
+    EXPECT_EQ(delivered[0].side, SIDE::BUY);
+    EXPECT_FLOAT_EQ(delivered[0].quantity, 0);
+    EXPECT_FLOAT_EQ(delivered[0].level_quantity, 2);
+    EXPECT_EQ(delivered[1].side, SIDE::SELL);
+    EXPECT_EQ(delivered[2].security, "B");
+    EXPECT_EQ(conflator.conflated(), 2);
+}
+
+TEST(UpdateConflatorTest, DrainForgetsHeldUpdates)
+{
+    UpdateConflator conflator;
+    conflator.add(ObUpdate{"A", SIDE::BUY, 100, 5, 5});
+    size_t delivered = 0;
+    conflator.drain([&delivered](const ObUpdate&) { delivered++; });
+    conflator.drain([&delivered](const ObUpdate&) { delivered++; });
+    EXPECT_EQ(delivered, 1);
+
+    // A level drained already starts over
+    conflator.add(ObUpdate{"A", SIDE::BUY, 100, 1, 6});
+    conflator.drain([&delivered](const ObUpdate&) { delivered++; });
+    EXPECT_EQ(delivered, 2);
+    EXPECT_EQ(conflator.conflated(), 0);
+}
+
+class NativeStrategyTest : public ::testing::Test {
+protected:
+    struct Order {
+        SIDE side;
+        std::string ticker;
+        float quantity;
+        float price;
+    };
+
+    std::optional<NativeStrategy>
+    load(const std::string& shared_object)
+    {
+        auto place_order = [this](
+                               SIDE side,
+                               const std::string& ticker,
+                               float quantity,
+                               float price
+                           ) -> uint64_t {
+            orders.push_back({side, ticker, quantity, price});
+            return orders.size();
+        };
+        auto get_book = [this](const std::string& ticker) { return &books.get(ticker); };
+        return NativeStrategy::load(shared_object, "ABC", place_order, get_book);
+    }
+
+    // memfds the strategy was loaded from that are still open
+    static size_t
+    open_memfds()
+    {
+        size_t count = 0;
+        for (const auto& entry : std::filesystem::directory_iterator("/proc/self/fd")) {
+            std::error_code err;
+            std::string target = std::filesystem::read_symlink(entry, err).string();
+            if (target.find("nutc_strategy_ABC") != std::string::npos)
+                count++;
+        }
+        return count;
+    }
+
+    static std::string
+    read_test_strategy()
+    {
+        std::ifstream file(NUTC_TEST_STRATEGY, std::ios::binary);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    OrderBooks books;
+    std::vector<Order> orders;
+};
+
+TEST_F(NativeStrategyTest, LoadsSharedObjectAndCallsIt)
+{
+    std::string shared_object = read_test_strategy();
+    ASSERT_TRUE(nutc::native::is_shared_object(shared_object));
+    std::optional<NativeStrategy> strategy = load(shared_object);
+    ASSERT_TRUE(strategy.has_value());
+    EXPECT_EQ(strategy->get_uid(), "ABC");
+
+    // Level updates carry the level total
+    ObUpdate update{"A", SIDE::SELL, 101, 2, 5};
+    books.apply(update);
+    strategy->on_orderbook_update(update);
+    ASSERT_EQ(orders.size(), 1);
+    EXPECT_EQ(orders[0].side, SIDE::SELL);
+    EXPECT_EQ(orders[0].ticker, "A");
+    EXPECT_FLOAT_EQ(orders[0].quantity, 5);
+    EXPECT_FLOAT_EQ(orders[0].price, 101);
+
+    // And the strategy reads its mirrored book
+    strategy->on_trade_update(Match{"A", "DEF", "ABC", SIDE::SELL, 101, 1});
+    ASSERT_EQ(orders.size(), 2);
+    EXPECT_FLOAT_EQ(orders[1].quantity, 5);
+    EXPECT_FLOAT_EQ(orders[1].price, 101);
+
+    strategy->on_account_update(AccountUpdate{900, "A", SIDE::BUY, 101, 1});
+    ASSERT_EQ(orders.size(), 3);
+    EXPECT_FLOAT_EQ(orders[2].quantity, 900);
+
+    // Still callable once moved
+    NativeStrategy moved = std::move(strategy.value());
+    strategy.reset();
+    moved.on_orderbook_update(update);
+    EXPECT_EQ(orders.size(), 4);
+}
+
+TEST_F(NativeStrategyTest, KeepsMemfdOpenWhileLoaded)
+{
+    {
+        std::optional<NativeStrategy> strategy = load(read_test_strategy());
+        ASSERT_TRUE(strategy.has_value());
+        EXPECT_EQ(open_memfds(), 1);
+    }
+    EXPECT_EQ(open_memfds(), 0);
+}
+
+TEST_F(NativeStrategyTest, RefusesObjectsItCannotLoad)
+{
+    EXPECT_FALSE(nutc::native::is_shared_object("class Strategy: pass"));
+    EXPECT_FALSE(load(std::string("\x7f" "ELF") + "not really").has_value());
+}
+
+TEST(PyWrapperTest, TemplateStubDoesNotShadowPlaceMarketOrder)
+{
+    pybind11::scoped_interpreter guard{};
+    struct Order {
+        std::string uid;
+        std::string side;
+        std::string ticker;
+        float quantity;
+        float price;
+    };
+    std::vector<Order> orders;
+    nutc::pywrapper::create_api_module(
+        [&orders](
+            const std::string& uid,
+            const std::string& side,
+            const std::string& ticker,
+            float quantity,
+            float price
+        ) -> uint64_t {
+            orders.push_back({uid, side, ticker, quantity, price});
+            return orders.size();
+        },
+        [](const std::string&, const std::string&) -> MirroredBook* { return nullptr; },
+        [](const std::string&) -> uint64_t { return 0; }
+    );
+
+    // Submissions start from template.py, stub included
+    std::string algo = R"(
+def place_market_order(side: str, ticker: str, quantity: float, price: float) -> None:
+    """Place a market order - DO NOT MODIFY"""
+
+class Strategy:
+    def __init__(self) -> None:
+        place_market_order("BUY", "A", 1, 100)
+
+    def on_trade_update(self, ticker, side, price, quantity) -> None:
+        pass
+
+    def on_orderbook_update(self, ticker, side, price, quantity) -> None:
+        pass
+
+    def on_account_update(self, ticker, side, price, quantity, capital) -> None:
+        pass
+)";
+    {
+        auto strategy = nutc::pywrapper::run_code_init(algo, "ABC");
+        ASSERT_TRUE(strategy.has_value());
+    }
+
+    ASSERT_EQ(orders.size(), 1);
+    EXPECT_EQ(orders.at(0).uid, "ABC");
+    EXPECT_EQ(orders.at(0).side, "BUY");
+    EXPECT_EQ(orders.at(0).ticker, "A");
+    EXPECT_FLOAT_EQ(orders.at(0).quantity, 1);
+    EXPECT_FLOAT_EQ(orders.at(0).price, 100);
+}
@@ -0,0 +1,86 @@
+// A native strategy for the loader tests: every callback places an order describing
+// what it was called with
+
+#include "native/nutc_strategy.h"
+
+namespace {
+struct TestStrategy {
+    const nutc_host* host;
+};
+
+void
+place(void* strategy, nutc_side side, const char* ticker, float quantity, float price)
+{
+    const nutc_host* host = static_cast<TestStrategy*>(strategy)->host;
+    host->place_order(host->host_context, side, ticker, quantity, price);
+}
+} // namespace
+
+extern "C" {
+
+uint32_t
+nutc_strategy_abi_version(void)
+{
+    return NUTC_STRATEGY_ABI_VERSION;
+}
+
+void*
+nutc_strategy_init(const nutc_host* host)
+{
+    return new TestStrategy{host};
+}
+
+void
+nutc_strategy_on_orderbook_update(
+    void* strategy, const char* ticker, nutc_side side, float price, float quantity
+)
+{
+    place(strategy, side, ticker, quantity, price);
+}
+
+// Orders the level total at the level's price, so on_orderbook_update is never used
+void
+nutc_strategy_on_level_update(
+    void* strategy,
+    const char* ticker,
+    nutc_side side,
+    float price,
+    float /* quantity */,
+    float level_quantity
+)
+{
+    place(strategy, side, ticker, level_quantity, price);
+}
+
+// Orders the best level of the mirrored book on the trade's side
+void
+nutc_strategy_on_trade_update(
+    void* strategy, const char* ticker, nutc_side side, float /* price */,
+    float /* quantity */
+)
+{
+    const nutc_host* host = static_cast<TestStrategy*>(strategy)->host;
+    nutc_level best{};
+    if (host->get_levels(host->host_context, ticker, side, &best, 1) == 1)
+        place(strategy, side, ticker, best.quantity, best.price);
+}
+
+void
+nutc_strategy_on_account_update(
+    void* strategy,
+    const char* ticker,
+    nutc_side side,
+    float /* price */,
+    float /* quantity */,
+    float capital_remaining
+)
+{
+    place(strategy, side, ticker, capital_remaining, 0);
+}
+
+void
+nutc_strategy_destroy(void* strategy)
+{
+    delete static_cast<TestStrategy*>(strategy);
+}
+}